@@ -0,0 +1,110 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "rlvm.h"
+#include "bcode.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/*
+ * Number of VM instances interpreted in lockstep. The registers are
+ * stored as iregs[reg][lane] so one instruction is one loop over a
+ * row which the compiler turns into vector operations.
+ */
+#define BATCH_LANES 64
+
+/* Integers an input line of exec_inputs can hold (r0 to r7) */
+#define BATCH_INPUTS 8
+
+/**
+ * A batch runs the same bytecode over up to BATCH_LANES different
+ * inputs. Lanes that take different sides of a branch are masked
+ * off and the lanes with the lowest instruction pointer run first,
+ * so they meet again after the branch. A lane that reaches anything
+ * the batch interpreter does not handle (exceptions, I/O, ...) is
+ * moved to a regular VM and finished there.
+ */
+typedef struct rlvm_batch_t
+{
+  uint64_t lanes;		/* Instances in use */
+  uint64_t stack_size;		/* Call stack size of every lane */
+  uint64_t handler_size;	/* Exception stack size of every lane */
+  char *ropool;			/* Readonly pool */
+  uint64_t ip[BATCH_LANES];	/* Instruction pointers */
+  uint64_t sp[BATCH_LANES];	/* Call stack pointers */
+  status_t state[BATCH_LANES];	/* Return value of each lane */
+  uint64_t iregs[ALLOC_REGS_COUNT][BATCH_LANES];	/* Integer registers */
+  double fregs[ALLOC_REGS_COUNT][BATCH_LANES];	/* Float point registers */
+  uint64_t *stack;		/* Call stacks, [slot * BATCH_LANES + lane] */
+  FILE *fin;			/* What the program sees as stdin */
+  FILE *fout;			/* What the program sees as stdout */
+  FILE *ferr;			/* What the program sees as stderr */
+  const struct native_t *natives;	/* Slots NCALL reaches */
+  uint64_t native_count;	/* Number of slots */
+  bool buffered;		/* Lanes write to lane_buf instead of fout */
+  char *lane_buf[BATCH_LANES];	/* Output of each lane, NULL if none */
+  size_t lane_len[BATCH_LANES];	/* Bytes in lane_buf */
+} rlvm_batch_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  extern bool init_batch (rlvm_batch_t * batch, uint64_t lanes,
+			  uint64_t stack_size, uint64_t handler_size,
+			  char *pool);
+
+  extern void clean_batch (rlvm_batch_t * batch);
+
+  extern void exec_batch (rlvm_batch_t * batch, const uint64_t len,
+			  opcode_t * ops);
+
+  /**
+   * Runs code once per line of in, each line holding up to
+   * BATCH_INPUTS integers that go into r0 onwards of an instance
+   * starting at address 0. Writes one line per input to out: the value
+   * it halted with or the state it faulted with. With lockstep set the
+   * inputs go through exec_batch BATCH_LANES at a time, otherwise each
+   * one gets its own exec_bytecode (which is what lockstep is measured
+   * against). Either way the output a program writes comes right
+   * before the line of its input. Returns non-zero if a line is not
+   * made of integers.
+   */
+  extern int exec_inputs (bcode_t * code, FILE * in, FILE * out,
+			  bool lockstep);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__BATCH_H__ */
@@ -30,6 +30,8 @@
 #endif /* !_DEFAULT_SOURCE */
 
 #include "rlvm.h"
+#include "vector.h"
+#include "native.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -45,6 +47,12 @@
  * For big endian, it would be 0xDF and 0xD0 for little endian. The
  * endianess determines how the fields would be represented; in other
  * words, the endianess of the binary file.
+ *
+ * The pool is followed by the import table: its size and the names
+ * NCALL refers to, NUL terminated and in slot order. Then comes the
+ * export table: its size and, for every .GLOBAL text label, its
+ * address as a uint64_t followed by its NUL terminated name. Files
+ * that end early have no imports or no exports.
  */
 
 typedef struct bcode_t
@@ -56,6 +64,12 @@ typedef struct bcode_t
   uint64_t code_size;
   opcode_t *code;
   char *ropool;
+  uint64_t imports_size;
+  char *imports;
+  native_t *natives;		/* Imports bound by link_natives */
+  uint64_t native_count;
+  uint64_t exports_size;
+  char *exports;
 } bcode_t;
 
 /**
@@ -178,6 +192,239 @@ typedef struct bcode_t
     }						\
   }
 
+/**
+ * Sets irRes to the length of the NUL terminated string at irStr
+ */
+#define RLVM_STRLEN(irRes, irStr)		\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irStr,				\
+      .rt = 0,					\
+      .rd = irRes,				\
+      .sa = 0,					\
+      .fn = 4					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the first irByte in irLen bytes at irBuf, or 0
+ */
+#define RLVM_MEMCHR(irRes, irBuf, irByte, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irByte,				\
+      .rd = irRes,				\
+      .sa = irLen,				\
+      .fn = 5					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the last irByte in irLen bytes at irBuf, or 0
+ */
+#define RLVM_MEMRCHR(irRes, irBuf, irByte, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irByte,				\
+      .rd = irRes,				\
+      .sa = irLen,				\
+      .fn = 6					\
+    }						\
+  }
+
+/**
+ * Compares the strings at irA and irB, irRes is -1, 0 or 1
+ */
+#define RLVM_STRCMP(irRes, irA, irB)		\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irA,				\
+      .rt = irB,				\
+      .rd = irRes,				\
+      .sa = 0,					\
+      .fn = 7					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the first occurrence of string irNeedle in string irHay,
+ * or 0
+ */
+#define RLVM_STRSTR(irRes, irHay, irNeedle)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irHay,				\
+      .rt = irNeedle,				\
+      .rd = irRes,				\
+      .sa = 0,					\
+      .fn = 8					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the first occurrence of the needle at irNeedle in
+ * irHayLen bytes at irHay, or 0. irRes holds the needle length on entry
+ */
+#define RLVM_MEMMEM(irRes, irHay, irHayLen, irNeedle)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irHay,				\
+      .rt = irHayLen,				\
+      .rd = irRes,				\
+      .sa = irNeedle,				\
+      .fn = 9					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the length of the longest valid UTF-8 prefix of irLen
+ * bytes at irBuf (irLen if all of it is valid)
+ */
+#define RLVM_UTF8CHK(irRes, irBuf, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irLen,				\
+      .rd = irRes,				\
+      .sa = 0,					\
+      .fn = 10					\
+    }						\
+  }
+
+/**
+ * Continues the CRC32C in irCrc with irLen bytes at irBuf
+ */
+#define RLVM_CRC32C(irCrc, irBuf, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irLen,				\
+      .rd = irCrc,				\
+      .sa = 0,					\
+      .fn = 11					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the XXH64 hash of irLen bytes at irBuf with the seed in
+ * irSeed (which may be irRes itself to chain fields)
+ */
+#define RLVM_HASH(irRes, irBuf, irLen, irSeed)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irLen,				\
+      .rd = irRes,				\
+      .sa = irSeed,				\
+      .fn = 12					\
+    }						\
+  }
+
+/**
+ * Starts the hash state (80 bytes, see hash.h) at irState
+ */
+#define RLVM_HASHINIT(irState, irSeed)		\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irState,				\
+      .rt = irSeed,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = 13					\
+    }						\
+  }
+
+/**
+ * Feeds irLen bytes at irBuf to the hash state at irState
+ */
+#define RLVM_HASHUPD(irState, irBuf, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irState,				\
+      .rt = irBuf,				\
+      .rd = 0,					\
+      .sa = irLen,				\
+      .fn = 14					\
+    }						\
+  }
+
+/**
+ * Sets irRes to the hash of the bytes fed to the state at irState
+ */
+#define RLVM_HASHFIN(irRes, irState)		\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irState,				\
+      .rt = 0,					\
+      .rd = irRes,				\
+      .sa = 0,					\
+      .fn = 15					\
+    }						\
+  }
+
+/**
+ * Splits the irBuf, irBuf + 1 (address, length) bytes into fields
+ * written to irOut, irOut + 1 (address, capacity), see csv.h. irRes
+ * gets the field count and irRes + 1 the bytes scanned.
+ */
+#define RLVM_CSVSCAN(irRes, irBuf, irOut, irDialect)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irOut,				\
+      .rd = irRes,				\
+      .sa = irDialect,				\
+      .fn = 16					\
+    }						\
+  }
+
+/**
+ * Parses irLen bytes at irBuf as a decimal int into irRes, irOk is
+ * set to whether they were one
+ */
+#define RLVM_PARSEINT(irRes, irBuf, irLen, irOk)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irLen,				\
+      .rd = irRes,				\
+      .sa = irOk,				\
+      .fn = 17					\
+    }						\
+  }
+
+/**
+ * Parses irLen bytes at irBuf as a double into frRes, irOk is set to
+ * whether they were one
+ */
+#define RLVM_PARSEFLT(frRes, irBuf, irLen, irOk)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irBuf,				\
+      .rt = irLen,				\
+      .rd = frRes,				\
+      .sa = irOk,				\
+      .fn = 18					\
+    }						\
+  }
+
 /**
  * Move from int register to float register
  */
@@ -331,6 +578,21 @@ typedef struct bcode_t
     }						\
   }
 
+/**
+ * Selects the register reduced by the next PARFOR
+ */
+#define RLVM_PRED(reg, mode, op)		\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 0,				\
+      .rs = reg,				\
+      .rt = mode,				\
+      .rd = 0,					\
+      .sa = op,					\
+      .fn = 10					\
+    }						\
+  }
+
 /**
  * int registers related math
  */
@@ -566,108 +828,340 @@ typedef struct bcode_t
   }
 
 /**
- * Load integer immediate to int register
+ * float registers math mapped to the hardware or libm
  */
-#define RLVM_IRLDI(irDst, lshCount, imm)	\
+#define RLVM_SQRTF(frDst, frSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 3,				\
-      .rs = irDst,				\
-      .rt = lshCount,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 5					\
     }						\
   }
 
 /**
- * Add integer immediate to int register
+ * frDst = frLhs * frRhs + frAdd rounded once
  */
-#define RLVM_ADDI(irDst, irLhs, imm)		\
+#define RLVM_FMAF(frDst, frLhs, frRhs, frAdd)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 4,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .rd = frDst,				\
+      .sa = frAdd,				\
+      .fn = 6					\
     }						\
   }
 
-/**
- * Subtract integer immediate from int register
- */
-#define RLVM_SUBI(irDst, irLhs, imm)		\
+#define RLVM_ABSF(frDst, frSrc)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 5,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 7					\
     }						\
   }
 
-/**
- * Multiply integer immediate from int register
- */
-#define RLVM_MULI(irDst, irLhs, imm)		\
+#define RLVM_MINF(frDst, frLhs, frRhs)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 6,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 8					\
     }						\
   }
 
-/**
- * Divide integer immediate from int register
- */
-#define RLVM_DIVI(irDst, irLhs, imm)		\
+#define RLVM_MAXF(frDst, frLhs, frRhs)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 7,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 9					\
     }						\
   }
 
-/**
- * Remainder of integer immediate and int register
- */
-#define RLVM_MODI(irDst, irLhs, imm)		\
+#define RLVM_FLOORF(frDst, frSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 8,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 10					\
     }						\
   }
 
-/**
- * Bitwise and of integer immediate and int register
- */
-#define RLVM_ANDI(irDst, irLhs, imm)		\
+#define RLVM_CEILF(frDst, frSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 9,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 11					\
     }						\
   }
 
-/**
- * Bitwise or of integer immediate and int register
- */
-#define RLVM_ORI(irDst, irLhs, imm)		\
+#define RLVM_ROUNDF(frDst, frSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 10,				\
-      .rs = irDst,				\
-      .rt = irLhs,				\
-      .immediate = imm				\
-    }						\
-  }
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 12					\
+    }						\
+  }
+
+#define RLVM_EXPF(frDst, frSrc)			\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 13					\
+    }						\
+  }
+
+#define RLVM_LOGF(frDst, frSrc)			\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 14					\
+    }						\
+  }
+
+#define RLVM_POWF(frDst, frLhs, frRhs)		\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 15					\
+    }						\
+  }
+
+#define RLVM_SINF(frDst, frSrc)			\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 16					\
+    }						\
+  }
+
+#define RLVM_COSF(frDst, frSrc)			\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frSrc,				\
+      .rt = 0,					\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 17					\
+    }						\
+  }
+
+#define RLVM_ATAN2F(frDst, frLhs, frRhs)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 2,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .rd = frDst,				\
+      .sa = 0,					\
+      .fn = 18					\
+    }						\
+  }
+
+/**
+ * Load integer immediate to int register
+ */
+#define RLVM_IRLDI(irDst, lshCount, imm)	\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 3,				\
+      .rs = irDst,				\
+      .rt = lshCount,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Load 64-bit constant in pool slot kSlot to int register
+ */
+#define RLVM_LDK(irDst, kSlot)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 45,				\
+      .rs = irDst,				\
+      .rt = (kSlot) >> 16 & 0xF,		\
+      .immediate = (kSlot) & 0xFFFF		\
+    }						\
+  }
+
+/**
+ * Load 64-bit constant in pool slot kSlot to float register
+ */
+#define RLVM_LDKF(frDst, kSlot)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 45,				\
+      .rs = frDst,				\
+      .rt = RLVM_LDK_FP | ((kSlot) >> 16 & 0xF),	\
+      .immediate = (kSlot) & 0xFFFF		\
+    }						\
+  }
+
+/**
+ * Loads or stores rData at irBase + (irIdx << lgScale) + disp * size
+ * (see RLVM_HX_FP and RLVM_HX_ST). Bits 0-1 of mode are log2 of size
+ */
+#define RLVM_HX(mode, rData, irBase, irIdx, lgScale, disp)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 46,				\
+      .rs = irBase,				\
+      .rt = irIdx,				\
+      .rd = rData,				\
+      .sa = (disp) & 0x1F,			\
+      .fn = (mode) | (lgScale) << 2		\
+    }						\
+  }
+
+/**
+ * Loads or stores rData at irBase, then adds step elements to irBase.
+ * mode is the size and flags of RLVM_HX plus RLVM_SM_POST
+ */
+#define RLVM_SM(mode, rData, irBase, step)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 47,				\
+      .rs = irBase,				\
+      .rt = 0,					\
+      .rd = rData,				\
+      .sa = (step) & 0x1F,			\
+      .fn = mode				\
+    }						\
+  }
+
+/**
+ * Add integer immediate to int register
+ */
+#define RLVM_ADDI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 4,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Subtract integer immediate from int register
+ */
+#define RLVM_SUBI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 5,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Multiply integer immediate from int register
+ */
+#define RLVM_MULI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 6,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Divide integer immediate from int register
+ */
+#define RLVM_DIVI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 7,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Remainder of integer immediate and int register
+ */
+#define RLVM_MODI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 8,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Bitwise and of integer immediate and int register
+ */
+#define RLVM_ANDI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 9,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
+
+/**
+ * Bitwise or of integer immediate and int register
+ */
+#define RLVM_ORI(irDst, irLhs, imm)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 10,				\
+      .rs = irDst,				\
+      .rt = irLhs,				\
+      .immediate = imm				\
+    }						\
+  }
 
 /**
  * Bitwise xor of integer immediate and int register
@@ -694,525 +1188,1130 @@ typedef struct bcode_t
   }
 
 /**
- * Jumps to a code address
+ * Sets int register to the stack pointer, marking a frame for TAILCALL
+ */
+#define RLVM_MARK(ireg)				\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 0,				\
+      .rs = 0,					\
+      .rt = 0,					\
+      .rd = ireg,				\
+      .sa = 0,					\
+      .fn = 11					\
+    }						\
+  }
+
+/**
+ * Jumps to a code address without pushing a return address. If frame
+ * is set, the stack is first cut back to the mark in int register.
+ */
+#define RLVM_TAILCALL(ireg, frame, addr)	\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 52,				\
+      .rs = ireg,				\
+      .rt = frame,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Pushes (or with restore set, pops) the registers picked by the mask
+ * in pool slot
+ */
+#define RLVM_SAVE(restore, slot)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 53,				\
+      .rs = restore,				\
+      .rt = (slot) >> 16 & 0xF,			\
+      .immediate = (slot) & 0xFFFF		\
+    }						\
+  }
+
+/**
+ * Accesses the stack word at a signed offset from the mark in irBase
+ */
+#define RLVM_FRAME(mode, reg, irBase, off)	\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 54,				\
+      .rs = irBase,				\
+      .rt = reg,				\
+      .immediate = (mode) << 14 | ((off) & 0x3FFF)	\
+    }						\
+  }
+
+/**
+ * Jumps to a code address
+ */
+#define RLVM_JMP(addr)				\
+  (opcode_t) {					\
+    .tvar = (op_tvar_t) {			\
+      .opcode = 13,				\
+      .target = addr				\
+    }						\
+  }
+
+/**
+ * Returns from a subroutine. Return value is
+ * passed through the stack!
+ */
+#define RLVM_RET()				\
+  (opcode_t) {					\
+    .tvar = (op_tvar_t) {			\
+      .opcode = 14,				\
+      .target = 0,				\
+    }						\
+  }
+
+/**
+ * Jump if int registers equal
+ */
+#define RLVM_JE(irLhs, irRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 15,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Jump if int registers are less
+ */
+#define RLVM_JL(irLhs, irRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 16,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Decrement int register, jump if it is not zero afterwards
+ */
+#define RLVM_DBNZ(ireg, addr)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 48,				\
+      .rs = ireg,				\
+      .rt = 0,					\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Jump through the jump table at pool offset tbl, indexed by int
+ * register (out of range indices go to the default target)
+ */
+#define RLVM_SWITCH(ireg, tbl)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 51,				\
+      .rs = ireg,				\
+      .rt = 0,					\
+      .immediate = tbl				\
+    }						\
+  }
+
+/**
+ * Jump if int registers are greater
+ */
+#define RLVM_JG(irLhs, irRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 17,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Jump if signed int registers are less
+ */
+#define RLVM_JLS(irLhs, irRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 18,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Jump if signed int registers are greater
+ */
+#define RLVM_JGS(irLhs, irRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 19,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Jump if float registers equal
+ */
+#define RLVM_JFE(frLhs, frRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 20,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .immediate = addr,			\
+    }						\
+  }
+
+/**
+ * Jump if float registers are less
+ */
+#define RLVM_JFL(frLhs, frRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 21,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .immediate = addr,			\
+    }						\
+  }
+
+/**
+ * Jump if float registers are greater
+ */
+#define RLVM_JFG(frLhs, frRhs, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 22,				\
+      .rs = frLhs,				\
+      .rt = frRhs,				\
+      .immediate = addr,			\
+    }						\
+  }
+
+/**
+ * Jumps to an offset
+ */
+#define RLVM_JOF(addr)				\
+  (opcode_t) {					\
+    .tvar = (op_tvar_t) {			\
+      .opcode = 23,				\
+      .target = addr				\
+    }						\
+  }
+
+/**
+ * Jump to int register
+ */
+#define RLVM_JIR(irVal, lsh, immOff)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 24,				\
+      .rs = irVal,				\
+      .rt = lsh,				\
+      .immediate = immOff,			\
+    }						\
+  }
+
+/**
+ * Jump if float register is zero
+ */
+#define RLVM_JFRZ(freg, addr)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 25,				\
+      .rs = freg,				\
+      .rt = 1,					\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Jump if int register is zero
+ */
+#define RLVM_JIRZ(ireg, addr)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 25,				\
+      .rs = ireg,				\
+      .rt = 0,					\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Install new exception handler
+ */
+#define RLVM_INEH(addr)				\
+  (opcode_t) {					\
+    .tvar = (op_tvar_t) {			\
+      .opcode = 26,				\
+      .target = addr				\
+    }						\
+  }
+
+/**
+ * Loads from stack to int register
+ */
+#define RLVM_IRLD(ireg, offset)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 27,				\
+      .rs = 0,					\
+      .rt = ireg,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Load bits from stack to float register
+ */
+#define RLVM_FRLD(freg, offset)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 27,				\
+      .rs = 1,					\
+      .rt = freg,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Store int register to stack
+ */
+#define RLVM_IRST(ireg, offset)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 27,				\
+      .rs = 2,					\
+      .rt = ireg,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Store float register to stack
+ */
+#define RLVM_FRST(freg, offset)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 27,				\
+      .rs = 3,					\
+      .rt = freg,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Store float register bits to stack
+ */
+#define RLVM_FBST(freg, offset)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 27,				\
+      .rs = 4,					\
+      .rt = freg,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Allocate bytes on the heap
+ */
+#define RLVM_ALLOCI(ireg, size)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 28,				\
+      .rs = 0,					\
+      .rt = ireg,				\
+      .immediate = size				\
+    }						\
+  }
+
+#define RLVM_IRALLOC(ireg, irSize)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 28,				\
+      .rs = irSize,				\
+      .rt = ireg,				\
+      .immediate = 0				\
+    }						\
+  }
+
+/**
+ * Free bytes on the heap
+ */
+#define RLVM_FREE(ireg)				\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 29,				\
+      .rs = 0,					\
+      .rt = ireg,				\
+      .immediate = 0,				\
+    }						\
+  }
+
+/**
+ * Loads a byte (8 bit) on the heap
+ */
+#define RLVM_LDB(irDst, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 30,				\
+      .rs = irBase,				\
+      .rt = irDst,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Loads a word (16 bit) on the heap
+ */
+#define RLVM_LDW(irDst, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 31,				\
+      .rs = irBase,				\
+      .rt = irDst,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Loads a double (32 bit) on the heap
+ */
+#define RLVM_LDD(irDst, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 32,				\
+      .rs = irBase,				\
+      .rt = irDst,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Loads a quad (64 bit) on the heap
+ */
+#define RLVM_LDQ(irDst, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 33,				\
+      .rs = irBase,				\
+      .rt = irDst,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Stores a byte (8 bit) on the heap
+ */
+#define RLVM_STB(irSrc, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 34,				\
+      .rs = irBase,				\
+      .rt = irSrc,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Stores a word (16 bit) on the heap
+ */
+#define RLVM_STW(irSrc, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 35,				\
+      .rs = irBase,				\
+      .rt = irSrc,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Stores a double (32 bit) on the heap
+ */
+#define RLVM_STD(irSrc, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 36,				\
+      .rs = irBase,				\
+      .rt = irSrc,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Stores a quad (64 bit) on the heap
+ */
+#define RLVM_STQ(irSrc, irBase, offset)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 37,				\
+      .rs = irBase,				\
+      .rt = irSrc,				\
+      .immediate = offset			\
+    }						\
+  }
+
+/**
+ * Skip compare: int registers are equal
+ */
+#define RLVM_SIREQ(ir1, ir2)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 38,				\
+      .rs = ir1,				\
+      .rt = ir2,				\
+      .immediate = 0				\
+    }						\
+  }
+
+/**
+ * Skip compare: float registers are equal
+ */
+#define RLVM_SFREQ(fr1, fr2)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 38,				\
+      .rs = fr1,				\
+      .rt = fr2,				\
+      .immediate = 0 | 8			\
+    }						\
+  }
+
+/**
+ * Skip compare: int registers are less
+ */
+#define RLVM_SIRL(ir1, ir2)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 38,				\
+      .rs = ir1,				\
+      .rt = ir2,				\
+      .immediate = 1				\
+    }						\
+  }
+
+/**
+ * Skip compare: signed int registers are less
+ */
+#define RLVM_SIRSL(ir1, ir2)			\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 38,				\
+      .rs = ir1,				\
+      .rt = ir2,				\
+      .immediate = 1 | 4			\
+    }						\
+  }
+
+/**
+ * Skip compare: float registers are less
  */
-#define RLVM_JMP(addr)				\
+#define RLVM_SFRL(fr1, fr2)			\
   (opcode_t) {					\
-    .tvar = (op_tvar_t) {			\
-      .opcode = 13,				\
-      .target = addr				\
+    .svar = (op_svar_t) {			\
+      .opcode = 38,				\
+      .rs = fr1,				\
+      .rt = fr2,				\
+      .immediate = 1 | 8			\
     }						\
   }
 
 /**
- * Returns from a subroutine. Return value is
- * passed through the stack!
+ * Skip compare: int registers are more
  */
-#define RLVM_RET()				\
+#define RLVM_SIRG(ir1, ir2)			\
   (opcode_t) {					\
-    .tvar = (op_tvar_t) {			\
-      .opcode = 14,				\
-      .target = 0,				\
+    .svar = (op_svar_t) {			\
+      .opcode = 38,				\
+      .rs = ir1,				\
+      .rt = ir2,				\
+      .immediate = 2				\
     }						\
   }
 
 /**
- * Jump if int registers equal
+ * Skip compare: signed int registers are more
  */
-#define RLVM_JE(irLhs, irRhs, addr)		\
+#define RLVM_SIRSG(ir1, ir2)			\
   (opcode_t) {					\
     .svar = (op_svar_t) {			\
-      .opcode = 15,				\
-      .rs = irLhs,				\
-      .rt = irRhs,				\
-      .immediate = addr				\
+      .opcode = 38,				\
+      .rs = ir1,				\
+      .rt = ir2,				\
+      .immediate = 2 | 4			\
     }						\
   }
 
 /**
- * Jump if int registers are less
+ * Skip compare: float registers are more
  */
-#define RLVM_JL(irLhs, irRhs, addr)		\
+#define RLVM_SFRG(fr1, fr2)			\
   (opcode_t) {					\
     .svar = (op_svar_t) {			\
-      .opcode = 16,				\
-      .rs = irLhs,				\
-      .rt = irRhs,				\
-      .immediate = addr				\
+      .opcode = 38,				\
+      .rs = fr1,				\
+      .rt = fr2,				\
+      .immediate = 2 | 8			\
     }						\
   }
 
 /**
- * Jump if int registers are greater
+ * Skip compare: int register is zero
  */
-#define RLVM_JG(irLhs, irRhs, addr)		\
+#define RLVM_SIRZ(ireg)				\
   (opcode_t) {					\
     .svar = (op_svar_t) {			\
-      .opcode = 17,				\
-      .rs = irLhs,				\
-      .rt = irRhs,				\
-      .immediate = addr				\
+      .opcode = 38,				\
+      .rs = ireg,				\
+      .rt = 0,					\
+      .immediate = 3				\
     }						\
   }
 
 /**
- * Jump if signed int registers are less
+ * Skip compare: float register is zero
  */
-#define RLVM_JLS(irLhs, irRhs, addr)		\
+#define RLVM_SFRZ(freg)				\
   (opcode_t) {					\
     .svar = (op_svar_t) {			\
-      .opcode = 18,				\
-      .rs = irLhs,				\
-      .rt = irRhs,				\
-      .immediate = addr				\
+      .opcode = 38,				\
+      .rs = freg,				\
+      .rt = 0,					\
+      .immediate = 3 | 8			\
     }						\
   }
 
 /**
- * Jump if signed int registers are greater
+ * Sets int register to 1 if the compare (RLVM_CC_*) holds, 0 otherwise
  */
-#define RLVM_JGS(irLhs, irRhs, addr)		\
+#define RLVM_SETCC(flag, irDst, rLhs, rRhs)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 19,				\
-      .rs = irLhs,				\
-      .rt = irRhs,				\
-      .immediate = addr				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 49,				\
+      .rs = rLhs,				\
+      .rt = rRhs,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_CC_SET | (flag)		\
     }						\
   }
 
 /**
- * Jump if float registers equal
+ * Moves int register if the compare (RLVM_CC_*) holds
  */
-#define RLVM_JFE(frLhs, frRhs, addr)		\
+#define RLVM_CMOV(flag, irDst, rLhs, rRhs, irSrc)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 20,				\
-      .rs = frLhs,				\
-      .rt = frRhs,				\
-      .immediate = addr,			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 49,				\
+      .rs = rLhs,				\
+      .rt = rRhs,				\
+      .rd = irDst,				\
+      .sa = irSrc,				\
+      .fn = RLVM_CC_MOV | (flag)		\
     }						\
   }
 
 /**
- * Jump if float registers are less
+ * Moves float register if the compare (RLVM_CC_*) holds
  */
-#define RLVM_JFL(frLhs, frRhs, addr)		\
+#define RLVM_CMOVF(flag, frDst, rLhs, rRhs, frSrc)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 21,				\
-      .rs = frLhs,				\
-      .rt = frRhs,				\
-      .immediate = addr,			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 49,				\
+      .rs = rLhs,				\
+      .rt = rRhs,				\
+      .rd = frDst,				\
+      .sa = frSrc,				\
+      .fn = RLVM_CC_MOVF | (flag)		\
     }						\
   }
 
 /**
- * Jump if float registers are greater
+ * Selects between int registers by an int register being non-zero
  */
-#define RLVM_JFG(frLhs, frRhs, addr)		\
+#define RLVM_SELECT(irDst, irCond, irTrue, irFalse)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 22,				\
-      .rs = frLhs,				\
-      .rt = frRhs,				\
-      .immediate = addr,			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 49,				\
+      .rs = irTrue,				\
+      .rt = irFalse,				\
+      .rd = irDst,				\
+      .sa = irCond,				\
+      .fn = RLVM_CC_SELECT			\
     }						\
   }
 
 /**
- * Jumps to an offset
+ * Selects between float registers by an int register being non-zero
  */
-#define RLVM_JOF(addr)				\
+#define RLVM_FSELECT(frDst, irCond, frTrue, frFalse)	\
   (opcode_t) {					\
-    .tvar = (op_tvar_t) {			\
-      .opcode = 23,				\
-      .target = addr				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 49,				\
+      .rs = frTrue,				\
+      .rt = frFalse,				\
+      .rd = frDst,				\
+      .sa = irCond,				\
+      .fn = RLVM_CC_SELECT | RLVM_CC_FP		\
     }						\
   }
 
 /**
- * Jump to int register
+ * Counts the set bits of int register
  */
-#define RLVM_JIR(irVal, lsh, immOff)		\
+#define RLVM_POPCNT(irDst, irSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 24,				\
-      .rs = irVal,				\
-      .rt = lsh,				\
-      .immediate = immOff,			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irSrc,				\
+      .rt = 0,					\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_POPCNT			\
     }						\
   }
 
 /**
- * Jump if float register is zero
+ * Counts the leading zero bits of int register (64 for zero)
  */
-#define RLVM_JFRZ(freg, addr)			\
+#define RLVM_CLZ(irDst, irSrc)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 25,				\
-      .rs = freg,				\
-      .rt = 1,					\
-      .immediate = addr				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irSrc,				\
+      .rt = 0,					\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_CLZ			\
     }						\
   }
 
 /**
- * Jump if int register is zero
+ * Counts the trailing zero bits of int register (64 for zero)
  */
-#define RLVM_JIRZ(ireg, addr)			\
+#define RLVM_CTZ(irDst, irSrc)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 25,				\
-      .rs = ireg,				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irSrc,				\
       .rt = 0,					\
-      .immediate = addr				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_CTZ			\
     }						\
   }
 
 /**
- * Install new exception handler
+ * Reverses the bytes of int register
  */
-#define RLVM_INEH(addr)				\
+#define RLVM_BSWAP(irDst, irSrc)		\
   (opcode_t) {					\
-    .tvar = (op_tvar_t) {			\
-      .opcode = 26,				\
-      .target = addr				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irSrc,				\
+      .rt = 0,					\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_BSWAP			\
     }						\
   }
 
 /**
- * Loads from stack to int register
+ * Gathers the bits of int register selected by a mask
  */
-#define RLVM_IRLD(ireg, offset)			\
+#define RLVM_PEXT(irDst, irSrc, irMask)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 27,				\
-      .rs = 0,					\
-      .rt = ireg,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irSrc,				\
+      .rt = irMask,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_PEXT			\
     }						\
   }
 
 /**
- * Load bits from stack to float register
+ * Scatters the low bits of int register to the bits set in a mask
  */
-#define RLVM_FRLD(freg, offset)			\
+#define RLVM_PDEP(irDst, irSrc, irMask)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 27,				\
-      .rs = 1,					\
-      .rt = freg,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irSrc,				\
+      .rt = irMask,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_PDEP			\
     }						\
   }
 
 /**
- * Store int register to stack
+ * High 64 bits of the unsigned product of int registers
  */
-#define RLVM_IRST(ireg, offset)			\
+#define RLVM_MULHU(irDst, irLhs, irRhs)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 27,				\
-      .rs = 2,					\
-      .rt = ireg,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_MULHU			\
     }						\
   }
 
 /**
- * Store float register to stack
+ * High 64 bits of the signed product of int registers
  */
-#define RLVM_FRST(freg, offset)			\
+#define RLVM_MULHS(irDst, irLhs, irRhs)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 27,				\
-      .rs = 3,					\
-      .rt = freg,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 50,				\
+      .rs = irLhs,				\
+      .rt = irRhs,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_BIT_MULHS			\
     }						\
   }
 
 /**
- * Store float register bits to stack
+ * Makes a hash map (with byte string keys if bytes is set)
  */
-#define RLVM_FBST(freg, offset)			\
+#define RLVM_MAPNEW(irDst, bytes)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 27,				\
-      .rs = 4,					\
-      .rt = freg,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = 0,					\
+      .rt = 0,					\
+      .rd = irDst,				\
+      .sa = bytes,				\
+      .fn = RLVM_MAP_NEW			\
     }						\
   }
 
 /**
- * Allocate bytes on the heap
+ * Frees a hash map
  */
-#define RLVM_ALLOCI(ireg, size)			\
+#define RLVM_MAPFREE(irMap)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 28,				\
-      .rs = 0,					\
-      .rt = ireg,				\
-      .immediate = size				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = 0,					\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_MAP_FREE			\
     }						\
   }
 
-#define RLVM_IRALLOC(ireg, irSize)		\
+/**
+ * Looks a key up in a hash map, irFound is set to whether it is there
+ */
+#define RLVM_MAPGET(irDst, irMap, irKey, irFound)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 28,				\
-      .rs = irSize,				\
-      .rt = ireg,				\
-      .immediate = 0				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = irKey,				\
+      .rd = irDst,				\
+      .sa = irFound,				\
+      .fn = RLVM_MAP_GET			\
     }						\
   }
 
 /**
- * Free bytes on the heap
+ * Sets the value of a key in a hash map
  */
-#define RLVM_FREE(ireg)				\
+#define RLVM_MAPPUT(irMap, irKey, irVal)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 29,				\
-      .rs = 0,					\
-      .rt = ireg,				\
-      .immediate = 0,				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = irKey,				\
+      .rd = irVal,				\
+      .sa = 0,					\
+      .fn = RLVM_MAP_PUT			\
     }						\
   }
 
 /**
- * Loads a byte (8 bit) on the heap
+ * Removes a key from a hash map, irFound is set to whether it was there
  */
-#define RLVM_LDB(irDst, irBase, offset)		\
+#define RLVM_MAPDEL(irFound, irMap, irKey)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 30,				\
-      .rs = irBase,				\
-      .rt = irDst,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = irKey,				\
+      .rd = irFound,				\
+      .sa = 0,					\
+      .fn = RLVM_MAP_DEL			\
     }						\
   }
 
 /**
- * Loads a word (16 bit) on the heap
+ * Number of keys in a hash map
  */
-#define RLVM_LDW(irDst, irBase, offset)		\
+#define RLVM_MAPLEN(irDst, irMap)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 31,				\
-      .rs = irBase,				\
-      .rt = irDst,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = 0,					\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_MAP_LEN			\
     }						\
   }
 
 /**
- * Loads a double (32 bit) on the heap
+ * Steps a cursor (0 at the start and at the end) through a hash map
  */
-#define RLVM_LDD(irDst, irBase, offset)		\
+#define RLVM_MAPNEXT(irCursor, irMap, irKey, irVal)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 32,				\
-      .rs = irBase,				\
-      .rt = irDst,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = irKey,				\
+      .rd = irCursor,				\
+      .sa = irVal,				\
+      .fn = RLVM_MAP_NEXT			\
     }						\
   }
 
 /**
- * Loads a quad (64 bit) on the heap
+ * Adds irInc to the value of a key in a hash map (0 if it was not
+ * there) and puts the sum in irDst
  */
-#define RLVM_LDQ(irDst, irBase, offset)		\
+#define RLVM_MAPADD(irDst, irMap, irKey, irInc)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 33,				\
-      .rs = irBase,				\
-      .rt = irDst,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 55,				\
+      .rs = irMap,				\
+      .rt = irKey,				\
+      .rd = irDst,				\
+      .sa = irInc,				\
+      .fn = RLVM_MAP_ADD			\
     }						\
   }
 
 /**
- * Stores a byte (8 bit) on the heap
+ * Sorts an array of words, flags are the RLVM_SORT_* kind and order
  */
-#define RLVM_STB(irSrc, irBase, offset)		\
+#define RLVM_SORT(irArr, irLen, flags)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 34,				\
-      .rs = irBase,				\
-      .rt = irSrc,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 56,				\
+      .rs = irArr,				\
+      .rt = irLen,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = flags				\
     }						\
   }
 
 /**
- * Stores a word (16 bit) on the heap
+ * Sorts an array of keys and moves an array of values along
  */
-#define RLVM_STW(irSrc, irBase, offset)		\
+#define RLVM_SORTKV(irKeys, irLen, irVals, flags)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 35,				\
-      .rs = irBase,				\
-      .rt = irSrc,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 56,				\
+      .rs = irKeys,				\
+      .rt = irLen,				\
+      .rd = irVals,				\
+      .sa = 0,					\
+      .fn = RLVM_SORT_PAIRS | (flags)		\
     }						\
   }
 
 /**
- * Stores a double (32 bit) on the heap
+ * Index of the first word of a sorted array not ordered before a key
  */
-#define RLVM_STD(irSrc, irBase, offset)		\
+#define RLVM_LBOUND(irDst, irArr, irLen, rKey, flags)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 36,				\
-      .rs = irBase,				\
-      .rt = irSrc,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 56,				\
+      .rs = irArr,				\
+      .rt = irLen,				\
+      .rd = irDst,				\
+      .sa = rKey,				\
+      .fn = RLVM_SORT_LBOUND | (flags)		\
     }						\
   }
 
 /**
- * Stores a quad (64 bit) on the heap
+ * Makes an empty string builder
  */
-#define RLVM_STQ(irSrc, irBase, offset)		\
+#define RLVM_SBNEW(irDst)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 37,				\
-      .rs = irBase,				\
-      .rt = irSrc,				\
-      .immediate = offset			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = 0,					\
+      .rt = 0,					\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_SB_NEW				\
     }						\
   }
 
 /**
- * Skip compare: int registers are equal
+ * Frees a string builder
  */
-#define RLVM_SIREQ(ir1, ir2)			\
+#define RLVM_SBFREE(irBuf)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = ir1,				\
-      .rt = ir2,				\
-      .immediate = 0				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = 0,					\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_FREE			\
     }						\
   }
 
 /**
- * Skip compare: float registers are equal
+ * Appends the low byte of int register to a string builder
  */
-#define RLVM_SFREQ(fr1, fr2)			\
+#define RLVM_SBCHR(irBuf, irSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = fr1,				\
-      .rt = fr2,				\
-      .immediate = 0 | 8			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = irSrc,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_CHR				\
     }						\
   }
 
 /**
- * Skip compare: int registers are less
+ * Appends the null-terminated string at int register to a string builder
  */
-#define RLVM_SIRL(ir1, ir2)			\
+#define RLVM_SBSTR(irBuf, irSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = ir1,				\
-      .rt = ir2,				\
-      .immediate = 1				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = irSrc,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_STR				\
     }						\
   }
 
 /**
- * Skip compare: signed int registers are less
+ * Appends int register in signed decimal to a string builder
  */
-#define RLVM_SIRSL(ir1, ir2)			\
+#define RLVM_SBINT(irBuf, irSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = ir1,				\
-      .rt = ir2,				\
-      .immediate = 1 | 4			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = irSrc,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_INT				\
     }						\
   }
 
 /**
- * Skip compare: float registers are less
+ * Appends int register in unsigned decimal to a string builder
  */
-#define RLVM_SFRL(fr1, fr2)			\
+#define RLVM_SBUINT(irBuf, irSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = fr1,				\
-      .rt = fr2,				\
-      .immediate = 1 | 8			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = irSrc,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_UINT			\
     }						\
   }
 
 /**
- * Skip compare: int registers are more
+ * Appends int register in hex to a string builder
  */
-#define RLVM_SIRG(ir1, ir2)			\
+#define RLVM_SBHEX(irBuf, irSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = ir1,				\
-      .rt = ir2,				\
-      .immediate = 2				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = irSrc,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_HEX				\
     }						\
   }
 
 /**
- * Skip compare: signed int registers are more
+ * Appends float register (shortest round-trip) to a string builder
  */
-#define RLVM_SIRSG(ir1, ir2)			\
+#define RLVM_SBFLT(irBuf, frSrc)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = ir1,				\
-      .rt = ir2,				\
-      .immediate = 2 | 4			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = frSrc,				\
+      .rd = 0,					\
+      .sa = 0,					\
+      .fn = RLVM_SB_FLT				\
     }						\
   }
 
 /**
- * Skip compare: float registers are more
+ * Writes a string builder to a file and empties it
  */
-#define RLVM_SFRG(fr1, fr2)			\
+#define RLVM_SBFLUSH(irDst, irBuf, irFile)	\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = fr1,				\
-      .rt = fr2,				\
-      .immediate = 2 | 8			\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
+      .rt = irFile,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_SB_FLUSH			\
     }						\
   }
 
 /**
- * Skip compare: int register is zero
+ * Number of bytes in a string builder
  */
-#define RLVM_SIRZ(ireg)				\
+#define RLVM_SBLEN(irDst, irBuf)		\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = ireg,				\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 57,				\
+      .rs = irBuf,				\
       .rt = 0,					\
-      .immediate = 3				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = RLVM_SB_LEN				\
     }						\
   }
 
 /**
- * Skip compare: float register is zero
+ * Calls slot target of the native table
  */
-#define RLVM_SFRZ(freg)				\
+#define RLVM_NCALL(slot)			\
   (opcode_t) {					\
-    .svar = (op_svar_t) {			\
-      .opcode = 38,				\
-      .rs = freg,				\
-      .rt = 0,					\
-      .immediate = 3 | 8			\
+    .tvar = (op_tvar_t) {			\
+      .opcode = 58,				\
+      .target = slot				\
     }						\
   }
 
@@ -1452,6 +2551,137 @@ typedef struct bcode_t
     }						\
   }
 
+/**
+ * Calls a code address once per chunk of a range in parallel
+ */
+#define RLVM_PARFOR(irLo, irHi, addr)		\
+  (opcode_t) {					\
+    .svar = (op_svar_t) {			\
+      .opcode = 42,				\
+      .rs = irLo,				\
+      .rt = irHi,				\
+      .immediate = addr				\
+    }						\
+  }
+
+/**
+ * Vector operation (see vector.h) on lanes of type
+ */
+#define RLVM_VOP(op, type, vrDst, vrA, vrB)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 43,				\
+      .rs = vrA,				\
+      .rt = vrB,				\
+      .rd = vrDst,				\
+      .sa = type,				\
+      .fn = op					\
+    }						\
+  }
+
+/**
+ * Loads 32 bytes from the heap into a vector register
+ */
+#define RLVM_VLD(vrDst, irAddr)			\
+  RLVM_VOP (VEC_LD, 0, vrDst, irAddr, 0)
+
+/**
+ * Stores a vector register as 32 bytes on the heap
+ */
+#define RLVM_VST(vrSrc, irAddr)			\
+  RLVM_VOP (VEC_ST, 0, 0, irAddr, vrSrc)
+
+/**
+ * Compares lanes, setting each lane of vrDst to all ones or zero
+ */
+#define RLVM_VCMP(pred, type, vrDst, vrA, vrB)	\
+  RLVM_VOP (VEC_CMP, (pred) << 3 | (type), vrDst, vrA, vrB)
+
+/**
+ * Copies an int (or float for float lanes) register to every lane
+ */
+#define RLVM_VBCST(type, vrDst, reg)		\
+  RLVM_VOP (VEC_BCST, type, vrDst, reg, 0)
+
+/**
+ * Reduces the lanes (VEC_SUM, VEC_RMIN or VEC_RMAX) or collects
+ * their sign bits (VEC_MASK) into a register
+ */
+#define RLVM_VRED(op, type, regDst, vrSrc)	\
+  RLVM_VOP (op, type, regDst, vrSrc, 0)
+
+/**
+ * Reads the lane selected by irLane into a register
+ */
+#define RLVM_VGET(type, regDst, vrSrc, irLane)	\
+  RLVM_VOP (VEC_GET, type, regDst, vrSrc, irLane)
+
+/**
+ * Writes a register into the lane selected by irLane
+ */
+#define RLVM_VSET(type, vrDst, reg, irLane)	\
+  RLVM_VOP (VEC_SET, type, vrDst, reg, irLane)
+
+/**
+ * Copies irLen bytes from irSrc to irDst (must not overlap)
+ */
+#define RLVM_MEMCPY(irDst, irSrc, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irSrc,				\
+      .rt = irLen,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = 0					\
+    }						\
+  }
+
+/**
+ * Copies irLen bytes from irSrc to irDst (may overlap)
+ */
+#define RLVM_MEMMOVE(irDst, irSrc, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irSrc,				\
+      .rt = irLen,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = 1					\
+    }						\
+  }
+
+/**
+ * Fills irLen bytes at irDst with the low byte of irVal
+ */
+#define RLVM_MEMSET(irDst, irVal, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irVal,				\
+      .rt = irLen,				\
+      .rd = irDst,				\
+      .sa = 0,					\
+      .fn = 2					\
+    }						\
+  }
+
+/**
+ * Compares irLen bytes at irA and irB, irRes is -1, 0 or 1
+ */
+#define RLVM_MEMCMP(irRes, irA, irB, irLen)	\
+  (opcode_t) {					\
+    .fvar = (op_fvar_t) {			\
+      .opcode = 44,				\
+      .rs = irA,				\
+      .rt = irB,				\
+      .rd = irRes,				\
+      .sa = irLen,				\
+      .fn = 3					\
+    }						\
+  }
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -1463,6 +2693,13 @@ extern "C"
 
   extern status_t exec_bcode_t (rlvm_t * vm, bcode_t * bf);
 
+  /**
+   * Binds the imports to the natives registered right now. Reading
+   * and assembling bytecode already does this, call it again after
+   * registering more. Returns false if out of memory.
+   */
+  extern bool link_natives (bcode_t * bf);
+
   extern void clean_bcode (bcode_t * bf);
 
 #ifdef __cplusplus
@@ -0,0 +1,78 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __BITS_H__
+#define __BITS_H__
+
+#include <stdint.h>
+
+/*
+ * Bit manipulation behind opcode 50. Each one is a single instruction
+ * where the host has it (popcnt, lzcnt, tzcnt, bswap, pext, pdep and
+ * the wide multiply) and a plain C loop everywhere else.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  extern uint64_t bits_popcount (uint64_t x);
+
+  /**
+   * Counts the leading zero bits of x, which is 64 when x is zero
+   */
+  extern uint64_t bits_clz (uint64_t x);
+
+  /**
+   * Counts the trailing zero bits of x, which is 64 when x is zero
+   */
+  extern uint64_t bits_ctz (uint64_t x);
+
+  extern uint64_t bits_bswap (uint64_t x);
+
+  /**
+   * Gathers the bits of x selected by mask into the low bits of the
+   * result, lowest first (what BMI2 calls pext)
+   */
+  extern uint64_t bits_pext (uint64_t x, uint64_t mask);
+
+  /**
+   * Scatters the low bits of x to the positions set in mask, lowest
+   * first (what BMI2 calls pdep)
+   */
+  extern uint64_t bits_pdep (uint64_t x, uint64_t mask);
+
+  /**
+   * Returns the high 64 bits of the 128 bit product of a and b
+   */
+  extern uint64_t bits_mulhu (uint64_t a, uint64_t b);
+
+  extern uint64_t bits_mulhs (uint64_t a, uint64_t b);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__BITS_H__ */
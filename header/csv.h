@@ -0,0 +1,96 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __CSV_H__
+#define __CSV_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Delimited text helpers behind the MEM family. The scanner finds the
+ * delimiters, newlines and quotes 16 bytes at a time (SSE2 compares
+ * and a movemask) and only looks at those bytes one by one, so plain
+ * field text costs no per-byte work.
+ *
+ * A dialect packs the delimiter in bits 0-7, the quote in bits 8-15
+ * (0 for none) and the newline in bits 16-23.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+#define CSV_DIALECT(delim, quote, newline)				\
+  ((uint32_t) (uint8_t) (delim) | (uint32_t) (uint8_t) (quote) << 8	\
+   | (uint32_t) (uint8_t) (newline) << 16)
+
+/* Set in the end offset of the last field of each record */
+#define CSV_END_RECORD (UINT64_C (1) << 63)
+
+/*
+ * Set in the end offset of a quoted field. The offsets leave out the
+ * quotes, but doubled quotes inside are still doubled.
+ */
+#define CSV_QUOTED (UINT64_C (1) << 62)
+
+#define CSV_OFFSET_MASK (CSV_QUOTED - 1)
+
+  typedef struct csv_field_t
+  {
+    uint64_t start;
+    uint64_t end;		/* One past the last byte, with the flags above */
+  } csv_field_t;
+
+  /**
+   * Splits len bytes at buf into fields, writing at most cap of them
+   * to out, and returns how many it wrote. Only whole records are
+   * written; *consumed is set to the bytes they span, which is where
+   * the next scan should start. A last record without a newline counts
+   * as whole. A carriage return before a newline is not part of the
+   * field.
+   */
+  extern uint64_t csv_scan (const char *buf, uint64_t len, uint32_t dialect,
+			    csv_field_t * out, uint64_t cap,
+			    uint64_t * consumed);
+
+  /**
+   * Parses all len bytes at s as a decimal int with an optional sign.
+   * Returns false if it is not one or does not fit.
+   */
+  extern bool csv_parse_i64 (const char *s, uint64_t len, int64_t * out);
+
+  /**
+   * Parses all len bytes at s as a decimal double with an optional
+   * sign, fraction and exponent. Returns false if it is not one or is
+   * too large for a double.
+   */
+  extern bool csv_parse_f64 (const char *s, uint64_t len, double *out);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__CSV_H__ */
@@ -0,0 +1,109 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __EMBED_H__
+#define __EMBED_H__
+
+#include "rlvm.h"
+#include "bcode.h"
+#include "lblmap.h"
+
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/*
+ * Calling into bytecode from the host. An instance keeps one VM around
+ * a loaded image, so a function exported with .GLOBAL can be called
+ * any number of times without setting anything up again:
+ *
+ *     rlvm_inst_t inst;
+ *     rlvm_open (&inst, &code);
+ *     uint64_t args[] = { req, len };
+ *     status_t st = rlvm_call (&inst, "handle", 2, args);
+ *     ... the results are in inst.vm.iregs[0] (and [1], fregs[0])
+ *
+ * The calling convention is the one of NCALL: the arguments go in r0
+ * onwards (set inst.vm.fregs directly for floats) and the function
+ * returns with RET. Every register, the stack below the call and
+ * whatever the program allocated survive between calls, so state can
+ * be kept in registers or in heap blocks they point at. Each call
+ * needs one word of .STACK for its return address.
+ *
+ * An instance is not thread-safe, but any number of them can share an
+ * image.
+ */
+#define RLVM_CALL_ARGS 8
+
+typedef struct rlvm_inst_t
+{
+  bcode_t *code;		/* The image, not owned */
+  rlvm_t vm;			/* Kept between calls */
+  lblmap_t exports;		/* Name to code address */
+} rlvm_inst_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Sets up an instance on code. Nothing runs, call an exported set up
+   * function if the program has one. Returns false if out of memory.
+   */
+  extern bool rlvm_open (rlvm_inst_t * inst, bcode_t * code);
+
+  /**
+   * Looks up the address of an exported function, for rlvm_call_at.
+   * Returns false if name is not exported.
+   */
+  extern bool rlvm_export (const rlvm_inst_t * inst, const char *name,
+			   uint64_t * addr);
+
+  /**
+   * Calls the exported function name with argc (at most
+   * RLVM_CALL_ARGS) arguments. Returns CLEAN once it returns, or the
+   * state it faulted with. BAD_OPCODE also means name is not exported
+   * or argc is too large. A function that halts returns CLEAN with
+   * the value in uid and ip left at the HALT.
+   */
+  extern status_t rlvm_call (rlvm_inst_t * inst, const char *name,
+			     size_t argc, const uint64_t * argv);
+
+  /**
+   * Same as rlvm_call on an address from rlvm_export, which saves the
+   * lookup
+   */
+  extern status_t rlvm_call_at (rlvm_inst_t * inst, uint64_t addr,
+				size_t argc, const uint64_t * argv);
+
+  extern void rlvm_close (rlvm_inst_t * inst);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__EMBED_H__ */
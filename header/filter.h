@@ -0,0 +1,90 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __FILTER_H__
+#define __FILTER_H__
+
+#include "rlvm.h"
+#include "bcode.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/*
+ * Filter mode runs a program as a stdin to stdout filter without
+ * going through DISKIO one byte at a time.
+ *
+ * The program starts at address 0 as usual, sets itself up and halts
+ * with the address of its batch entry:
+ *
+ *     MOV r0, on_batch
+ *     HALT r0
+ *
+ * The host then splits the input into records and calls the entry once
+ * per batch with
+ *
+ *     r0  address of the record table, two words per record: the
+ *         address of its bytes and its length (delimiter excluded)
+ *     r1  number of records in the table
+ *     r2  address of the output buffer
+ *     r3  size of the output buffer
+ *
+ * The entry returns (RET) with the number of bytes written to the
+ * output buffer in r0 and the number of records it consumed in r1.
+ * Records not consumed are offered again in the next call, so a
+ * program can stop early when its output buffer fills up. All other
+ * registers and the stack survive between calls. After the last batch
+ * the entry is called once more with r1 = 0 to flush whatever it
+ * accumulated.
+ *
+ * If the program halts or faults inside the entry, the filter stops
+ * and that state is returned.
+ */
+typedef enum filter_delim_t
+{
+  FILTER_NEWLINE = 0,		/* Records end with \n */
+  FILTER_U32LE			/* Records start with a 32 bit little endian length */
+} filter_delim_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Runs code as a filter from in to out, handing it batches of
+   * roughly batch_size bytes of input.
+   */
+  extern status_t exec_filter (bcode_t * code, FILE * in, FILE * out,
+			       filter_delim_t delim, size_t batch_size);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__FILTER_H__ */
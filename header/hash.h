@@ -0,0 +1,78 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Checksums and hashes behind the MEM family. CRC32C runs on the
+ * SSE4.2 crc32 instruction when the cpu has it and on a table
+ * otherwise. The 64-bit hash is XXH64, so the digests match what
+ * other tools write for the same bytes and seed.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Streaming XXH64 state. Programs allocate it on the heap, which is
+   * why its size is part of the instruction set (see sample/README.md).
+   */
+  typedef struct hash_state_t
+  {
+    uint64_t total;
+    uint64_t acc[4];
+    uint8_t buf[32];
+    uint64_t buflen;
+  } hash_state_t;
+
+  /**
+   * Continues the CRC32C crc with len bytes at buf. Start with 0; the
+   * result of one call can be fed to the next.
+   */
+  extern uint32_t hash_crc32c (uint32_t crc, const void *buf, size_t len);
+
+  extern uint64_t hash_xxh64 (const void *buf, size_t len, uint64_t seed);
+
+  extern void hash_init (hash_state_t * st, uint64_t seed);
+
+  extern void hash_update (hash_state_t * st, const void *buf, size_t len);
+
+  /**
+   * Returns the hash of everything passed to hash_update so far, which
+   * is the same as hash_xxh64 over those bytes. The state is left as
+   * is, so more bytes can follow.
+   */
+  extern uint64_t hash_digest (const hash_state_t * st);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__HASH_H__ */
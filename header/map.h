@@ -0,0 +1,115 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MAP_H__
+#define __MAP_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Hash maps behind opcode 55. It is an open addressing table in the
+ * style of the Swiss table: every slot has a control byte holding 7
+ * bits of its hash (or empty / deleted), and a probe compares a group
+ * of 16 control bytes at once (with SSE2 where there is SSE2) before
+ * it looks at any key.
+ *
+ * Keys are 64-bit ints or byte strings (a pointer and a length), which
+ * the map copies with the length in the word before the bytes. Values
+ * are 64-bit, so a slot is 16 bytes either way.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  typedef struct map_slot_t
+  {
+    uint64_t key;		/* The int or the pointer to the bytes */
+    uint64_t val;
+  } map_slot_t;
+
+  typedef struct map_t
+  {
+    uint8_t *ctrl;
+    map_slot_t *slots;
+    uint64_t cap;		/* Slots, a power of 2 no less than 16 */
+    uint64_t size;
+    uint64_t growth_left;	/* Inserts until the table has to grow */
+    bool bytes;
+  } map_t;
+
+  /**
+   * Returns a new map with int keys or, if bytes is set, byte string
+   * keys. NULL if out of memory.
+   */
+  extern map_t *map_new (bool bytes);
+
+  extern void map_free (map_t * map);
+
+  /**
+   * Looks the key up (len is ignored for int keys) and returns the
+   * slot holding it or NULL
+   */
+  extern map_slot_t *map_find (const map_t * map, uint64_t key,
+			       uint64_t len);
+
+  /**
+   * Sets the value of the key, adding it if needed. Returns false if
+   * out of memory, which leaves the map as it was.
+   */
+  extern bool map_put (map_t * map, uint64_t key, uint64_t len,
+		       uint64_t val);
+
+  /**
+   * Adds inc to the value of the key, adding it with the value 0 first
+   * if needed, and stores the sum in *val. One probe where a find and a
+   * put take two. Returns false if out of memory like map_put.
+   */
+  extern bool map_add (map_t * map, uint64_t key, uint64_t len,
+		       uint64_t inc, uint64_t * val);
+
+  /**
+   * Removes the key, returns false if it was not there
+   */
+  extern bool map_del (map_t * map, uint64_t key, uint64_t len);
+
+  /**
+   * Returns the first filled slot at or after index *cursor and moves
+   * the cursor past it, or NULL when there are no more. Start at 0.
+   */
+  extern map_slot_t *map_next (const map_t * map, uint64_t * cursor);
+
+  /**
+   * Returns the length of the byte string key of a slot, 0 for int keys
+   */
+  extern uint64_t map_key_len (const map_t * map, const map_slot_t * slot);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__MAP_H__ */
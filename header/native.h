@@ -0,0 +1,87 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __NATIVE_H__
+#define __NATIVE_H__
+
+#include "rlvm.h"
+
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/*
+ * Native calls (opcode 58). The host registers C functions by name,
+ * NCALL name in assembly puts the name in the import table of the
+ * bytecode and encodes its slot there, and loading the bytecode binds
+ * every slot to the function registered under that name. Register
+ * before loading; a slot nothing was registered for throws BAD_OPCODE
+ * when it is called.
+ *
+ * A native gets the VM itself and works on its registers in place, so
+ * a call copies and allocates nothing. By convention the arguments are
+ * in r0 - r7 and fp0 - fp7 and the results go to r0, r1 and fp0. Those
+ * are the registers a native may change; it should leave the others,
+ * the stack and ip alone.
+ *
+ * Returning a state other than CLEAN throws it inside the VM, where
+ * the exception handlers see it like any other fault.
+ */
+typedef status_t (*native_fn_t) (rlvm_t * vm, void *data);
+
+typedef struct native_t
+{
+  native_fn_t fn;		/* NULL if the name was not registered */
+  void *data;			/* Handed to fn on every call */
+} native_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Registers fn under name, replacing what was registered under it
+   * before. Not thread-safe, register everything before running any
+   * bytecode. Returns false if out of memory.
+   */
+  extern bool native_register (const char *name, native_fn_t fn,
+			       void *data);
+
+  /**
+   * Binds size bytes of NUL terminated names to the functions they are
+   * registered under, one slot per name in order, and stores the
+   * number of slots in count. The slots are malloc-ed, NULL if there
+   * are no names (or out of memory, with count set to 0).
+   */
+  extern native_t *native_bind (const char *names, uint64_t size,
+				uint64_t * count);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__NATIVE_H__ */
@@ -0,0 +1,82 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __PARFOR_H__
+#define __PARFOR_H__
+
+#include "rlvm.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/**
+ * PARFOR splits [iregs[rs], iregs[rt]) into chunks and calls the
+ * label once per chunk, each call on a VM with its own registers,
+ * call stack and exception stack. The chunk bounds are passed in
+ * the same registers the range came from. The chunks are handed to
+ * a pool of host threads and the instruction returns only after all
+ * of them are done (the heap is shared, the registers are not).
+ *
+ * A preceding PRED selects a register that is reduced across all
+ * chunks; every chunk starts that register at the identity of the
+ * reduction and the results are combined into the caller's value.
+ */
+typedef enum parfor_red_t
+{
+  RED_ADD = 0, RED_MUL, RED_AND, RED_OR, RED_XOR, RED_MIN, RED_MAX,
+  RED_SMIN, RED_SMAX
+} parfor_red_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Sets the number of host threads a PARFOR runs on, the calling one
+   * included (0 means one per online cpu). Lowering it caps later
+   * PARFORs, threads already spawned stay idle.
+   */
+  extern void set_parfor_threads (size_t count);
+
+  extern size_t get_parfor_threads (void);
+
+  /**
+   * Tells if a PRED instruction names a reduction of its register
+   * kind. Float registers only reduce by add, mul, min and max.
+   */
+  extern bool red_defined (opcode_t pred);
+
+  extern status_t exec_parfor (rlvm_t * vm, const uint64_t len,
+			       opcode_t * ops, opcode_t instr);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif				/* !__PARFOR_H__ */
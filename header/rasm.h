@@ -37,10 +37,23 @@ extern "C"
 {
 #endif				/* !__cplusplus */
 
+  /**
+   * When set, assemble folds SUB rN, rN, 1 / JZ rN, out / JMP top
+   * loops (out being right after the JMP) into DBNZ rN, top and turns
+   * CALL x / RET into TAILCALL x
+   */
+  extern bool optimize;
+
   extern bcode_t assemble (FILE ** in, size_t count);
 
   extern int disassemble (bcode_t * code, size_t count, FILE * out);
 
+  /**
+   * Decodes a typed vector mnemonic such as vadd.pd or vcmplt.b into
+   * fn | sa << 8 of opcode 43. Returns -1 if it is not one.
+   */
+  extern int parse_vec_op (const char *mnemonic);
+
 #ifdef __cplusplus
 }
 #endif				/* !__cplusplus */
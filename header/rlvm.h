@@ -114,15 +114,163 @@ typedef union opcode_t
 } opcode_t;
 
 /*
- * ISA restricts the amount of registers to 32. Since the float points
- * and the ints (maybe vector types) use different registers, we will
- * have 32 uint64_t's and 32 doubles (which according to IEEE, it is
- * 64-bits)
- *
- * For now, we ignore the vector type
+ * LDK (opcode 45) loads a 64-bit word out of the pool. The slot counts
+ * words from the start of the pool and is made of the low 4 bits of rt
+ * and the immediate. Bit 4 of rt selects the float registers.
+ */
+#define RLVM_LDK_FP 0x10
+#define RLVM_LDK_SLOTS ((uint64_t) 1 << 20)
+#define RLVM_LDK_SLOT(instr)					\
+  ((uint64_t) ((instr).svar.rt & 0xF) << 16 | (instr).svar.immediate)
+
+/*
+ * Indexed heap access (opcode 46) goes to rs + (rt << scale) + sa * size
+ * with sa signed. fn holds log2 of the size in bits 0-1, the scale in
+ * bits 2-3 and the two flags below. Float access is 4 or 8 bytes wide.
+ */
+#define RLVM_HX_FP 0x10
+#define RLVM_HX_ST 0x20
+
+/*
+ * Streaming access (opcode 47) shares the size and flag bits of fn with
+ * opcode 46: a load or store at rs that then adds sa (signed) elements
+ * to rs. Bits 2-3 pick the kind, only RLVM_SM_POST is defined.
+ */
+#define RLVM_SM_POST 0x00
+
+/*
+ * Compares (opcodes 38 and 49) share one flag. Bits 0-1 pick equal,
+ * less than, greater than or zero, bit 2 makes less and greater
+ * signed and bit 3 compares the float registers instead.
+ */
+#define RLVM_CC_EQ 0x0
+#define RLVM_CC_LT 0x1
+#define RLVM_CC_GT 0x2
+#define RLVM_CC_ZERO 0x3
+#define RLVM_CC_SIGNED 0x4
+#define RLVM_CC_FP 0x8
+
+/*
+ * Predication (opcode 49) keeps the compare flag of rs and rt in bits
+ * 0-3 of fn and the kind in bits 4-5: set rd to 0 or 1, move int or
+ * float register sa into rd when the compare holds, or select rs when
+ * int register sa is not zero and rt otherwise (bit 3 picks floats).
+ */
+#define RLVM_CC_SET 0x00
+#define RLVM_CC_MOV 0x10
+#define RLVM_CC_MOVF 0x20
+#define RLVM_CC_SELECT 0x30
+
+/*
+ * Bit manipulation (opcode 50) writes rd from rs (and rt for the ones
+ * with two operands). fn picks the operation.
+ */
+#define RLVM_BIT_POPCNT 0
+#define RLVM_BIT_CLZ 1
+#define RLVM_BIT_CTZ 2
+#define RLVM_BIT_BSWAP 3
+#define RLVM_BIT_PEXT 4
+#define RLVM_BIT_PDEP 5
+#define RLVM_BIT_MULHU 6
+#define RLVM_BIT_MULHS 7
+
+/*
+ * SAVE (opcode 53) pushes the registers picked by a 64-bit mask in the
+ * pool, the slot being the same as in LDK. Bits 0-31 are the int and
+ * bits 32-63 the float registers, pushed lowest first. RESTORE is the
+ * same with bit 0 of rs set and pops them back.
+ */
+#define RLVM_SAVE_RESTORE 0x1
+
+/*
+ * Frame access (opcode 54) reaches the stack word at int register rs
+ * plus a signed offset in the low 14 bits of the immediate, so it
+ * stays put while sp moves. The top 2 bits pick the access.
+ */
+#define RLVM_FRAME_LD 0
+#define RLVM_FRAME_LDF 1
+#define RLVM_FRAME_ST 2
+#define RLVM_FRAME_STF 3
+
+/*
+ * Hash maps (opcode 55) live behind a handle in int register rs. Keys
+ * are in rt, and maps made with sa set take byte string keys with the
+ * pointer in rt and the length in the register after it. MAPNEXT walks
+ * the entries with a cursor in rd that starts and ends at 0. MAPADD
+ * adds sa to the value of a key in one probe and puts the sum in rd.
+ */
+#define RLVM_MAP_NEW 0
+#define RLVM_MAP_FREE 1
+#define RLVM_MAP_GET 2
+#define RLVM_MAP_PUT 3
+#define RLVM_MAP_DEL 4
+#define RLVM_MAP_LEN 5
+#define RLVM_MAP_NEXT 6
+#define RLVM_MAP_ADD 7
+
+/*
+ * Sorting (opcode 56) works on the array of 64-bit words at int
+ * register rs, with the length in rt. The low 2 bits of fn pick how
+ * the words compare. With RLVM_SORT_PAIRS the array at rd is moved
+ * along. RLVM_SORT_LBOUND instead searches the sorted array for the
+ * key in sa (a float register for doubles) and writes the index to rd.
+ */
+#define RLVM_SORT_UNSIGNED 0
+#define RLVM_SORT_SIGNED 1
+#define RLVM_SORT_FLOAT 2
+#define RLVM_SORT_KIND 0x3
+#define RLVM_SORT_DESC 0x4
+#define RLVM_SORT_PAIRS 0x8
+#define RLVM_SORT_LBOUND 0x10
+
+/*
+ * String builders (opcode 57) append to the buffer behind the handle
+ * in int register rs. The value is in rt (a float register for SBFLT).
+ * SBFLUSH writes the buffer to the file in rt and empties it.
+ */
+#define RLVM_SB_NEW 0
+#define RLVM_SB_FREE 1
+#define RLVM_SB_CHR 2
+#define RLVM_SB_STR 3
+#define RLVM_SB_INT 4
+#define RLVM_SB_UINT 5
+#define RLVM_SB_HEX 6
+#define RLVM_SB_FLT 7
+#define RLVM_SB_FLUSH 8
+#define RLVM_SB_LEN 9
+
+/*
+ * NCALL (opcode 58) calls slot target of the native table the VM was
+ * given (see native.h).
+ */
+struct native_t;
+
+/*
+ * ISA restricts the amount of registers to 32. Since the float points,
+ * the ints and the vectors use different registers, we will have 32
+ * uint64_t's, 32 doubles (which according to IEEE, it is 64-bits) and
+ * 32 vectors of 256 bits
  */
 #define ALLOC_REGS_COUNT 32
 
+/*
+ * A vector register is viewed as lanes of whatever width the
+ * instruction says (see vector.h)
+ */
+typedef union vreg_t
+{
+  int8_t b[32];
+  int16_t w[16];
+  int32_t d[8];
+  int64_t q[4];
+  uint8_t ub[32];
+  uint16_t uw[16];
+  uint32_t ud[8];
+  uint64_t uq[4];
+  float ps[8];
+  double pd[4];
+} vreg_t;
+
 typedef struct rlvm_t
 {
   uint64_t stack_size;		/* Call stack size */
@@ -133,9 +281,17 @@ typedef struct rlvm_t
   status_t state;		/* VM state, also stores latest exception */
   uint64_t iregs[ALLOC_REGS_COUNT];	/* Integer registers */
   double fregs[ALLOC_REGS_COUNT];	/* Float point registers */
+  vreg_t vregs[ALLOC_REGS_COUNT];	/* Vector registers */
   uint64_t *stack;		/* Call stack */
   ehandle_t *estack;		/* Exception stack */
   char *ropool;			/* Readonly pool */
+  opcode_t red;			/* Reduction set by PRED for PARFOR */
+  FILE *fin;			/* What the program sees as stdin */
+  FILE *fout;			/* What the program sees as stdout */
+  FILE *ferr;			/* What the program sees as stderr */
+  uint64_t icount;		/* Instructions executed so far */
+  const struct native_t *natives;	/* Slots NCALL reaches */
+  uint64_t native_count;	/* Number of slots */
 } rlvm_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,86 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __RUNNER_H__
+#define __RUNNER_H__
+
+#include "rlvm.h"
+#include "bcode.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/**
+ * One line of a manifest. Each line names a bytecode file and
+ * optionally a file the program reads as stdin and a file it writes
+ * as stdout (both default to the ones of rlvm):
+ *
+ *     program.bin [input.txt [output.txt]]
+ *
+ * Empty lines and lines starting with # are skipped.
+ */
+typedef struct job_t
+{
+  char *prog;			/* Bytecode file */
+  char *input;			/* NULL if the program reads stdin */
+  char *output;			/* NULL if the program writes stdout */
+  size_t image;			/* Index into the loaded programs */
+  bool ran;			/* False if a file could not be opened */
+  status_t state;		/* Return value of the program */
+  uint64_t icount;		/* Instructions executed */
+  double wall;			/* Wall time in seconds */
+} job_t;
+
+typedef enum summary_fmt_t
+{
+  SUMMARY_CSV = 0, SUMMARY_JSON
+} summary_fmt_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  extern const char *state_name (status_t state);
+
+  /**
+   * One summary may cover several manifests: write its header with
+   * begin_summary, the rows of each manifest with run_manifest, which
+   * numbers them on from *nrows, and close it with end_summary.
+   */
+  extern void begin_summary (FILE * summary, summary_fmt_t fmt);
+  extern void end_summary (FILE * summary, summary_fmt_t fmt);
+
+  extern int run_manifest (FILE * manifest, size_t nthreads,
+			   FILE * summary, summary_fmt_t fmt, size_t * nrows);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__RUNNER_H__ */
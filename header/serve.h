@@ -0,0 +1,156 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __SERVE_H__
+#define __SERVE_H__
+
+#include "rlvm.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/*
+ * Wire format of the daemon. Both ends live on the same host, so
+ * every field is a native endian uint64_t (no padding to worry about).
+ *
+ * A request is a serve_req_t followed by code_len bytes of bytecode
+ * (exactly what read_bytecode expects) and input_len bytes handed to
+ * the program as its stdin. The reply is a serve_rep_t followed by
+ * out_len bytes of captured stdout and err_len bytes of stderr.
+ *
+ * Programs are cached by the hash of their bytecode. A client that
+ * already sent a program may send code_len = 0 with the same hash;
+ * if the daemon has since dropped it, the reply is SERVE_MISS and the
+ * client should retry with the bytecode attached. SERVE_ERROR means
+ * the daemon ran out of memory or descriptors setting the request up;
+ * the connection is dropped after it if the payload was not read.
+ *
+ * Every run happens in a child process of the daemon. SERVE_TIMEOUT
+ * means the child was killed for running past the timeout of the
+ * daemon and SERVE_CRASHED that it died on its own, with the signal
+ * in uid. Neither reply carries output.
+ */
+#define SERVE_MAX_PAYLOAD (64 << 20)
+
+typedef enum serve_kind_t
+{
+  SERVE_RUN = 1, SERVE_STATS
+} serve_kind_t;
+
+typedef enum serve_status_t
+{
+  SERVE_OK = 0, SERVE_BAD_REQUEST, SERVE_BAD_BYTECODE, SERVE_MISS,
+  SERVE_ERROR, SERVE_TIMEOUT, SERVE_CRASHED
+} serve_status_t;
+
+typedef struct serve_req_t
+{
+  uint64_t kind;		/* serve_kind_t */
+  uint64_t hash;		/* hash_xxh64 of the bytecode, seed 0 */
+  uint64_t code_len;
+  uint64_t input_len;
+} serve_req_t;
+
+typedef struct serve_rep_t
+{
+  uint64_t status;		/* serve_status_t */
+  uint64_t state;		/* status_t.state of the program */
+  uint64_t uid;			/* status_t.uid of the program */
+  uint64_t icount;		/* Instructions executed */
+  uint64_t wall_ns;		/* Time spent in exec_bytecode */
+  uint64_t out_len;
+  uint64_t err_len;
+} serve_rep_t;
+
+/**
+ * A reply with its payload. out and err are malloc-ed (and NUL
+ * terminated for convenience) and freed by clean_serve_reply.
+ */
+typedef struct serve_reply_t
+{
+  serve_rep_t head;
+  char *out;
+  char *err;
+} serve_reply_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Monotonic clock in nanoseconds, for latency figures.
+   */
+  extern uint64_t serve_now_ns (void);
+
+  /**
+   * Reads f up to EOF into a malloc-ed buffer and stores its size in
+   * len. Returns NULL when out of memory.
+   */
+  extern char *serve_slurp (FILE * f, size_t * len);
+
+  /**
+   * qsort comparator of uint64_t, to sort latency samples.
+   */
+  extern int serve_cmp_u64 (const void *a, const void *b);
+
+  /**
+   * Listens on the Unix socket at path and serves requests with
+   * nthreads workers (0 means one per online cpu). A run is killed
+   * after timeout_ms milliseconds (0 means no limit). Only returns if
+   * the socket cannot be set up, in which case the return value is
+   * non-zero.
+   */
+  extern int serve (const char *path, size_t nthreads, uint64_t timeout_ms);
+
+  /**
+   * Connects to a daemon. Returns -1 on failure.
+   */
+  extern int serve_connect (const char *path);
+
+  /**
+   * Runs a program on the daemon. Passing code = NULL sends only the
+   * hash (see SERVE_MISS). Returns false on a transport error.
+   */
+  extern bool serve_run (int fd, uint64_t hash, const void *code,
+			 size_t code_len, const void *input,
+			 size_t input_len, serve_reply_t * reply);
+
+  /**
+   * Fetches the daemon statistics as a JSON object in reply->out.
+   */
+  extern bool serve_stats (int fd, serve_reply_t * reply);
+
+  extern void clean_serve_reply (serve_reply_t * reply);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__SERVE_H__ */
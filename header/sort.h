@@ -0,0 +1,69 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __SORT_H__
+#define __SORT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Sorting behind opcode 56. Arrays of 64-bit words are sorted as
+ * unsigned ints, signed ints or doubles by first mapping every key to
+ * an unsigned int with the same order, then running a stable LSD radix
+ * sort on the bytes. Passes where every key has the same byte are
+ * skipped, so narrow keys cost fewer passes.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  typedef enum sort_kind_t
+  {
+    SORT_UNSIGNED = 0, SORT_SIGNED, SORT_FLOAT
+  } sort_kind_t;
+
+  /**
+   * Sorts n keys, moving vals along with them if it is not NULL. The
+   * sort is stable. Returns false if out of memory, in which case the
+   * arrays are left as they were.
+   */
+  extern bool sort_words (uint64_t * keys, uint64_t * vals, uint64_t n,
+			  sort_kind_t kind, bool desc);
+
+  /**
+   * Index of the first of n sorted keys not ordered before key, which
+   * is n if there is none
+   */
+  extern uint64_t sort_lower_bound (const uint64_t * keys, uint64_t n,
+				    uint64_t key, sort_kind_t kind,
+				    bool desc);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__SORT_H__ */
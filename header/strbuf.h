@@ -0,0 +1,90 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __STRBUF_H__
+#define __STRBUF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Growable byte buffers behind opcode 57. Numbers are formatted by
+ * hand into the buffer instead of through printf, and the whole buffer
+ * goes out in one fwrite, so a report costs one stdio call per flush
+ * instead of one per field.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  typedef struct strbuf_t
+  {
+    char *data;
+    uint64_t len;
+    uint64_t cap;
+  } strbuf_t;
+
+  /**
+   * Returns a new empty buffer or NULL if out of memory
+   */
+  extern strbuf_t *strbuf_new (void);
+
+  extern void strbuf_free (strbuf_t * sb);
+
+  /*
+   * The appends return false if the buffer could not grow, in which
+   * case nothing is appended.
+   */
+
+  extern bool strbuf_putc (strbuf_t * sb, char c);
+
+  extern bool strbuf_puts (strbuf_t * sb, const char *s);
+
+  extern bool strbuf_put_i64 (strbuf_t * sb, int64_t v);
+
+  extern bool strbuf_put_u64 (strbuf_t * sb, uint64_t v);
+
+  /**
+   * Appends v in lowercase hex without leading zeros or a prefix
+   */
+  extern bool strbuf_put_hex (strbuf_t * sb, uint64_t v);
+
+  /**
+   * Appends the shortest %g style text that reads back as exactly v
+   */
+  extern bool strbuf_put_f64 (strbuf_t * sb, double v);
+
+  /**
+   * Writes the buffer to f and empties it. Returns the bytes written.
+   */
+  extern uint64_t strbuf_flush (strbuf_t * sb, FILE * f);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__STRBUF_H__ */
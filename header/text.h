@@ -0,0 +1,58 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __TEXT_H__
+#define __TEXT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Byte string helpers behind the MEM family that libc does not give
+ * us everywhere. Where it does (glibc), they forward to it since those
+ * are already tuned per instruction set.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  extern const void *text_memrchr (const void *s, int c, size_t n);
+
+  extern const void *text_memmem (const void *hay, size_t hlen,
+				  const void *needle, size_t nlen);
+
+  /**
+   * Returns the length of the longest valid UTF-8 prefix of s, which
+   * is len if the whole buffer is valid. Overlong forms, surrogates
+   * and code points past U+10FFFF are rejected.
+   */
+  extern uint64_t text_utf8_valid (const uint8_t * s, uint64_t len);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__TEXT_H__ */
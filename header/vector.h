@@ -0,0 +1,108 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __VECTOR_H__
+#define __VECTOR_H__
+
+#include "rlvm.h"
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+/*
+ * Vector instructions share opcode 43 (fvar layout):
+ *
+ *   rd  destination (vector, or int / float register for reductions)
+ *   rs  first source
+ *   rt  second source
+ *   sa  lane type in the low 3 bits, compare predicate above it
+ *   fn  operation
+ *
+ * Integer lanes are signed for MIN, MAX, CMP and when widened into an
+ * int register; ADD, SUB and MUL wrap around.
+ */
+typedef enum vec_type_t
+{
+  VEC_B = 0, VEC_W, VEC_D, VEC_Q, VEC_PS, VEC_PD
+} vec_type_t;
+
+typedef enum vec_op_t
+{
+  VEC_LD = 0,			/* vd = 32 bytes at rs (int register) */
+  VEC_ST,			/* 32 bytes at rs (int register) = vt */
+  VEC_MOV,			/* vd = vs */
+  VEC_AND,			/* vd = vs & vt */
+  VEC_OR,			/* vd = vs | vt */
+  VEC_XOR,			/* vd = vs ^ vt */
+  VEC_BLEND,			/* vd = (vd & vs) | (~vd & vt) */
+  VEC_ADD,			/* vd = vs + vt */
+  VEC_SUB,			/* vd = vs - vt */
+  VEC_MUL,			/* vd = vs * vt */
+  VEC_DIV,			/* vd = vs / vt, float lanes only */
+  VEC_MIN,			/* vd = min (vs, vt) */
+  VEC_MAX,			/* vd = max (vs, vt) */
+  VEC_FMA,			/* vd = vd + vs * vt */
+  VEC_CMP,			/* vd = vs pred vt ? all ones : 0 */
+  VEC_SHUF,			/* vd[i] = vs[vt[i] % lanes] */
+  VEC_BCST,			/* vd[i] = rs (int or float register) */
+  VEC_SUM,			/* rd = vs[0] + vs[1] + ... */
+  VEC_RMIN,			/* rd = min (vs[0], vs[1], ...) */
+  VEC_RMAX,			/* rd = max (vs[0], vs[1], ...) */
+  VEC_MASK,			/* rd (int register) = sign bit of each lane */
+  VEC_GET,			/* rd = vs[rt % lanes] (rt is an int register) */
+  VEC_SET,			/* vd[rt % lanes] = rs (rt is an int register) */
+  VEC_ABS,			/* vd = |vs| */
+  VEC_SQRT,			/* vd = sqrt (vs), float lanes only */
+  VEC_FLOOR,			/* vd = floor (vs), float lanes only */
+  VEC_CEIL,			/* vd = ceil (vs), float lanes only */
+  VEC_ROUND			/* vd = round (vs), float lanes only */
+} vec_op_t;
+
+typedef enum vec_pred_t
+{
+  VEC_EQ = 0, VEC_NE, VEC_LT, VEC_GT
+} vec_pred_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif				/* !__cplusplus */
+
+  /**
+   * Executes one vector instruction. Returns false if the operation
+   * or the lane type is not valid (the VM throws BAD_OPCODE).
+   */
+  extern bool exec_vector (rlvm_t * vm, opcode_t instr);
+
+  /**
+   * True if the lane type is one of the float types.
+   */
+  extern bool vec_is_float (unsigned int type);
+
+#ifdef __cplusplus
+}
+#endif				/* !__cplusplus */
+
+#endif /* !__VECTOR_H__ */
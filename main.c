@@ -25,17 +25,58 @@
 #include "rasm.h"
 #include "rlvm.h"
 #include "bcode.h"
+#include "runner.h"
+#include "serve.h"
+#include "filter.h"
+#include "batch.h"
 #include "getopt.h"
+#include "native.h"
+#include "parfor.h"
 
+#include <time.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef __cplusplus
 #include <stdbool.h>
 #endif /* !__cplusplus */
 
+/* NCALL clock: r0 = monotonic time in nanoseconds */
+static status_t
+native_clock (rlvm_t * vm, void *data)
+{
+  (void) data;
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  vm->iregs[0] = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  return (status_t)
+  {
+  .state = CLEAN,.uid = 0};
+}
+
+/* NCALL getenv: r0 = value of the variable named by r0, 0 if unset */
+static status_t
+native_getenv (rlvm_t * vm, void *data)
+{
+  (void) data;
+  vm->iregs[0] = (uint64_t) getenv ((const char *) vm->iregs[0]);
+  return (status_t)
+  {
+  .state = CLEAN,.uid = 0};
+}
+
+/* Removes n arguments from argv at index c, getopt never sees them */
+static void
+drop_args (int *argc, char **argv, int c, int n)
+{
+  memmove (argv + c, argv + c + n, (*argc - c - n) * sizeof (char *));
+  *argc -= n;
+  argv[*argc] = NULL;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -45,9 +86,52 @@ main (int argc, char **argv)
   size_t num_inf = 0;
   char **inf = NULL;
   char *outf = NULL;
+  size_t nthreads = 0;
+  summary_fmt_t fmt = SUMMARY_CSV;
+  char *sock = NULL;
 
+  bool filter = false;
+  bool batch = false;
+  bool each = false;
+  filter_delim_t delim = FILTER_NEWLINE;
+  size_t batch_size = 1 << 20;
+  uint64_t timeout_ms = 10000;
+  bool timed = false;
+  size_t parfor = 0;
+  bool local_opt = false;	/* Set by options --serve has no use for */
+
+  /* getopt does not know long options, pull them out by hand */
   int c;
-  while ((c = getopt (argc, argv, "crdo:h")) != -1)
+  for (c = 1; c < argc;)
+    if (strcmp (argv[c], "--serve") == 0)
+      {
+	if (c + 1 == argc)
+	  {
+	    fprintf (stderr, "error: --serve expects a socket path\n");
+	    return 2;
+	  }
+	sock = argv[c + 1];
+	drop_args (&argc, argv, c, 2);
+      }
+    else if (strcmp (argv[c], "--filter") == 0)
+      {
+	filter = true;
+	drop_args (&argc, argv, c, 1);
+      }
+    else if (strcmp (argv[c], "--batch") == 0)
+      {
+	batch = true;
+	drop_args (&argc, argv, c, 1);
+      }
+    else if (strcmp (argv[c], "--each") == 0)
+      {
+	each = true;
+	drop_args (&argc, argv, c, 1);
+      }
+    else
+      ++c;
+
+  while ((c = getopt (argc, argv, "crdo:hj:F:D:B:T:P:O")) != -1)
     switch (c)
       {
       case 'c':
@@ -61,6 +145,64 @@ main (int argc, char **argv)
 	break;
       case 'o':
 	outf = optarg;
+	local_opt = true;
+	break;
+      case 'j':
+	nthreads = strtoul (optarg, NULL, 10);
+	if (nthreads == 0)
+	  {
+	    fprintf (stderr, "error: -j expects a positive number\n");
+	    return 2;
+	  }
+	break;
+      case 'F':
+	if (strcmp (optarg, "csv") == 0)
+	  fmt = SUMMARY_CSV;
+	else if (strcmp (optarg, "json") == 0)
+	  fmt = SUMMARY_JSON;
+	else
+	  {
+	    fprintf (stderr, "error: unknown summary format %s\n", optarg);
+	    return 2;
+	  }
+	local_opt = true;
+	break;
+      case 'D':
+	if (strcmp (optarg, "nl") == 0)
+	  delim = FILTER_NEWLINE;
+	else if (strcmp (optarg, "u32") == 0)
+	  delim = FILTER_U32LE;
+	else
+	  {
+	    fprintf (stderr, "error: unknown record delimiter %s\n", optarg);
+	    return 2;
+	  }
+	local_opt = true;
+	break;
+      case 'B':
+	batch_size = strtoul (optarg, NULL, 10);
+	if (batch_size == 0)
+	  {
+	    fprintf (stderr, "error: -B expects a positive number\n");
+	    return 2;
+	  }
+	local_opt = true;
+	break;
+      case 'T':
+	timeout_ms = strtoull (optarg, NULL, 10);
+	timed = true;
+	break;
+      case 'P':
+	parfor = strtoul (optarg, NULL, 10);
+	if (parfor == 0)
+	  {
+	    fprintf (stderr, "error: -P expects a positive number\n");
+	    return 2;
+	  }
+	break;
+      case 'O':
+	optimize = true;
+	local_opt = true;
 	break;
       case 'h':
       print_help_msg:
@@ -69,12 +211,31 @@ main (int argc, char **argv)
 		"  -c    Compile assembly file (not used with -d)\n"
 		"  -r    Executes a bytecode (or assembly file if -c is used)\n"
 		"  -d    Disassembles a bytecode (not used with -c)\n"
-		"  -o    Output file (only used with -c or -d)\n"
+		"  -o    Output file (only used with -c, -d or -j)\n"
+		"  -O    Folds counted loops and tail calls (only used with -c)\n"
+		"  -j N  Runs every job of a manifest on N threads (needs -r)\n"
+		"  -F    Summary format of -j: csv (default) or json\n"
+		"  -P N  Runs PARFOR on N threads (default one per cpu)\n"
+		"  --serve SOCK\n"
+		"        Serves run requests on a Unix socket (-j sets workers)\n"
+		"  -T MS Time limit of a --serve run (default 10000, 0 is none)\n"
+		"  --filter\n"
+		"        Runs (-r) the program as a record filter on stdin\n"
+		"  -D    Records of --filter: nl (default) or u32 length prefix\n"
+		"  -B N  Bytes of input per --filter batch (default 1048576)\n"
+		"  --batch\n"
+		"        Runs (-r) the program once per line of stdin, lines\n"
+		"        holding up to 8 integers for r0 onwards, many at a time\n"
+		"  --each\n"
+		"        Same as --batch with one VM per input (for comparison)\n"
 		"  -h    Displays help\n"
 		"\n"
 		"-c will not print to the console if -o is not specified.\n"
 		"However, -d will print to the console if -o is not present."
 		"\n"
+		"-j prints its summary to the console if -o is not present.\n"
+		"Each manifest line is: program.bin [input [output]]\n"
+		"\n"
 		"For bug reporting, go to\n"
 		"<https://github.com/plankp/rlvm>.");
 	return 1;
@@ -84,6 +245,42 @@ main (int argc, char **argv)
   inf = argv + optind;
   num_inf = argc - optind;
 
+  /* Before any bytecode is loaded, loading binds the imports */
+  native_register ("clock", &native_clock, NULL);
+  native_register ("getenv", &native_getenv, NULL);
+  set_parfor_threads (parfor);
+
+  if (sock != NULL)
+    {
+      if (compile || run || dasm || num_inf != 0 || local_opt
+	  || filter || batch || each)
+	{
+	  fprintf (stderr,
+		   "error: --serve takes no other options but -j, -T and -P\n");
+	  return 2;
+	}
+      return serve (sock, nthreads, timeout_ms);
+    }
+  if (timed)
+    {
+      fprintf (stderr, "error: -T must be used with --serve\n");
+      return 2;
+    }
+  if (parfor != 0 && !run)
+    {
+      fprintf (stderr, "error: -P must be used with -r or --serve\n");
+      return 2;
+    }
+  if (filter && !run)
+    {
+      fprintf (stderr, "error: --filter must be used with -r\n");
+      return 2;
+    }
+  if ((batch || each) && (!run || filter || (batch && each)))
+    {
+      fprintf (stderr, "error: --batch or --each must be used with -r\n");
+      return 2;
+    }
   if (num_inf == 0)
     {
       fprintf (stderr, "error: no input files\n");
@@ -95,6 +292,46 @@ main (int argc, char **argv)
       return 2;
     }
 
+  if (nthreads != 0)
+    {
+      if (!run || compile || dasm || filter || batch || each)
+	{
+	  fprintf (stderr, "error: -j must be used with -r only\n");
+	  return 2;
+	}
+      FILE *summary = stdout;
+      if (outf != NULL && (summary = fopen (outf, "w")) == NULL)
+	{
+	  fprintf (stderr, "error: failed to open file %s\n", outf);
+	  return 2;
+	}
+      int ret = 0;
+      size_t i;
+      size_t nrows = 0;
+      begin_summary (summary, fmt);
+      for (i = 0; i < num_inf; ++i)
+	{
+	  FILE *f = fopen (inf[i], "r");
+	  if (f == NULL)
+	    {
+	      fprintf (stderr, "error: failed to read file %s\n", inf[i]);
+	      ret = 2;
+	      break;
+	    }
+	  const int r = run_manifest (f, nthreads, summary, fmt, &nrows);
+	  fclose (f);
+	  /* A failed job does not stop the next manifests, a bad one does */
+	  if (r != 0)
+	    ret = r;
+	  if (r == 2 || r == 3)
+	    break;
+	}
+      end_summary (summary, fmt);
+      if (summary != stdout)
+	fclose (summary);
+      return ret;
+    }
+
   bcode_t code;
   if (compile)
     {
@@ -188,6 +425,11 @@ main (int argc, char **argv)
 	{
 	  /* Read and initalize $code */
 	  FILE *f = fopen (*inf, "rb");
+	  if (f == NULL)
+	    {
+	      fprintf (stderr, "error: failed to read file %s\n", *inf);
+	      return 2;
+	    }
 	  if (read_bytecode (f, &code) == NULL)
 	    {
 	      fprintf (stderr,
@@ -197,6 +439,20 @@ main (int argc, char **argv)
 	  fclose (f);
 	}
 
+      if (batch || each)
+	{
+	  const int ret = exec_inputs (&code, stdin, stdout, batch);
+	  clean_bcode (&code);
+	  return ret;
+	}
+      if (filter)
+	{
+	  const status_t retval =
+	    exec_filter (&code, stdin, stdout, delim, batch_size);
+	  clean_bcode (&code);
+	  return retval.state;
+	}
+
       rlvm_t vm;
       const status_t retval = exec_bcode_t (&vm, &code);
       clean_rlvm (&vm);
@@ -0,0 +1,28 @@
+	# Clamps 50000000 pseudo random values to [-1000, 1000] and sums
+	# them with skip compares. See clamp.asm for the same loop
+	# written with conditional moves.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 50000000
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+	MOV r4, -1000
+	MOV r5, 1000
+	MOV r6, 0
+	MOV r10, 0
+loop:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	ADD r7, r10, r2, SRSH 52
+	SJSL r7, r4
+	MOV r7, r4
+	SJSG r7, r5
+	MOV r7, r5
+	ADD r6, r6, r7
+	DBNZ r1, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,37 @@
+	# Times a loop with the clock of the host and greets $USER
+	#
+	# NCALL reaches functions the host registered by name; the rlvm
+	# binary registers clock and getenv.
+	.STACK 1
+	.SECTION text
+main:	NCALL clock
+	MOV r5, r0
+	MOV r3, 1000
+	MUL r3, r3, r3
+spin:	DBNZ r3, spin
+	NCALL clock
+	SUB r5, r0, r5
+	LDC r1, STDOUT
+	LDC r0, hello
+	FWRTS r0, r1, r0
+	LDC r0, user
+	NCALL getenv
+	JZ r0, nobody
+	FWRTS r0, r1, r0
+	JMP took
+nobody:	LDC r0, anon
+	FWRTS r0, r1, r0
+took:	LDC r0, spent
+	FWRTS r0, r1, r0
+	FWRTQ r0, r1, r5
+	LDC r0, ns
+	FWRTS r0, r1, r0
+	MOV r0, 0
+	HALT r0
+
+	.SECTION data
+hello:	"Hello, "
+user:	"USER"
+anon:	"stranger"
+spent:	"! A million rounds took "
+ns:	" ns\n"
@@ -0,0 +1,25 @@
+	# Sums 1 to 50000000 counting down. The first loop ends the usual
+	# way and takes three dispatches per round, unless assembled with
+	# -O which folds it into DBNZ like the second loop.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 50000000
+	MOV r2, 0
+first:	ADD r2, r2, r1
+	SUB r1, r1, 1
+	JZ r1, done
+	JMP first
+done:	MOV r1, 50000000
+	MOV r3, 0
+second:	ADD r3, r3, r1
+	DBNZ r1, second
+
+	LDC r4, STDOUT
+	FWRTQ r5, r4, r2
+	MOV r5, 32
+	FWRTB r5, r4, r5
+	FWRTQ r5, r4, r3
+	MOV r5, 10
+	FWRTB r5, r4, r5
+	MOV r0, 0
+	HALT r0
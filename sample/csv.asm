@@ -0,0 +1,66 @@
+	# Sums the first two int columns of 500000 CSV records with
+	# CSVSCAN splitting 3000 fields at a time and PARSEINT reading the
+	# numbers. csv_old.asm walks the same bytes one LDB at a time.
+	.STACK 1
+	.SECTION text
+main:	MOV r21, 500000
+	MOV r22, 23
+	MUL r11, r21, r22
+	ALLOC r10, r11
+	MOV r1, r10
+	LDC r2, rec
+fill:	MEMCPY r1, r2, r22
+	ADD r1, r1, r22
+	DBNZ r21, fill
+
+	MOV r23, r10
+	MOV r14, 664108
+	MOV r13, 3000
+	MOV r12, 48000
+	ALLOC r12, r12
+	MOV r20, 4611686018427387903
+	MOV r6, 0
+	MOV r7, 0
+	MOV r8, 0
+scan:	JZ r11, done
+	CSVSCAN r15, r10, r12, r14
+	MOV r17, r12
+fields:	JZ r15, next
+	LDQ r1, [r17]+
+	LDQ r2, [r17]+
+	AND r2, r2, r20
+	SUB r2, r2, r1
+	ADD r1, r1, r10
+	PARSEINT r3, r1, r2, r4
+	ADD r6, r6, r3
+	LDQ r1, [r17]+
+	LDQ r2, [r17]+
+	AND r2, r2, r20
+	SUB r2, r2, r1
+	ADD r1, r1, r10
+	PARSEINT r3, r1, r2, r4
+	ADD r7, r7, r3
+	ADD r17, r17, 16
+	ADD r8, r8, 1
+	SUB r15, r15, 3
+	JMP fields
+next:	ADD r10, r10, r16
+	SUB r11, r11, r16
+	JMP scan
+done:	FREE r12
+	FREE r23
+
+	LDC r1, STDOUT
+	FWRTQ r0, r1, r8
+	MOV r0, 32
+	FWRTB r0, r1, r0
+	FWRTQ r0, r1, r6
+	MOV r0, 32
+	FWRTB r0, r1, r0
+	FWRTQ r0, r1, r7
+	MOV r0, 10
+	FWRTB r0, r1, r0
+	MOV r0, 0
+	HALT r0
+	.SECTION data
+rec:	db 49, db 50, db 51, db 52, db 53, db 44, db 45, db 54, db 55, db 56, db 44, db 104, db 101, db 108, db 108, db 111, db 32, db 119, db 111, db 114, db 108, db 100, db 10
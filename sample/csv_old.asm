@@ -0,0 +1,73 @@
+	# Sums the first two int columns of 500000 CSV records by reading
+	# one byte at a time and building the numbers by hand. See csv.asm
+	# for the same with CSVSCAN and PARSEINT.
+	.STACK 1
+	.SECTION text
+main:	MOV r0, 0
+	MOV r21, 500000
+	MOV r22, 23
+	MUL r11, r21, r22
+	ALLOC r10, r11
+	MOV r1, r10
+	LDC r2, rec
+fill:	MEMCPY r1, r2, r22
+	ADD r1, r1, r22
+	DBNZ r21, fill
+
+	MOV r1, r10
+	ADD r2, r10, r11
+	MOV r20, 44
+	MOV r21, 10
+	MOV r22, 45
+	MOV r3, 0
+	MOV r4, 0
+	MOV r5, 0
+	MOV r6, 0
+	MOV r7, 0
+	MOV r8, 0
+loop:	JE r1, r2, done
+	LDB r9, [r1]+
+	JE r9, r20, comma
+	JE r9, r21, comma
+	JE r9, r22, minus
+	MOV r12, 2
+	JL r3, r12, digit
+	JMP loop
+digit:	SUB r9, r9, 48
+	MUL r4, r4, r21
+	ADD r4, r4, r9
+	JMP loop
+minus:	MOV r5, 1
+	JMP loop
+comma:	JZ r5, pos
+	SUB r4, r0, r4
+pos:	JZ r3, first
+	SUB r12, r3, 1
+	JZ r12, second
+	JMP field
+first:	ADD r6, r6, r4
+	JMP field
+second:	ADD r7, r7, r4
+field:	MOV r4, 0
+	MOV r5, 0
+	ADD r3, r3, 1
+	JE r9, r20, loop
+	MOV r3, 0
+	ADD r8, r8, 1
+	JMP loop
+done:	FREE r10
+
+	LDC r1, STDOUT
+	FWRTQ r0, r1, r8
+	MOV r0, 32
+	FWRTB r0, r1, r0
+	FWRTQ r0, r1, r6
+	MOV r0, 32
+	FWRTB r0, r1, r0
+	FWRTQ r0, r1, r7
+	MOV r0, 10
+	FWRTB r0, r1, r0
+	MOV r0, 0
+	HALT r0
+	.SECTION data
+rec:	db 49, db 50, db 51, db 52, db 53, db 44, db 45, db 54, db 55, db 56, db 44, db 104, db 101, db 108, db 108, db 111, db 32, db 119, db 111, db 114, db 108, db 100, db 10
@@ -0,0 +1,32 @@
+	# Hashes and checksums a 64 MiB buffer fed 4 KiB at a time, the
+	# way records stream through a deduplication pass. hash_old.asm
+	# runs FNV-1a over the same bytes one LDB at a time.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 0x4000000
+	ALLOC r2, r1
+	MOV r3, 0x5A
+	MEMSET r2, r3, r1
+	MOV r3, 96
+	ALLOC r4, r3			# XXH64 state
+	MOV r5, 0
+	HASHINIT r4, r5
+	MOV r6, 0			# CRC32C
+	MOV r7, 4096
+	MOV r8, r2
+	MOV r9, 0x4000
+loop:	HASHUPD r4, r8, r7
+	CRC32C r6, r8, r7
+	ADD r8, r8, r7
+	DBNZ r9, loop
+	HASHFIN r5, r4
+
+	LDC r10, STDOUT
+	FWRTQ r11, r10, r5
+	MOV r11, 32
+	FWRTB r11, r10, r11
+	FWRTQ r11, r10, r6
+	MOV r11, 10
+	FWRTB r11, r10, r11
+	MOV r0, 0
+	HALT r0
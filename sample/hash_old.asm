@@ -0,0 +1,23 @@
+	# Runs FNV-1a over a 64 MiB buffer one byte at a time. See
+	# hash.asm for XXH64 and CRC32C over the same bytes.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 0x4000000
+	ALLOC r2, r1
+	MOV r3, 0x5A
+	MEMSET r2, r3, r1
+	MOV r5, 0xCBF29CE484222325
+	MOV r6, 0x100000001B3
+	MOV r8, r2
+	MOV r9, r1
+loop:	LDB r7, [r8]+
+	XOR r5, r5, r7
+	MUL r5, r5, r6
+	DBNZ r9, loop
+
+	LDC r10, STDOUT
+	FWRTQ r11, r10, r5
+	MOV r11, 10
+	FWRTB r11, r10, r11
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,37 @@
+	# Counts how often each of 2000000 pseudo random 20-bit keys
+	# comes up with the native hash map, then walks the map for the
+	# number of distinct keys and the total. MAPADD bumps a count in
+	# one lookup. map_old.asm does the same with an open addressing
+	# table written in bytecode.
+	.STACK 1
+	.SECTION text
+main:	MAPNEW r10
+	MOV r11, 1
+	MOV r16, 44
+	MOV r1, 2000000
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+loop:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	RSH r4, r2, r16
+	MAPADD r5, r10, r4, r11
+	DBNZ r1, loop
+
+	MAPLEN r6, r10
+	MOV r1, 0
+	MOV r7, 0
+walk:	MAPNEXT r1, r10, r4, r5
+	JZ r1, done
+	ADD r7, r7, r5
+	JMP walk
+done:	MAPFREE r10
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 32
+	FWRTB r9, r8, r9
+	FWRTQ r9, r8, r7
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,57 @@
+	# Counts how often each of 2000000 pseudo random 20-bit keys
+	# comes up with a linear probing table of 2^21 key / count pairs
+	# in bytecode (keys are stored plus one so 0 marks an empty slot).
+	# See map.asm for the same count with the native hash map.
+	.STACK 1
+	.SECTION text
+main:	MOV r0, 33554432
+	ALLOC r10, r0
+	MOV r11, 0
+	MOV r16, 44
+	MOV r17, 43
+	MEMSET r10, r11, r0
+	MOV r14, 2097151
+	MOV r15, 11400714819323198485
+	MOV r6, 0
+	MOV r1, 2000000
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+loop:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	RSH r4, r2, r16
+	ADD r4, r4, 1
+	MUL r8, r4, r15
+	RSH r8, r8, r17
+probe:	ADD r12, r10, r8, LSH 4
+	LDQ r13, [r12]
+	JE r13, r4, hit
+	JZ r13, new
+	ADD r8, r8, 1
+	AND r8, r8, r14
+	JMP probe
+new:	STQ r4, [r12]
+	ADD r6, r6, 1
+hit:	LDQ r5, [r12]+
+	LDQ r5, [r12]
+	ADD r5, r5, 1
+	STQ r5, [r12]
+	DBNZ r1, loop
+
+	MOV r7, 0
+	MOV r1, 2097152
+	MOV r12, r10
+walk:	LDQ r13, [r12]+
+	LDQ r5, [r12]+
+	ADD r7, r7, r5
+	DBNZ r1, walk
+	FREE r10
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 32
+	FWRTB r9, r8, r9
+	FWRTQ r9, r8, r7
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
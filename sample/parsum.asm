@@ -0,0 +1,21 @@
+	# SUM OF SQUARES BELOW R1, ONE CHUNK PER HOST THREAD
+
+	.SECTION TEXT
+	.STACK 1
+	.ESTACK 0
+START:	MOV R0, 0
+	MOV R1, 1000
+	MOV R5, 0
+	PRED ADD, R5
+	PARFOR R0, R1, CHUNK
+	LDC R2, STDOUT
+	FWRTQ R3, R2, R5
+	MOV R0, 0xA
+	FWRTB R3, R2, R0
+	HALT R31
+CHUNK:	JE R0, R1, _END
+	MUL R4, R0, R0
+	ADD R5, R5, R4
+	ADD R0, R0, 1
+	JMP CHUNK
+_END:	RET
@@ -0,0 +1,21 @@
+	# Counts the set bits of 20000000 pseudo random words with one
+	# POPCNT each. popcount_old.asm clears the lowest set bit in a
+	# loop instead, which takes about 32 rounds per word.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 20000000
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+	MOV r6, 0
+loop:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	POPCNT r7, r2
+	ADD r6, r6, r7
+	DBNZ r1, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
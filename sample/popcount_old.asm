@@ -0,0 +1,25 @@
+	# Counts the set bits of 20000000 pseudo random words by clearing
+	# the lowest set bit until none is left. See popcount.asm for the
+	# same count with POPCNT.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 20000000
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+	MOV r6, 0
+loop:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	MOV r7, r2
+bits:	JZ r7, next
+	SUB r8, r7, 1
+	AND r7, r7, r8
+	ADD r6, r6, 1
+	JMP bits
+next:	DBNZ r1, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
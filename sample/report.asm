@@ -0,0 +1,33 @@
+	# Writes 500000 lines of a number, its square and an eighth of it
+	# by appending the fields to a string builder and flushing it every
+	# 64K. report_old.asm writes every field with its own stdio call.
+	.STACK 1
+	.SECTION text
+main:	LDC r8, STDOUT
+	SBNEW r10
+	MOV r1, 500000
+	MOV r2, 0
+	MOV r12, 65536
+	MOV r13, 9
+	MOV r14, 10
+	MOV r3, 8
+	I2F fp3, r3
+loop:	ADD r2, r2, 1
+	MUL r3, r2, r2
+	I2F fp1, r2
+	DIV fp1, fp1, fp3
+	SBINT r10, r2
+	SBCHR r10, r13
+	SBINT r10, r3
+	SBCHR r10, r13
+	SBFLT r10, fp1
+	SBCHR r10, r14
+	SBLEN r4, r10
+	JL r4, r12, next
+	SBFLUSH r4, r10, r8
+next:	DBNZ r1, loop
+
+	SBFLUSH r4, r10, r8
+	SBFREE r10
+	MOV r0, 0
+	HALT r0
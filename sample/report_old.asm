@@ -0,0 +1,26 @@
+	# Writes 500000 lines of a number, its square and an eighth of it
+	# with one stdio call per field. See report.asm for the same lines
+	# built in a string builder.
+	.STACK 1
+	.SECTION text
+main:	LDC r8, STDOUT
+	MOV r1, 500000
+	MOV r2, 0
+	MOV r13, 9
+	MOV r14, 10
+	MOV r3, 8
+	I2F fp3, r3
+loop:	ADD r2, r2, 1
+	MUL r3, r2, r2
+	I2F fp1, r2
+	DIV fp1, fp1, fp3
+	FWRTQ r4, r8, r2
+	FWRTB r4, r8, r13
+	FWRTQ r4, r8, r3
+	FWRTB r4, r8, r13
+	FWRTQ r4, r8, fp1
+	FWRTB r4, r8, r14
+	DBNZ r1, loop
+
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,25 @@
+	# Calls a function that keeps r1-r8 and fp1-fp4 intact 10000000
+	# times. SAVE and RESTORE move all twelve registers in one step
+	# each, save_old.asm takes nine instructions each way.
+	.STACK 32
+	.SECTION text
+main:	MOV r10, 10000000
+	MOV r11, 0
+loop:	CALL work
+	DBNZ r10, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r11
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
+
+	# work: r11 += 3, using r1-r8 and fp1-fp4 as scratch
+work:	SAVE r1-r8, fp1-fp4
+	MOV r1, 1
+	MOV r2, 2
+	ADD r11, r11, r1
+	ADD r11, r11, r2
+	RESTORE r1-r8, fp1-fp4
+	RET
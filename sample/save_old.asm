@@ -0,0 +1,40 @@
+	# save.asm with the registers kept by PUSH / POP and the float
+	# registers by STFBS / LDS one at a time.
+	.STACK 32
+	.SECTION text
+main:	MOV r10, 10000000
+	MOV r11, 0
+loop:	CALL work
+	DBNZ r10, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r11
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
+
+	# work: r11 += 3, using r1-r8 and fp1-fp4 as scratch
+work:	PUSH r1, r2, r3
+	PUSH r4, r5, r6
+	PUSH r7, r8
+	PUSH r9, r9, r9
+	PUSH r9
+	STFBS fp1, -4
+	STFBS fp2, -3
+	STFBS fp3, -2
+	STFBS fp4, -1
+	MOV r1, 1
+	MOV r2, 2
+	ADD r11, r11, r1
+	ADD r11, r11, r2
+	LDS fp1, -4
+	LDS fp2, -3
+	LDS fp3, -2
+	LDS fp4, -1
+	POP r9
+	POP r9, r9, r9
+	POP r7, r8
+	POP r4, r5, r6
+	POP r1, r2, r3
+	RET
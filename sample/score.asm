@@ -0,0 +1,21 @@
+	# Scores an input: 48 rounds of xorshift-multiply mixing of r0,
+	# halting with the number of rounds that left r0 odd.
+	#
+	# Meant for many inputs at once, one integer per line of stdin
+	#
+	#     seq 1000000 | rlvm -r --batch score.bin
+	#
+	# --each runs the same inputs one VM at a time.
+	.SECTION text
+main:	MOV r2, 48
+	MOV r3, 0
+	MOV r4, 0x9E3779B97F4A7C15
+mix:	XOR r0, r0, r0, RSH 29
+	MUL r0, r0, r4
+	AND r5, r0, 1
+	JZ r5, even
+	ADD r3, r3, 1
+even:	SUB r2, r2, 1
+	JZ r2, done
+	JMP mix
+done:	HALT r3
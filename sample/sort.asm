@@ -0,0 +1,43 @@
+	# Sorts 1000000 pseudo random words with one SORT, checks the
+	# order and uses LBOUND to count the words below 2^63. sort_old.asm
+	# does the same with a heap sort and a binary search in bytecode.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 1000000
+	MOV r11, 0
+	ADD r0, r11, r1, LSH 3
+	ALLOC r10, r0
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+	MOV r4, r10
+	MOV r5, r1
+fill:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	STQ r2, [r4]+
+	DBNZ r5, fill
+
+	SORT r10, r1
+
+	MOV r6, 0
+	MOV r4, r10
+	LDQ r7, [r4]+
+	SUB r5, r1, 1
+check:	LDQ r8, [r4]+
+	SETL r9, r8, r7
+	ADD r6, r6, r9
+	MOV r7, r8
+	DBNZ r5, check
+
+	MOV r12, 9223372036854775808
+	LBOUND r4, r10, r1, r12
+	FREE r10
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 32
+	FWRTB r9, r8, r9
+	FWRTQ r9, r8, r4
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
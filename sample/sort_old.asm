@@ -0,0 +1,93 @@
+	# Sorts 1000000 pseudo random words with a heap sort in bytecode,
+	# checks the order and counts the words below 2^63 with a binary
+	# search. See sort.asm for the same with SORT and LBOUND.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 1000000
+	MOV r11, 0
+	ADD r0, r11, r1, LSH 3
+	ALLOC r10, r0
+	MOV r2, 12345
+	MOV r3, 6364136223846793005
+	MOV r4, r10
+	MOV r5, r1
+fill:	MUL r2, r2, r3
+	ADD r2, r2, 1
+	STQ r2, [r4]+
+	DBNZ r5, fill
+
+	# Builds the heap from the last parent down
+	ADD r13, r11, r1, RSH 1
+	MOV r5, r1
+heap:	SUB r13, r13, 1
+	MOV r4, r13
+	CALL sift
+	JZ r13, sorted
+	JMP heap
+	# Moves the largest word to the end and sifts the new root
+sorted:	SUB r5, r5, 1
+	JZ r5, done
+	LDQ r7, [r10]
+	LDQ r8, [r10 + r5*8]
+	STQ r8, [r10]
+	STQ r7, [r10 + r5*8]
+	MOV r4, 0
+	CALL sift
+	JMP sorted
+
+	# Sifts the word at r4 down the heap of the first r5 words
+sift:	ADD r6, r4, r4
+	ADD r6, r6, 1
+	JL r6, r5, left
+	RET
+left:	LDQ r7, [r10 + r6*8]
+	ADD r8, r6, 1
+	JL r8, r5, right
+	JMP cmp
+right:	LDQ r9, [r10 + r8*8]
+	JL r7, r9, pick
+	JMP cmp
+pick:	MOV r6, r8
+	MOV r7, r9
+cmp:	LDQ r12, [r10 + r4*8]
+	JL r12, r7, swap
+	RET
+swap:	STQ r7, [r10 + r4*8]
+	STQ r12, [r10 + r6*8]
+	MOV r4, r6
+	JMP sift
+
+done:	MOV r6, 0
+	MOV r4, r10
+	LDQ r7, [r4]+
+	SUB r5, r1, 1
+check:	LDQ r8, [r4]+
+	SETL r9, r8, r7
+	ADD r6, r6, r9
+	MOV r7, r8
+	DBNZ r5, check
+
+	MOV r12, 9223372036854775808
+	MOV r4, 0
+	MOV r5, r1
+search:	JL r4, r5, probe
+	JMP found
+probe:	ADD r13, r4, r5
+	ADD r13, r11, r13, RSH 1
+	LDQ r7, [r10 + r13*8]
+	JL r7, r12, above
+	MOV r5, r13
+	JMP search
+above:	ADD r4, r13, 1
+	JMP search
+found:	FREE r10
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r6
+	MOV r9, 32
+	FWRTB r9, r8, r9
+	FWRTQ r9, r8, r4
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,20 @@
+	# Sums the square roots of 1 to 5000000 with SQRT, a single
+	# instruction. sqrt_old.asm gets the same sum from a bit trick
+	# guess and four Newton steps per root in bytecode.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 5000000
+	MOV r2, 0
+	I2F fp2, r2
+loop:	ADD r2, r2, 1
+	I2F fp1, r2
+	SQRT fp1, fp1
+	ADD fp2, fp2, fp1
+	DBNZ r1, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, fp2
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,38 @@
+	# Sums the square roots of 1 to 5000000 in bytecode: halving the
+	# exponent bits gives a guess within a few percent, then four
+	# Newton steps g = (g + x / g) / 2 make it exact. See sqrt.asm for
+	# the same sum with SQRT.
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 5000000
+	MOV r2, 0
+	I2F fp2, r2
+	MOV r4, 2
+	I2F fp4, r4
+	MOV r5, 2303591209400008704
+loop:	ADD r2, r2, 1
+	I2F fp1, r2
+	F2B r7, fp1
+	ADD r7, r5, r7, RSH 1
+	B2F fp3, r7
+	DIV fp5, fp1, fp3
+	ADD fp3, fp3, fp5
+	DIV fp3, fp3, fp4
+	DIV fp5, fp1, fp3
+	ADD fp3, fp3, fp5
+	DIV fp3, fp3, fp4
+	DIV fp5, fp1, fp3
+	ADD fp3, fp3, fp5
+	DIV fp3, fp3, fp4
+	DIV fp5, fp1, fp3
+	ADD fp3, fp3, fp5
+	DIV fp3, fp3, fp4
+	ADD fp2, fp2, fp3
+	DBNZ r1, loop
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, fp2
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
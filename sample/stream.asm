@@ -0,0 +1,38 @@
+	# Streaming benchmark: b[i] = a[i] + 1 over two 512 MiB arrays of
+	# quads, bigger than the last-level cache, 2 passes. The loads and
+	# stores step their own pointer. Compare with
+	#   time rlvm -cr sample/stream.asm
+	#   time rlvm -cr sample/stream_old.asm
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 0x4000000	# Elements (64 Mi)
+	MOV r2, 0x20000000	# Bytes per array
+	ALLOC r3, r2		# a
+	ALLOC r4, r2		# b
+	MEMSET r3, r0, r2
+	ADD r5, r3, r2		# End of a
+
+	MOV r6, 0
+	MOV r7, 2		# Passes
+pass:	MOV r8, r3
+	MOV r9, r4
+copy:	LDQ r10, [r8]+
+	ADD r10, r10, 1
+	STQ r10, [r9]+
+	JL r8, r5, copy
+	MOV r11, r3		# Swap a and b
+	MOV r3, r4
+	MOV r4, r11
+	ADD r5, r3, r2
+	ADD r6, r6, 1
+	JL r6, r7, pass
+
+	LDQ r10, [r3]		# Every element is 2 now
+	LDC r12, STDOUT
+	FWRTQ r13, r12, r10
+	MOV r13, 10
+	FWRTB r13, r12, r13
+	FREE r3
+	FREE r4
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,42 @@
+	# A toy bytecode interpreter: runs a 16 op program 2000000 times,
+	# dispatching every op with one SWITCH through a jump table.
+	# switch_old.asm walks a chain of JE instead.
+	.STACK 1
+	.SECTION data
+prog:	db 0, db 3, db 1, db 5, db 2, db 4, db 6, db 0
+	db 7, db 3, db 5, db 2, db 6, db 1, db 4, db 8
+ops:	.JUMPTABLE bad, inc, dec, dbl, add3, xor5, neg, shr, sub1, end
+
+	.SECTION text
+main:	MOV r1, 2000000
+	MOV r2, 0			# accumulator
+	MOV r10, 1
+run:	LDC r3, prog
+next:	LDB r4, [r3]+
+	SWITCH r4, ops
+inc:	ADD r2, r2, 1
+	JMP next
+dec:	SUB r2, r2, 1
+	JMP next
+dbl:	ADD r2, r2, r2
+	JMP next
+add3:	ADD r2, r2, 3
+	JMP next
+xor5:	XOR r2, r2, 5
+	JMP next
+neg:	NOT r2, r2
+	JMP next
+shr:	RSH r2, r2, r10
+	JMP next
+sub1:	SUB r2, r2, 1
+	JMP next
+end:	DBNZ r1, run
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r2
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
+bad:	MOV r0, 1
+	HALT r0
@@ -0,0 +1,58 @@
+	# The interpreter of switch.asm dispatching through a chain of JE,
+	# which takes up to nine compares per op instead of one SWITCH.
+	.STACK 1
+	.SECTION data
+prog:	db 0, db 3, db 1, db 5, db 2, db 4, db 6, db 0
+	db 7, db 3, db 5, db 2, db 6, db 1, db 4, db 8
+
+	.SECTION text
+main:	MOV r1, 2000000
+	MOV r2, 0			# accumulator
+	MOV r10, 1
+	MOV r11, 0
+	MOV r12, 1
+	MOV r13, 2
+	MOV r14, 3
+	MOV r15, 4
+	MOV r16, 5
+	MOV r17, 6
+	MOV r18, 7
+	MOV r19, 8
+run:	LDC r3, prog
+next:	LDB r4, [r3]+
+	JE r4, r11, inc
+	JE r4, r12, dec
+	JE r4, r13, dbl
+	JE r4, r14, add3
+	JE r4, r15, xor5
+	JE r4, r16, neg
+	JE r4, r17, shr
+	JE r4, r18, sub1
+	JE r4, r19, end
+	JMP bad
+inc:	ADD r2, r2, 1
+	JMP next
+dec:	SUB r2, r2, 1
+	JMP next
+dbl:	ADD r2, r2, r2
+	JMP next
+add3:	ADD r2, r2, 3
+	JMP next
+xor5:	XOR r2, r2, 5
+	JMP next
+neg:	NOT r2, r2
+	JMP next
+shr:	RSH r2, r2, r10
+	JMP next
+sub1:	SUB r2, r2, 1
+	JMP next
+end:	DBNZ r1, run
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r2
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
+bad:	MOV r0, 1
+	HALT r0
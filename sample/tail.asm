@@ -0,0 +1,26 @@
+	# Sums 1 to 10000000 with a recursive accumulator function in a
+	# 16 word stack. Each level pushes a scratch word and drops it
+	# with TAILCALL, so the depth never shows on the stack.
+	#
+	# This is about stack space, not speed: MARK and PUSH cost two
+	# more instructions per level than tail_old.asm, which runs in
+	# 0.19 s plain and 0.15 s with -O against 0.20 s for this one.
+	.STACK 16
+	.SECTION text
+main:	MOV r1, 10000000
+	MOV r2, 0
+	CALL sum
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r2
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
+	# sum(r1, r2): r2 += r1 + ... + 1
+sum:	MARK r10
+	JZ r1, done
+	PUSH r1
+	ADD r2, r2, r1
+	SUB r1, r1, 1
+	TAILCALL r10, sum
+done:	RET
@@ -0,0 +1,20 @@
+	# sum of tail.asm with CALL / RET, which needs a stack as deep as
+	# the recursion. Assembled with -O the CALL / RET becomes a
+	# TAILCALL and the program also runs in a 16 word stack.
+	.STACK 10000016
+	.SECTION text
+main:	MOV r1, 10000000
+	MOV r2, 0
+	CALL sum
+	LDC r8, STDOUT
+	FWRTQ r9, r8, r2
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	MOV r0, 0
+	HALT r0
+	# sum(r1, r2): r2 += r1 + ... + 1
+sum:	JZ r1, done
+	ADD r2, r2, r1
+	SUB r1, r1, 1
+	CALL sum
+done:	RET
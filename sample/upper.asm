@@ -0,0 +1,39 @@
+	# Upper-cases every line of stdin in filter mode
+	#   rlvm -cr --filter sample/upper.asm < in.txt
+	.STACK 4
+	.SECTION text
+main:	MOV r0, batch		# Tell the host where the batch entry is
+	HALT r0
+
+	# r0 = record table (address, length), r1 = number of records
+	# r2 = output buffer, r3 = output size
+batch:	MOV r4, 0		# Bytes written
+	MOV r5, 0		# Records consumed
+	MOV r14, 26
+next:	JE r5, r1, done
+	LDQ r6, r0, 0
+	LDQ r7, r0, 8
+	ADD r8, r4, r7
+	ADD r8, r8, 1
+	JG r8, r3, done		# No room left, hand the rest back
+	ADD r9, r6, r7		# End of the record
+copy:	JE r6, r9, eol
+	LDB r11, r6, 0
+	SUB r13, r11, 97	# 'a' <= r11 <= 'z'
+	SJL r13, r14
+	SUB r11, r11, 32
+	ADD r12, r2, r4
+	STB r11, r12, 0
+	ADD r4, r4, 1
+	ADD r6, r6, 1
+	JMP copy
+eol:	MOV r11, 10
+	ADD r12, r2, r4
+	STB r11, r12, 0
+	ADD r4, r4, 1
+	ADD r5, r5, 1
+	ADD r0, r0, 16
+	JMP next
+done:	MOV r0, r4
+	MOV r1, r5
+	RET
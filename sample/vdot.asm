@@ -0,0 +1,55 @@
+	# Dot product of two 4096 element double arrays, 4 lanes at a time
+	#   a[i] = i, b[i] = 2, so it prints 2 * (0 + 1 + ... + 4095)
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 4096		# Elements
+	MOV r3, 32768		# Bytes per array
+	ALLOC r2, r3
+	ALLOC r4, r3
+
+	# v0 = (0, 1, 2, 3), v1 = (4, 4, 4, 4), v2 = (2, 2, 2, 2)
+	MOV r6, 0
+	MOV r7, 4
+lanes:	I2F fp1, r6
+	VSET.PD v0, fp1, r6
+	ADD r6, r6, 1
+	JL r6, r7, lanes
+	I2F fp1, r7
+	VBCST.PD v1, fp1
+	MOV r6, 2
+	I2F fp1, r6
+	VBCST.PD v2, fp1
+
+	MOV r5, 0
+	MOV r8, r2
+	MOV r9, r4
+fill:	JE r5, r1, filled
+	VST v0, r8
+	VST v2, r9
+	VADD.PD v0, v0, v1
+	ADD r8, r8, 32
+	ADD r9, r9, 32
+	ADD r5, r5, 4
+	JMP fill
+
+filled:	XOR v3, v3, v3
+	MOV r5, 0
+	MOV r8, r2
+	MOV r9, r4
+dot:	JE r5, r1, done
+	VLD v4, r8
+	VLD v5, r9
+	VFMA.PD v3, v4, v5
+	ADD r8, r8, 32
+	ADD r9, r9, 32
+	ADD r5, r5, 4
+	JMP dot
+
+done:	VSUM.PD fp0, v3
+	LDC r10, STDOUT
+	FWRTQ r11, r10, fp0
+	MOV r0, 0xA
+	FWRTB r11, r10, r0
+	FREE r2
+	FREE r4
+	HALT r31
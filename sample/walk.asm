@@ -0,0 +1,48 @@
+	# Array walking benchmark with indexed addressing: 2000 passes of
+	# y[i] += 3 * x[i] over 4096 doubles, then sums y. Compare with
+	#   time rlvm -cr sample/walk.asm
+	#   time rlvm -cr sample/walk_old.asm
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 4096		# Elements
+	MOV r2, 32768		# Bytes per array
+	ALLOC r3, r2		# x
+	ALLOC r4, r2		# y
+
+	MOV r5, 0
+fill:	I2F fp1, r5
+	STQ fp1, [r3 + r5*8]
+	MOV fp1, 1.0
+	STQ fp1, [r4 + r5*8]
+	ADD r5, r5, 1
+	JL r5, r1, fill
+
+	MOV fp0, 3.0
+	MOV r6, 0
+	MOV r7, 2000		# Rounds
+round:	MOV r5, 0
+axpy:	LDQ fp1, [r3 + r5*8]
+	LDQ fp2, [r4 + r5*8]
+	MUL fp1, fp1, fp0
+	ADD fp2, fp2, fp1
+	STQ fp2, [r4 + r5*8]
+	ADD r5, r5, 1
+	JL r5, r1, axpy
+	ADD r6, r6, 1
+	JL r6, r7, round
+
+	MOV r5, 0
+	MOV fp3, 0
+sum:	LDQ fp1, [r4 + r5*8]
+	ADD fp3, fp3, fp1
+	ADD r5, r5, 1
+	JL r5, r1, sum
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, fp3
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	FREE r3
+	FREE r4
+	MOV r0, 0
+	HALT r0
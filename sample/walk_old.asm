@@ -0,0 +1,60 @@
+	# Same as walk.asm, computing every address by hand
+	.STACK 1
+	.SECTION text
+main:	MOV r1, 4096		# Elements
+	MOV r2, 32768		# Bytes per array
+	ALLOC r3, r2		# x
+	ALLOC r4, r2		# y
+	MOV r13, 3		# log2 of the element size
+
+	MOV r5, 0
+fill:	LSH r10, r5, r13
+	I2F fp1, r5
+	F2B r12, fp1
+	ADD r11, r3, r10
+	STQ r12, r11, 0
+	MOV fp1, 1.0
+	F2B r12, fp1
+	ADD r11, r4, r10
+	STQ r12, r11, 0
+	ADD r5, r5, 1
+	JL r5, r1, fill
+
+	MOV fp0, 3.0
+	MOV r6, 0
+	MOV r7, 2000		# Rounds
+round:	MOV r5, 0
+axpy:	LSH r10, r5, r13
+	ADD r11, r3, r10
+	LDQ r12, r11, 0
+	B2F fp1, r12
+	ADD r11, r4, r10
+	LDQ r12, r11, 0
+	B2F fp2, r12
+	MUL fp1, fp1, fp0
+	ADD fp2, fp2, fp1
+	F2B r12, fp2
+	STQ r12, r11, 0
+	ADD r5, r5, 1
+	JL r5, r1, axpy
+	ADD r6, r6, 1
+	JL r6, r7, round
+
+	MOV r5, 0
+	MOV fp3, 0
+sum:	LSH r10, r5, r13
+	ADD r11, r4, r10
+	LDQ r12, r11, 0
+	B2F fp1, r12
+	ADD fp3, fp3, fp1
+	ADD r5, r5, 1
+	JL r5, r1, sum
+
+	LDC r8, STDOUT
+	FWRTQ r9, r8, fp3
+	MOV r9, 10
+	FWRTB r9, r8, r9
+	FREE r3
+	FREE r4
+	MOV r0, 0
+	HALT r0
@@ -0,0 +1,943 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "batch.h"
+#include "simd.h"
+#include "bits.h"
+#include "runner.h"
+
+#include <string.h>
+
+static inline int64_t
+__pad_sign_bit (uint64_t x, size_t width)
+{
+  const uint64_t max_val = 1 << --width;
+  return (x & (max_val - 1)) - max_val * ((x >> (width)) & 1);
+}
+
+static inline uint64_t
+__rotate_left (uint64_t x, size_t times)
+{
+  if (times % 64 == 0)
+    return x;
+  return x << times | x >> (64 - times);
+}
+
+static inline uint64_t
+__rotate_right (uint64_t x, size_t times)
+{
+  if (times % 64 == 0)
+    return x;
+  return x >> times | x << (64 - times);
+}
+
+bool
+init_batch (rlvm_batch_t * batch, uint64_t lanes, uint64_t stack_size,
+	    uint64_t handler_size, char *pool)
+{
+  memset (batch, 0, sizeof (rlvm_batch_t));
+  batch->lanes = lanes > BATCH_LANES ? BATCH_LANES : lanes;
+  batch->stack_size = stack_size;
+  batch->handler_size = handler_size;
+  batch->ropool = pool;
+  batch->fin = stdin;
+  batch->fout = stdout;
+  batch->ferr = stderr;
+  if (stack_size == 0)
+    return true;
+  batch->stack = calloc (stack_size * BATCH_LANES, sizeof (uint64_t));
+  return batch->stack != NULL;
+}
+
+void
+clean_batch (rlvm_batch_t * batch)
+{
+  free (batch->stack);
+  batch->stack = NULL;
+  batch->stack_size = 0;
+  batch->lanes = 0;
+}
+
+/*
+ * Finishes one lane on a regular VM starting at the instruction the
+ * lane is currently at. This is how faults, exception handlers and
+ * everything else the batch interpreter does not handle are run. The
+ * vector registers stay zero as in a fresh VM: every VEC op peels, so
+ * a lane never touches them before it gets here. Lanes peel in the
+ * order they branch, so a buffered batch keeps what each one writes
+ * in lane_buf until the caller can write it out in lane order.
+ */
+static void
+peel_lane (rlvm_batch_t * b, size_t lane, const uint64_t len,
+	   opcode_t * ops)
+{
+  rlvm_t vm = init_rlvm (b->stack_size, b->handler_size, b->ropool);
+  vm.fin = b->fin;
+  vm.fout = b->fout;
+  if (b->buffered)
+    {
+      FILE *f = open_memstream (&b->lane_buf[lane], &b->lane_len[lane]);
+      if (f != NULL)
+	vm.fout = f;
+    }
+  vm.ferr = b->ferr;
+  vm.natives = b->natives;
+  vm.native_count = b->native_count;
+  size_t i;
+  for (i = 0; i < ALLOC_REGS_COUNT; ++i)
+    {
+      vm.iregs[i] = b->iregs[i][lane];
+      vm.fregs[i] = b->fregs[i][lane];
+    }
+  for (i = 0; i < b->sp[lane]; ++i)
+    vm.stack[i] = b->stack[i * BATCH_LANES + lane];
+  vm.sp = b->sp[lane];
+  vm.ip = b->ip[lane];
+
+  b->state[lane] = exec_bytecode (&vm, len, ops);
+
+  for (i = 0; i < ALLOC_REGS_COUNT; ++i)
+    {
+      b->iregs[i][lane] = vm.iregs[i];
+      b->fregs[i][lane] = vm.fregs[i];
+    }
+  b->ip[lane] = vm.ip;
+  b->sp[lane] = vm.sp;
+  if (vm.fout != b->fout)
+    fclose (vm.fout);
+  clean_rlvm (&vm);
+}
+
+#define FOR_LANES for (l = 0; l < BATCH_LANES; ++l)
+
+/* Writes expr into dst on the active lanes only */
+#define LANE_SET(dst, expr)			\
+  FOR_LANES					\
+    dst[l] = m[l] ? (expr) : dst[l]
+
+/* Moves the active lanes where cond holds to the regular VM */
+#define PEEL_IF(cond)				\
+  FOR_LANES					\
+    if (m[l] && (cond))				\
+      {						\
+	b->ip[l] = pc;				\
+	peel_lane (b, l, len, ops);		\
+	live[l] = m[l] = 0;			\
+	conv = false;				\
+      }
+
+/* Evaluates a compare flag of opcode 38 or 49 on every lane */
+static inline void
+__compare (const rlvm_batch_t * b, unsigned int flag, size_t rs, size_t rt,
+	   uint64_t * out)
+{
+  const uint64_t *irs = b->iregs[rs];
+  const uint64_t *irt = b->iregs[rt];
+  const double *frs = b->fregs[rs];
+  const double *frt = b->fregs[rt];
+  size_t l;
+  switch (flag & 0xB)
+    {
+    case RLVM_CC_EQ:
+      FOR_LANES out[l] = irs[l] == irt[l];
+      break;
+    case RLVM_CC_LT:
+      if (flag & RLVM_CC_SIGNED)
+	FOR_LANES out[l] = (int64_t) irs[l] < (int64_t) irt[l];
+      else
+	FOR_LANES out[l] = irs[l] < irt[l];
+      break;
+    case RLVM_CC_GT:
+      if (flag & RLVM_CC_SIGNED)
+	FOR_LANES out[l] = (int64_t) irs[l] > (int64_t) irt[l];
+      else
+	FOR_LANES out[l] = irs[l] > irt[l];
+      break;
+    case RLVM_CC_ZERO:
+      FOR_LANES out[l] = irs[l] == 0;
+      break;
+    case RLVM_CC_FP | RLVM_CC_EQ:
+      FOR_LANES out[l] = frs[l] == frt[l];
+      break;
+    case RLVM_CC_FP | RLVM_CC_LT:
+      FOR_LANES out[l] = frs[l] < frt[l];
+      break;
+    case RLVM_CC_FP | RLVM_CC_GT:
+      FOR_LANES out[l] = frs[l] > frt[l];
+      break;
+    case RLVM_CC_FP | RLVM_CC_ZERO:
+      FOR_LANES out[l] = frs[l] == 0;
+      break;
+    }
+}
+
+SIMD_DISPATCH void
+exec_batch (rlvm_batch_t * b, const uint64_t len, opcode_t * ops)
+{
+  uint64_t live[BATCH_LANES];	/* ~0 while the lane is running */
+  uint64_t m[BATCH_LANES];	/* ~0 if the lane runs this instruction */
+  uint64_t nip[BATCH_LANES];	/* Per lane successor after a branch */
+  uint64_t tmp[BATCH_LANES];
+  uint64_t pc = 0;
+  bool conv = false;		/* All running lanes are at pc */
+  size_t l;
+
+  FOR_LANES live[l] = l < b->lanes ? ~(uint64_t) 0 : 0;
+  goto reschedule;
+
+  for (;;)
+    {
+      const opcode_t instr = ops[pc];
+      uint64_t target = pc + 1;
+      switch (instr.fvar.opcode)
+	{
+	case 0:
+	  switch (instr.fvar.fn)
+	    {
+	    case 0:		/* op: HALT rs: r# */
+	      FOR_LANES if (m[l])
+		{
+		  b->state[l] = (status_t)
+		  {
+		  .state = CLEAN,.uid = b->iregs[instr.fvar.rs][l]};
+		  b->ip[l] = pc;
+		  live[l] = m[l] = 0;
+		}
+	      goto reschedule;
+	    case 1:		/* op: MRI rs: r# rd: r# sa: acc */
+	      {
+		uint64_t *rd = b->iregs[instr.fvar.rd];
+		const uint64_t *rs = b->iregs[instr.fvar.rs];
+		switch (instr.fvar.sa)
+		  {
+		  case 0:
+		    LANE_SET (rd, rs[l]);
+		    break;
+		  case 1:
+		    LANE_SET (rd, (rs[l] & 0xFFFFFFFF00000000) |
+			      (rd[l] & 0xFFFFFFFF));
+		    break;
+		  case 2:
+		    LANE_SET (rd, (rd[l] & 0xFFFFFFFF00000000) |
+			      (rs[l] & 0xFFFFFFFF));
+		    break;
+		  case 3:
+		    LANE_SET (rd, (rd[l] & 0xFFFFFFFFFFFF0000) |
+			      (rs[l] & 0xFFFF));
+		    break;
+		  case 4:
+		    LANE_SET (rd, (rd[l] & 0xFFFFFFFFFFFFFF00) |
+			      (rs[l] & 0xFF));
+		    break;
+		  }
+		break;
+	      }
+	    case 2:		/* op: MRF rs: r# rd: r# */
+	      {
+		double *rd = b->fregs[instr.fvar.rd];
+		const double *rs = b->fregs[instr.fvar.rs];
+		LANE_SET (rd, rs[l]);
+		break;
+	      }
+	    case 3:		/* op: SWPI rs: r# rd: r# */
+	      {
+		uint64_t *rd = b->iregs[instr.fvar.rd];
+		uint64_t *rs = b->iregs[instr.fvar.rs];
+		if (rd == rs)
+		  break;
+		FOR_LANES tmp[l] = rd[l];
+		LANE_SET (rd, rs[l]);
+		LANE_SET (rs, tmp[l]);
+		break;
+	      }
+	    case 4:		/* op: ITF rs: r# rd: r# rt specifying mode */
+	      {
+		double *rd = b->fregs[instr.fvar.rd];
+		const uint64_t *rs = b->iregs[instr.fvar.rs];
+		switch (instr.fvar.rt)
+		  {
+		  case 0:
+		    LANE_SET (rd, (int64_t) rs[l]);
+		    break;
+		  case 1:
+		    FOR_LANES if (m[l])
+		      memcpy (&rd[l], &rs[l], sizeof (double));
+		    break;
+		  }
+		break;
+	      }
+	    case 5:		/* op: FTI rs: r# rd: r# rt specifying mode */
+	      {
+		uint64_t *rd = b->iregs[instr.fvar.rd];
+		const double *rs = b->fregs[instr.fvar.rs];
+		switch (instr.fvar.rt)
+		  {
+		  case 0:
+		    LANE_SET (rd, floor (rs[l]));
+		    break;
+		  case 1:
+		    FOR_LANES if (m[l])
+		      memcpy (&rd[l], &rs[l], sizeof (uint64_t));
+		    break;
+		  case 2:
+		    LANE_SET (rd, ceil (rs[l]));
+		    break;
+		  }
+		break;
+	      }
+	    case 11:		/* op: MARK rd: r# */
+	      {
+		uint64_t *rd = b->iregs[instr.fvar.rd];
+		LANE_SET (rd, b->sp[l]);
+		break;
+	      }
+	    default:
+	      PEEL_IF (true);
+	      goto reschedule;
+	    }
+	  break;
+	case 1:		/* op: @ALU rs: r# rt: r# rd: r# */
+	  {
+	    uint64_t *rd = b->iregs[instr.fvar.rd];
+	    const uint64_t *rs = b->iregs[instr.fvar.rs];
+	    const uint64_t *rt = b->iregs[instr.fvar.rt];
+	    const unsigned int sa = instr.fvar.sa;
+	    switch (instr.fvar.fn >> 4)	/* top 2 bits specify the shifts */
+	      {
+	      case 0:
+		FOR_LANES tmp[l] = rt[l];
+		break;
+	      case 1:
+		FOR_LANES tmp[l] = rt[l] << sa;
+		break;
+	      case 2:
+		FOR_LANES tmp[l] = rt[l] >> sa;
+		break;
+	      case 3:
+		FOR_LANES tmp[l] = ((int64_t) rt[l]) >> sa;
+		break;
+	      }
+	    switch (instr.fvar.fn & 15)	/* remaining 4 bits specify the op */
+	      {
+	      case 0:
+		LANE_SET (rd, rs[l] + tmp[l]);
+		break;
+	      case 1:
+		LANE_SET (rd, rs[l] - tmp[l]);
+		break;
+	      case 2:
+		LANE_SET (rd, rs[l] * tmp[l]);
+		break;
+	      case 3:
+		PEEL_IF (tmp[l] == 0);
+		FOR_LANES if (m[l])
+		  rd[l] = rs[l] / tmp[l];
+		break;
+	      case 4:
+		PEEL_IF (tmp[l] == 0);
+		FOR_LANES if (m[l])
+		  rd[l] = rs[l] % tmp[l];
+		break;
+	      case 5:
+		LANE_SET (rd, rs[l] & tmp[l]);
+		break;
+	      case 6:
+		LANE_SET (rd, rs[l] | tmp[l]);
+		break;
+	      case 7:
+		LANE_SET (rd, rs[l] ^ tmp[l]);
+		break;
+	      case 8:
+		LANE_SET (rd, ~tmp[l]);
+		break;
+	      case 9:
+		LANE_SET (rd, rs[l] << tmp[l]);
+		break;
+	      case 10:
+		LANE_SET (rd, rs[l] >> tmp[l]);
+		break;
+	      case 11:
+		LANE_SET (rd, (uint64_t) ((int64_t) rs[l] >> tmp[l]));
+		break;
+	      case 12:
+		LANE_SET (rd, __rotate_left (rs[l], tmp[l]));
+		break;
+	      case 13:
+		LANE_SET (rd, __rotate_right (rs[l], tmp[l]));
+		break;
+	      }
+	    break;
+	  }
+	case 2:
+	  {
+	    double *rd = b->fregs[instr.fvar.rd];
+	    const double *rs = b->fregs[instr.fvar.rs];
+	    const double *rt = b->fregs[instr.fvar.rt];
+	    switch (instr.fvar.fn)
+	      {
+	      case 0:		/* rd = rs + rt [fp] */
+		LANE_SET (rd, rs[l] + rt[l]);
+		break;
+	      case 1:		/* rd = rs - rt [fp] */
+		LANE_SET (rd, rs[l] - rt[l]);
+		break;
+	      case 2:		/* rd = rs * rt [fp] */
+		LANE_SET (rd, rs[l] * rt[l]);
+		break;
+	      case 3:		/* rd = rs / rt [fp] */
+		LANE_SET (rd, rs[l] / rt[l]);
+		break;
+	      case 4:		/* rd = rs % rt [fp] */
+		FOR_LANES if (m[l])
+		  rd[l] = fmod (rs[l], rt[l]);
+		break;
+	      case 5:		/* rd = sqrt (rs) [fp] */
+		LANE_SET (rd, sqrt (rs[l]));
+		break;
+	      case 6:		/* rd = rs * rt + sa [fp] */
+		{
+		  const double *ra = b->fregs[instr.fvar.sa];
+		  LANE_SET (rd, fma (rs[l], rt[l], ra[l]));
+		  break;
+		}
+	      case 7:		/* rd = abs (rs) [fp] */
+		LANE_SET (rd, fabs (rs[l]));
+		break;
+	      case 8:		/* rd = min (rs, rt) [fp] */
+		LANE_SET (rd, fmin (rs[l], rt[l]));
+		break;
+	      case 9:		/* rd = max (rs, rt) [fp] */
+		LANE_SET (rd, fmax (rs[l], rt[l]));
+		break;
+	      case 10:		/* rd = floor (rs) [fp] */
+		LANE_SET (rd, floor (rs[l]));
+		break;
+	      case 11:		/* rd = ceil (rs) [fp] */
+		LANE_SET (rd, ceil (rs[l]));
+		break;
+	      case 12:		/* rd = round (rs), halves away from 0 [fp] */
+		LANE_SET (rd, round (rs[l]));
+		break;
+	      case 13:		/* rd = exp (rs) [fp] */
+		LANE_SET (rd, exp (rs[l]));
+		break;
+	      case 14:		/* rd = log (rs) [fp] */
+		LANE_SET (rd, log (rs[l]));
+		break;
+	      case 15:		/* rd = pow (rs, rt) [fp] */
+		LANE_SET (rd, pow (rs[l], rt[l]));
+		break;
+	      case 16:		/* rd = sin (rs) [fp] */
+		LANE_SET (rd, sin (rs[l]));
+		break;
+	      case 17:		/* rd = cos (rs) [fp] */
+		LANE_SET (rd, cos (rs[l]));
+		break;
+	      case 18:		/* rd = atan2 (rs, rt) [fp] */
+		LANE_SET (rd, atan2 (rs[l], rt[l]));
+		break;
+	      default:
+		PEEL_IF (true);
+		goto reschedule;
+	      }
+	    break;
+	  }
+	case 3:		/* op: LDI rs: r# rt: << immediate: val */
+	  {
+	    uint64_t *rd = b->iregs[instr.svar.rs];
+	    const uint64_t val = (uint64_t) instr.svar.immediate << instr.svar.rt;
+	    LANE_SET (rd, val);
+	    break;
+	  }
+	case 4:		/* op: ADDI rs: r# rt: r# immediate: val */
+	case 5:		/* op: SUBI rs: r# rt: r# immediate: val */
+	case 6:		/* op: MULI rs: r# rt: r# immediate: val */
+	case 7:		/* op: DIVI rs: r# rt: r# immediate: val */
+	case 8:		/* op: MODI rs: r# rt: r# immediate: val */
+	case 9:		/* op: ANDI rs: r# rt: r# immediate: val */
+	case 10:		/* op: ORI rs: r# rt: r# immediate: val */
+	case 11:		/* op: XORI rs: r# rt: r# immediate: val */
+	  {
+	    uint64_t *rd = b->iregs[instr.svar.rs];
+	    const uint64_t *rs = b->iregs[instr.svar.rt];
+	    const uint64_t imm = instr.svar.immediate;
+	    switch (instr.svar.opcode)
+	      {
+	      case 4:
+		LANE_SET (rd, rs[l] + imm);
+		break;
+	      case 5:
+		LANE_SET (rd, rs[l] - imm);
+		break;
+	      case 6:
+		LANE_SET (rd, rs[l] * imm);
+		break;
+	      case 7:
+	      case 8:
+		if (imm == 0)
+		  {
+		    PEEL_IF (true);
+		    goto reschedule;
+		  }
+		if (instr.svar.opcode == 7)
+		  LANE_SET (rd, rs[l] / imm);
+		else
+		  LANE_SET (rd, rs[l] % imm);
+		break;
+	      case 9:
+		LANE_SET (rd, rs[l] & imm);
+		break;
+	      case 10:
+		LANE_SET (rd, rs[l] | imm);
+		break;
+	      case 11:
+		LANE_SET (rd, rs[l] ^ imm);
+		break;
+	      }
+	    break;
+	  }
+	case 12:		/* op: CALL target: val */
+	  PEEL_IF (b->sp[l] >= b->stack_size);
+	  FOR_LANES if (m[l])
+	    b->stack[b->sp[l]++ * BATCH_LANES + l] = pc + 1;
+	  target = instr.tvar.target;
+	  break;
+	case 13:		/* op: JMP target: val */
+	  target = instr.tvar.target;
+	  break;
+	case 14:		/* op: RET */
+	  PEEL_IF (b->sp[l] == 0);
+	  FOR_LANES if (m[l])
+	    nip[l] = b->stack[--b->sp[l] * BATCH_LANES + l];
+	  goto diverge;
+	case 15:		/* op: JE rs: r# rt: r# immediate: val */
+	case 16:		/* op: JL rs: r# rt: r# immediate: val */
+	case 17:		/* op: JG rs: r# rt: r# immediate: val */
+	case 18:		/* op: JSL rs: r# rt: r# immediate: val */
+	case 19:		/* op: JSG rs: r# rt: r# immediate: val */
+	  {
+	    const uint64_t *rs = b->iregs[instr.svar.rs];
+	    const uint64_t *rt = b->iregs[instr.svar.rt];
+	    const uint64_t dst = instr.svar.immediate;
+	    switch (instr.svar.opcode)
+	      {
+	      case 15:
+		FOR_LANES nip[l] = rs[l] == rt[l] ? dst : pc + 1;
+		break;
+	      case 16:
+		FOR_LANES nip[l] = rs[l] < rt[l] ? dst : pc + 1;
+		break;
+	      case 17:
+		FOR_LANES nip[l] = rs[l] > rt[l] ? dst : pc + 1;
+		break;
+	      case 18:
+		FOR_LANES nip[l] =
+		  (int64_t) rs[l] < (int64_t) rt[l] ? dst : pc + 1;
+		break;
+	      case 19:
+		FOR_LANES nip[l] =
+		  (int64_t) rs[l] > (int64_t) rt[l] ? dst : pc + 1;
+		break;
+	      }
+	    goto diverge;
+	  }
+	case 20:		/* op: JFE rs: r# rt: r# immediate: val */
+	case 21:		/* op: JFL rs: r# rt: r# immediate: val */
+	case 22:		/* op: JFG rs: r# rt: r# immediate: val */
+	  {
+	    const double *rs = b->fregs[instr.svar.rs];
+	    const double *rt = b->fregs[instr.svar.rt];
+	    const uint64_t dst = instr.svar.immediate;
+	    switch (instr.svar.opcode)
+	      {
+	      case 20:
+		FOR_LANES nip[l] = rs[l] == rt[l] ? dst : pc + 1;
+		break;
+	      case 21:
+		FOR_LANES nip[l] = rs[l] < rt[l] ? dst : pc + 1;
+		break;
+	      case 22:
+		FOR_LANES nip[l] = rs[l] > rt[l] ? dst : pc + 1;
+		break;
+	      }
+	    goto diverge;
+	  }
+	case 23:		/* op: JOF target: sval */
+	  target = pc + __pad_sign_bit (instr.tvar.target, 26);
+	  break;
+	case 24:		/* op: JIR rs: r# rt: << immediate: sval */
+	  {
+	    const uint64_t *rs = b->iregs[instr.svar.rs];
+	    const int64_t off = __pad_sign_bit (instr.svar.immediate, 16);
+	    FOR_LANES nip[l] = (rs[l] << instr.svar.rt) + off;
+	    goto diverge;
+	  }
+	case 25:		/* op: JZ rs: r# rt: mode immediate: val */
+	  {
+	    const uint64_t dst = instr.svar.immediate;
+	    if (instr.svar.rt == 0)
+	      {
+		const uint64_t *rs = b->iregs[instr.svar.rs];
+		FOR_LANES nip[l] = rs[l] == 0 ? dst : pc + 1;
+	      }
+	    else if (instr.svar.rt == 1)
+	      {
+		const double *rs = b->fregs[instr.svar.rs];
+		FOR_LANES nip[l] = rs[l] == 0 ? dst : pc + 1;
+	      }
+	    else
+	      FOR_LANES nip[l] = pc + 1;
+	    goto diverge;
+	  }
+	case 38:		/* op: SCJMP rs: r# rt: r# immediate: flag */
+	  /* Executes the next instruction when true, skips it otherwise */
+	  __compare (b, instr.svar.immediate, instr.svar.rs, instr.svar.rt,
+		     tmp);
+	  FOR_LANES nip[l] = pc + 1 + !tmp[l];
+	  goto diverge;
+	case 39:		/* op: LDPO rs: base rt: r# imm: signed offset */
+	  {
+	    uint64_t *rd = b->iregs[instr.svar.rt];
+	    const uint64_t *rs = b->iregs[instr.svar.rs];
+	    const uint64_t base = (uint64_t) b->ropool +
+	      __pad_sign_bit (instr.svar.immediate, 16);
+	    LANE_SET (rd, base + rs[l]);
+	    break;
+	  }
+	case 40:		/* op: LDPL rt: r# imm: loc */
+	  {
+	    uint64_t *rd = b->iregs[instr.svar.rt];
+	    const uint64_t addr = (uint64_t) (b->ropool + instr.svar.immediate);
+	    LANE_SET (rd, addr);
+	    break;
+	  }
+	case 45:		/* op: LDK rs: r# rt: fp | slot high imm: slot */
+	  {
+	    const char *k = b->ropool + RLVM_LDK_SLOT (instr) * sizeof (uint64_t);
+	    if (instr.svar.rt & RLVM_LDK_FP)
+	      {
+		double *rd = b->fregs[instr.svar.rs];
+		double val;
+		memcpy (&val, k, sizeof (val));
+		LANE_SET (rd, val);
+	      }
+	    else
+	      {
+		uint64_t *rd = b->iregs[instr.svar.rs];
+		uint64_t val;
+		memcpy (&val, k, sizeof (val));
+		LANE_SET (rd, val);
+	      }
+	    break;
+	  }
+	case 48:		/* op: DBNZ rs: r# immediate: val */
+	  {
+	    uint64_t *rs = b->iregs[instr.svar.rs];
+	    const uint64_t dst = instr.svar.immediate;
+	    LANE_SET (rs, rs[l] - 1);
+	    FOR_LANES nip[l] = rs[l] != 0 ? dst : pc + 1;
+	    goto diverge;
+	  }
+	case 49:		/* op: SETcc/CMOVcc/SELECT fn: kind | flag */
+	  {
+	    const unsigned int flag = instr.fvar.fn & 0xF;
+	    uint64_t *ird = b->iregs[instr.fvar.rd];
+	    double *frd = b->fregs[instr.fvar.rd];
+	    const uint64_t *isa = b->iregs[instr.fvar.sa];
+	    if ((instr.fvar.fn & 0x30) != RLVM_CC_SELECT)
+	      __compare (b, flag, instr.fvar.rs, instr.fvar.rt, tmp);
+	    switch (instr.fvar.fn & 0x30)
+	      {
+	      case RLVM_CC_SET:
+		LANE_SET (ird, tmp[l]);
+		break;
+	      case RLVM_CC_MOV:
+		LANE_SET (ird, tmp[l] ? isa[l] : ird[l]);
+		break;
+	      case RLVM_CC_MOVF:
+		{
+		  const double *fsa = b->fregs[instr.fvar.sa];
+		  LANE_SET (frd, tmp[l] ? fsa[l] : frd[l]);
+		  break;
+		}
+	      case RLVM_CC_SELECT:
+		if (flag & RLVM_CC_FP)
+		  {
+		    const double *frs = b->fregs[instr.fvar.rs];
+		    const double *frt = b->fregs[instr.fvar.rt];
+		    LANE_SET (frd, isa[l] ? frs[l] : frt[l]);
+		  }
+		else
+		  {
+		    const uint64_t *irs = b->iregs[instr.fvar.rs];
+		    const uint64_t *irt = b->iregs[instr.fvar.rt];
+		    LANE_SET (ird, isa[l] ? irs[l] : irt[l]);
+		  }
+		break;
+	      }
+	    break;
+	  }
+	case 50:		/* op: BIT rs: r# rt: r# rd: r# fn: op */
+	  {
+	    const uint64_t *rs = b->iregs[instr.fvar.rs];
+	    const uint64_t *rt = b->iregs[instr.fvar.rt];
+	    uint64_t *rd = b->iregs[instr.fvar.rd];
+	    switch (instr.fvar.fn)
+	      {
+	      case RLVM_BIT_POPCNT:
+		LANE_SET (rd, bits_popcount (rs[l]));
+		break;
+	      case RLVM_BIT_CLZ:
+		LANE_SET (rd, bits_clz (rs[l]));
+		break;
+	      case RLVM_BIT_CTZ:
+		LANE_SET (rd, bits_ctz (rs[l]));
+		break;
+	      case RLVM_BIT_BSWAP:
+		LANE_SET (rd, bits_bswap (rs[l]));
+		break;
+	      case RLVM_BIT_PEXT:
+		LANE_SET (rd, bits_pext (rs[l], rt[l]));
+		break;
+	      case RLVM_BIT_PDEP:
+		LANE_SET (rd, bits_pdep (rs[l], rt[l]));
+		break;
+	      case RLVM_BIT_MULHU:
+		LANE_SET (rd, bits_mulhu (rs[l], rt[l]));
+		break;
+	      case RLVM_BIT_MULHS:
+		LANE_SET (rd, bits_mulhs (rs[l], rt[l]));
+		break;
+	      default:
+		PEEL_IF (true);
+		goto reschedule;
+	      }
+	    break;
+	  }
+	case 51:		/* op: SWITCH rs: r# immediate: table */
+	  {
+	    const char *tbl = b->ropool + instr.svar.immediate;
+	    const uint64_t *rs = b->iregs[instr.svar.rs];
+	    uint32_t cases, dst;
+	    memcpy (&cases, tbl, sizeof (cases));
+	    FOR_LANES
+	    {
+	      memcpy (&dst, tbl + sizeof (uint32_t) *
+		      (rs[l] < cases ? rs[l] + 2 : 1), sizeof (dst));
+	      nip[l] = dst;
+	    }
+	    goto diverge;
+	  }
+	case 52:		/* op: TAILCALL rs: mark rt: mode immediate: val */
+	  if (instr.svar.rt & 1)
+	    {
+	      const uint64_t *rs = b->iregs[instr.svar.rs];
+	      PEEL_IF (rs[l] > b->sp[l]);
+	      FOR_LANES if (m[l])
+		b->sp[l] = rs[l];
+	    }
+	  target = instr.svar.immediate;
+	  break;
+	default:
+	  PEEL_IF (true);
+	  goto reschedule;
+	}
+
+      /* Every active lane continues at target */
+      if (conv)
+	{
+	  pc = target;
+	  if (pc >= len)
+	    goto reschedule;
+	  continue;
+	}
+      FOR_LANES if (m[l])
+	b->ip[l] = target;
+      goto reschedule;
+
+    diverge:
+      /* Every active lane continues at its own nip */
+      LANE_SET (b->ip, nip[l]);
+      conv = false;
+
+    reschedule:
+      /*
+       * Pick the lowest instruction pointer among the running lanes.
+       * If every running lane is there, the batch is converged and
+       * the masks stay the same until the next branch. Lanes that
+       * run past the end of the code stop like in exec_bytecode.
+       */
+      if (conv)
+	FOR_LANES if (live[l])
+	  b->ip[l] = pc;
+      pc = UINT64_MAX;
+      FOR_LANES
+      {
+	const uint64_t ip = b->ip[l] | ~live[l];
+	pc = ip < pc ? ip : pc;
+      }
+      if (pc >= len)
+	break;
+      uint64_t rest = 0;
+      FOR_LANES
+      {
+	m[l] = live[l] & -(uint64_t) (b->ip[l] == pc);
+	rest |= live[l] & ~m[l];
+      }
+      conv = rest == 0;
+    }
+}
+
+/*
+ * Reads the next input into regs. Returns 1 on success, 0 at the end
+ * of in and -1 if the line is not made of integers.
+ */
+static int
+read_input (FILE * in, char **line, size_t * cap, uint64_t * regs)
+{
+  if (getline (line, cap, in) == -1)
+    return 0;
+  memset (regs, 0, BATCH_INPUTS * sizeof (uint64_t));
+  char *p = *line;
+  size_t i;
+  for (i = 0;; ++i)
+    {
+      while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+	++p;
+      if (*p == '\0')
+	return 1;
+      if (i == BATCH_INPUTS)
+	return -1;
+      char *end;
+      regs[i] = strtoll (p, &end, 0);
+      if (end == p)
+	return -1;
+      p = end;
+    }
+}
+
+static void
+print_result (FILE * out, status_t state)
+{
+  if (state.state == CLEAN)
+    fprintf (out, "%" PRIu64 "\n", (uint64_t) state.uid);
+  else
+    fprintf (out, "%s\n", state_name (state));
+}
+
+int
+exec_inputs (bcode_t * code, FILE * in, FILE * out, bool lockstep)
+{
+  rlvm_batch_t *b = NULL;
+  if (lockstep)
+    {
+      b = malloc (sizeof (rlvm_batch_t));
+      if (b == NULL || !init_batch (b, BATCH_LANES, code->cstack_size,
+				    code->estack_size, code->ropool))
+	{
+	  fprintf (stderr, "error: out of memory\n");
+	  free (b);
+	  return 2;
+	}
+      b->fin = in;
+      b->fout = out;
+      b->buffered = true;
+      b->natives = code->natives;
+      b->native_count = code->native_count;
+    }
+
+  char *line = NULL;
+  size_t cap = 0;
+  uint64_t regs[BATCH_INPUTS];
+  uint64_t lineno = 0;
+  int ret = 0;
+  int got;
+  do
+    {
+      uint64_t n = 0;
+      if (lockstep)
+	{
+	  memset (b->ip, 0, sizeof (b->ip));
+	  memset (b->sp, 0, sizeof (b->sp));
+	  memset (b->state, 0, sizeof (b->state));
+	  memset (b->iregs, 0, sizeof (b->iregs));
+	  memset (b->fregs, 0, sizeof (b->fregs));
+	}
+      while (n < BATCH_LANES
+	     && (got = read_input (in, &line, &cap, regs)) == 1)
+	{
+	  ++lineno;
+	  if (!lockstep)
+	    {
+	      rlvm_t vm = init_rlvm (code->cstack_size, code->estack_size,
+				     code->ropool);
+	      vm.fin = in;
+	      vm.fout = out;
+	      vm.natives = code->natives;
+	      vm.native_count = code->native_count;
+	      memcpy (vm.iregs, regs, sizeof (regs));
+	      print_result (out, exec_bytecode (&vm, code->code_size,
+						code->code));
+	      clean_rlvm (&vm);
+	      continue;
+	    }
+	  size_t i;
+	  for (i = 0; i < BATCH_INPUTS; ++i)
+	    b->iregs[i][n] = regs[i];
+	  ++n;
+	}
+      if (got == -1)
+	{
+	  fprintf (stderr, "error: input %" PRIu64 " is not made of "
+		   "integers\n", lineno + 1);
+	  ret = 2;
+	}
+      if (n > 0)
+	{
+	  b->lanes = n;
+	  exec_batch (b, code->code_size, code->code);
+	  uint64_t i;
+	  for (i = 0; i < n; ++i)
+	    {
+	      if (b->lane_buf[i] != NULL)
+		{
+		  fwrite (b->lane_buf[i], 1, b->lane_len[i], out);
+		  free (b->lane_buf[i]);
+		  b->lane_buf[i] = NULL;
+		}
+	      print_result (out, b->state[i]);
+	    }
+	}
+    }
+  while (got == 1);
+
+  free (line);
+  if (lockstep)
+    {
+      clean_batch (b);
+      free (b);
+    }
+  fflush (out);
+  return ret;
+}
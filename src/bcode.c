@@ -92,6 +92,61 @@ read_bytecode (FILE * f, bcode_t * bf)
   if (fread (bf->ropool, sizeof (char), bf->ropool_size, f) !=
       bf->ropool_size)
     return NULL;
+
+  bf->imports_size = 0;
+  bf->imports = NULL;
+  bf->natives = NULL;
+  bf->native_count = 0;
+  /* Files from before NCALL end right after the pool */
+  if (fread (&bf->imports_size, sizeof (bf->imports_size), 1, f) == 1)
+    {
+      if (bf->magic[1] == 0xDF)
+	bf->imports_size = be64toh (bf->imports_size);
+      else
+	bf->imports_size = le64toh (bf->imports_size);
+      bf->imports = malloc (bf->imports_size * sizeof (char));
+      if (fread (bf->imports, sizeof (char), bf->imports_size, f) !=
+	  bf->imports_size)
+	return NULL;
+      if (bf->imports_size > 0 && bf->imports[bf->imports_size - 1] != '\0')
+	return NULL;
+    }
+
+  bf->exports_size = 0;
+  bf->exports = NULL;
+  if (fread (&bf->exports_size, sizeof (bf->exports_size), 1, f) == 1)
+    {
+      if (bf->magic[1] == 0xDF)
+	bf->exports_size = be64toh (bf->exports_size);
+      else
+	bf->exports_size = le64toh (bf->exports_size);
+      bf->exports = malloc (bf->exports_size * sizeof (char));
+      if (fread (bf->exports, sizeof (char), bf->exports_size, f) !=
+	  bf->exports_size)
+	return NULL;
+      /* Each entry is an address and a name of at least the NUL */
+      uint64_t off = 0;
+      while (off < bf->exports_size)
+	{
+	  uint64_t addr;
+	  if (bf->exports_size - off <= sizeof (addr))
+	    return NULL;
+	  memcpy (&addr, bf->exports + off, sizeof (addr));
+	  if (bf->magic[1] == 0xDF)
+	    addr = be64toh (addr);
+	  else
+	    addr = le64toh (addr);
+	  memcpy (bf->exports + off, &addr, sizeof (addr));
+	  off += sizeof (addr);
+	  const char *nul = memchr (bf->exports + off, '\0',
+				    bf->exports_size - off);
+	  if (nul == NULL)
+	    return NULL;
+	  off = nul - bf->exports + 1;
+	}
+    }
+  if (!link_natives (bf))
+    return NULL;
   return bf;
 }
 
@@ -126,6 +181,16 @@ write_bytecode (FILE * f, bcode_t * bf)
   if (fwrite (bf->ropool, sizeof (char), bf->ropool_size, f) !=
       bf->ropool_size)
     return false;
+  if (fwrite (&bf->imports_size, sizeof (uint64_t), 1, f) != 1)
+    return false;
+  if (fwrite (bf->imports, sizeof (char), bf->imports_size, f) !=
+      bf->imports_size)
+    return false;
+  if (fwrite (&bf->exports_size, sizeof (uint64_t), 1, f) != 1)
+    return false;
+  if (fwrite (bf->exports, sizeof (char), bf->exports_size, f) !=
+      bf->exports_size)
+    return false;
   return true;
 }
 
@@ -133,10 +198,21 @@ status_t
 exec_bcode_t (rlvm_t * vm, bcode_t * bf)
 {
   rlvm_t lvm = init_rlvm (bf->cstack_size, bf->estack_size, bf->ropool);
+  lvm.natives = bf->natives;
+  lvm.native_count = bf->native_count;
   memcpy (vm, &lvm, sizeof (rlvm_t));
   return exec_bytecode (vm, bf->code_size, bf->code);
 }
 
+bool
+link_natives (bcode_t * bf)
+{
+  free (bf->natives);
+  bf->natives = native_bind (bf->imports, bf->imports_size,
+			     &bf->native_count);
+  return bf->natives != NULL || bf->imports_size == 0;
+}
+
 void
 clean_bcode (bcode_t * bf)
 {
@@ -144,4 +220,11 @@ clean_bcode (bcode_t * bf)
   bf->code = NULL;
   free (bf->ropool);
   bf->ropool = NULL;
+  free (bf->imports);
+  bf->imports = NULL;
+  free (bf->natives);
+  bf->natives = NULL;
+  bf->native_count = 0;
+  free (bf->exports);
+  bf->exports = NULL;
 }
@@ -0,0 +1,198 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "bits.h"
+
+#include <stdbool.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define BITS_BMI2_DISPATCH
+#endif
+
+uint64_t
+bits_popcount (uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll (x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (x * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+uint64_t
+bits_clz (uint64_t x)
+{
+  if (x == 0)
+    return 64;
+#ifdef __GNUC__
+  return __builtin_clzll (x);
+#else
+  uint64_t n = 0;
+  while (!(x & 0x8000000000000000ULL))
+    {
+      x <<= 1;
+      ++n;
+    }
+  return n;
+#endif
+}
+
+uint64_t
+bits_ctz (uint64_t x)
+{
+  if (x == 0)
+    return 64;
+#ifdef __GNUC__
+  return __builtin_ctzll (x);
+#else
+  uint64_t n = 0;
+  while (!(x & 1))
+    {
+      x >>= 1;
+      ++n;
+    }
+  return n;
+#endif
+}
+
+uint64_t
+bits_bswap (uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_bswap64 (x);
+#else
+  x = (x & 0x00000000FFFFFFFFULL) << 32 | x >> 32;
+  x = (x & 0x0000FFFF0000FFFFULL) << 16 | (x >> 16 & 0x0000FFFF0000FFFFULL);
+  return (x & 0x00FF00FF00FF00FFULL) << 8 | (x >> 8 & 0x00FF00FF00FF00FFULL);
+#endif
+}
+
+/* One step per set bit of the mask */
+static uint64_t
+__pext_loop (uint64_t x, uint64_t mask)
+{
+  uint64_t r = 0;
+  uint64_t bit = 1;
+  for (; mask != 0; mask &= mask - 1, bit <<= 1)
+    if (x & mask & -mask)
+      r |= bit;
+  return r;
+}
+
+static uint64_t
+__pdep_loop (uint64_t x, uint64_t mask)
+{
+  uint64_t r = 0;
+  uint64_t bit = 1;
+  for (; mask != 0; mask &= mask - 1, bit <<= 1)
+    if (x & bit)
+      r |= mask & -mask;
+  return r;
+}
+
+#ifdef BITS_BMI2_DISPATCH
+/*
+ * The build does not assume BMI2, so ask the cpu once and use the
+ * instructions from then on.
+ */
+__attribute__ ((target ("bmi2"))) static uint64_t
+__pext_bmi2 (uint64_t x, uint64_t mask)
+{
+  return _pext_u64 (x, mask);
+}
+
+__attribute__ ((target ("bmi2"))) static uint64_t
+__pdep_bmi2 (uint64_t x, uint64_t mask)
+{
+  return _pdep_u64 (x, mask);
+}
+
+static bool
+__has_bmi2 (void)
+{
+  static int has = -1;
+  if (has < 0)
+    {
+      __builtin_cpu_init ();
+      has = __builtin_cpu_supports ("bmi2") != 0;
+    }
+  return has;
+}
+#endif
+
+uint64_t
+bits_pext (uint64_t x, uint64_t mask)
+{
+#ifdef BITS_BMI2_DISPATCH
+  if (__has_bmi2 ())
+    return __pext_bmi2 (x, mask);
+#endif
+  return __pext_loop (x, mask);
+}
+
+uint64_t
+bits_pdep (uint64_t x, uint64_t mask)
+{
+#ifdef BITS_BMI2_DISPATCH
+  if (__has_bmi2 ())
+    return __pdep_bmi2 (x, mask);
+#endif
+  return __pdep_loop (x, mask);
+}
+
+uint64_t
+bits_mulhu (uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+  return (uint64_t) (((unsigned __int128) a * b) >> 64);
+#else
+  const uint64_t al = a & 0xFFFFFFFF, ah = a >> 32;
+  const uint64_t bl = b & 0xFFFFFFFF, bh = b >> 32;
+  const uint64_t ll = al * bl;
+  const uint64_t lh = al * bh;
+  const uint64_t hl = ah * bl;
+  const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+  return ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+uint64_t
+bits_mulhs (uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+  return (uint64_t) (((__int128) (int64_t) a * (int64_t) b) >> 64);
+#else
+  /* Signed high part is the unsigned one minus the sign corrections */
+  uint64_t r = bits_mulhu (a, b);
+  if ((int64_t) a < 0)
+    r -= b;
+  if ((int64_t) b < 0)
+    r -= a;
+  return r;
+#endif
+}
@@ -0,0 +1,276 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "csv.h"
+#include "bits.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+typedef struct scan_t
+{
+  const char *buf;
+  csv_field_t *out;
+  uint64_t cap;
+  uint64_t count;
+  uint64_t record;		/* Index of the first field of the record */
+  uint64_t start;		/* Offset of the field being scanned */
+  uint64_t consumed;
+  char delim;
+  char quote;
+  char newline;
+  bool in_quote;
+} scan_t;
+
+/* Returns false once out is full, dropping the partial record */
+static bool
+__emit (scan_t * s, uint64_t end, bool last)
+{
+  if (s->count == s->cap)
+    {
+      s->count = s->record;
+      return false;
+    }
+
+  uint64_t start = s->start;
+  uint64_t flags = last ? CSV_END_RECORD : 0;
+  if (last && s->newline == '\n' && end > start && s->buf[end - 1] == '\r')
+    --end;
+  if (s->quote != 0 && end > start && s->buf[start] == s->quote)
+    {
+      ++start;
+      if (end > start && s->buf[end - 1] == s->quote)
+	--end;
+      flags |= CSV_QUOTED;
+    }
+  s->out[s->count++] = (csv_field_t)
+  {
+  .start = start,.end = end | flags};
+  return true;
+}
+
+/* Handles the byte at i, which is a delimiter, newline or quote */
+static inline bool
+__structural (scan_t * s, uint64_t i)
+{
+  const char c = s->buf[i];
+  if (c == s->quote && s->quote != 0)
+    {
+      /* A doubled quote toggles twice, which leaves the state alone */
+      s->in_quote = !s->in_quote;
+      return true;
+    }
+  if (s->in_quote)
+    return true;
+  if (c == s->delim)
+    {
+      if (!__emit (s, i, false))
+	return false;
+      s->start = i + 1;
+    }
+  else if (c == s->newline)
+    {
+      if (!__emit (s, i, true))
+	return false;
+      s->start = i + 1;
+      s->record = s->count;
+      s->consumed = i + 1;
+    }
+  return true;
+}
+
+uint64_t
+csv_scan (const char *buf, uint64_t len, uint32_t dialect,
+	  csv_field_t * out, uint64_t cap, uint64_t * consumed)
+{
+  scan_t s = {
+    .buf = buf,
+    .out = out,
+    .cap = cap,
+    .delim = dialect & 0xFF,
+    .quote = dialect >> 8 & 0xFF,
+    .newline = dialect >> 16 & 0xFF
+  };
+
+  uint64_t i = 0;
+#ifdef __SSE2__
+  const __m128i dv = _mm_set1_epi8 (s.delim);
+  const __m128i nv = _mm_set1_epi8 (s.newline);
+  const __m128i qv = _mm_set1_epi8 (s.quote != 0 ? s.quote : s.delim);
+  for (; i + 16 <= len; i += 16)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (buf + i));
+      uint32_t m = _mm_movemask_epi8 (_mm_or_si128
+				      (_mm_or_si128
+				       (_mm_cmpeq_epi8 (v, dv),
+					_mm_cmpeq_epi8 (v, nv)),
+				       _mm_cmpeq_epi8 (v, qv)));
+      for (; m != 0; m &= m - 1)
+	if (!__structural (&s, i + bits_ctz (m)))
+	  goto done;
+    }
+#endif
+  for (; i < len; ++i)
+    {
+      const char c = buf[i];
+      if ((c == s.delim || c == s.newline || (c == s.quote && s.quote != 0))
+	  && !__structural (&s, i))
+	goto done;
+    }
+
+  /* The last record may end with the buffer instead of a newline */
+  if (s.start < len || s.count > s.record)
+    {
+      if (__emit (&s, len, true))
+	s.consumed = len;
+    }
+
+done:
+  *consumed = s.consumed;
+  return s.count;
+}
+
+bool
+csv_parse_i64 (const char *s, uint64_t len, int64_t * out)
+{
+  const char *end = s + len;
+  bool neg = false;
+  if (s != end && (*s == '-' || *s == '+'))
+    neg = *s++ == '-';
+  if (s == end)
+    return false;
+
+  uint64_t v = 0;
+  for (; s != end; ++s)
+    {
+      const unsigned d = (unsigned char) *s - '0';
+      if (d > 9)
+	return false;
+      if (v > (UINT64_MAX - d) / 10)
+	return false;
+      v = v * 10 + d;
+    }
+  if (v > (uint64_t) INT64_MAX + neg)
+    return false;
+  *out = neg ? -v : v;
+  return true;
+}
+
+/*
+ * The field must be a decimal like csv_parse_i64 takes, with an
+ * optional fraction and exponent: no spaces, inf, nan or hex floats.
+ * Plain decimals with at most 19 digits and a small exponent are
+ * exact: the digits fit a double without rounding and so does the
+ * power of ten, so one multiply or divide rounds correctly (Clinger's
+ * fast path). The rest goes to strtod, which only sees valid fields.
+ */
+bool
+csv_parse_f64 (const char *s, uint64_t len, double *out)
+{
+  static const double P10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char *p = s;
+  const char *end = s + len;
+  bool neg = false;
+  if (p != end && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+
+  uint64_t mant = 0;
+  int digits = 0;
+  int exp = 0;
+  bool any = false;
+  bool exact = true;		/* mant holds every digit */
+  for (; p != end && (unsigned) (*p - '0') < 10; ++p, any = true)
+    {
+      if (digits == 19)
+	{
+	  exact = false;
+	  continue;
+	}
+      mant = mant * 10 + (*p - '0');
+      digits += mant != 0;
+    }
+  if (p != end && *p == '.')
+    for (++p; p != end && (unsigned) (*p - '0') < 10; ++p, any = true)
+      {
+	if (digits == 19)
+	  {
+	    exact = false;
+	    continue;
+	  }
+	mant = mant * 10 + (*p - '0');
+	digits += mant != 0;
+	--exp;
+      }
+  if (!any)
+    return false;
+  if (p != end && (*p == 'e' || *p == 'E'))
+    {
+      ++p;
+      bool eneg = false;
+      if (p != end && (*p == '-' || *p == '+'))
+	eneg = *p++ == '-';
+      if (p == end)
+	return false;
+      int e = 0;
+      for (; p != end && (unsigned) (*p - '0') < 10; ++p)
+	if (e < 10000)
+	  e = e * 10 + (*p - '0');
+      exp += eneg ? -e : e;
+    }
+  if (p != end)
+    return false;
+
+  if (exact && mant <= (UINT64_C (1) << 53) && exp >= -22 && exp <= 22)
+    {
+      double v = (double) mant;
+      v = exp < 0 ? v / P10[-exp] : v * P10[exp];
+      *out = neg ? -v : v;
+      return true;
+    }
+
+  /* strtod wants a terminated string */
+  char tmp[64];
+  char *copy = len < sizeof (tmp) ? tmp : malloc (len + 1);
+  if (copy == NULL)
+    return false;
+  memcpy (copy, s, len);
+  copy[len] = '\0';
+  const double v = strtod (copy, NULL);
+  if (copy != tmp)
+    free (copy);
+  /* Like an int that does not fit, a decimal beyond DBL_MAX is not one */
+  if (isinf (v))
+    return false;
+  *out = v;
+  return true;
+}
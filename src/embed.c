@@ -0,0 +1,127 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "embed.h"
+
+#include <string.h>
+
+/* Programs rarely export more than a handful of functions */
+#define EXPORT_BUCKETS 64
+
+bool
+rlvm_open (rlvm_inst_t * inst, bcode_t * code)
+{
+  inst->code = code;
+  inst->vm = init_rlvm (code->cstack_size, code->estack_size, code->ropool);
+  inst->vm.natives = code->natives;
+  inst->vm.native_count = code->native_count;
+  inst->exports = init_map (EXPORT_BUCKETS);
+  if (inst->exports.ptr == NULL)
+    {
+      clean_rlvm (&inst->vm);
+      return false;
+    }
+  uint64_t off = 0;
+  while (off < code->exports_size)
+    {
+      uint64_t addr;
+      memcpy (&addr, code->exports + off, sizeof (addr));
+      const char *name = code->exports + off + sizeof (addr);
+      const size_t len = strlen (name);
+      /* The map owns its keys */
+      char *key = malloc (len + 1);
+      if (key == NULL)
+	{
+	  rlvm_close (inst);
+	  return false;
+	}
+      memcpy (key, name, len + 1);
+      put_entry (&inst->exports, key, addr, 0);
+      off += sizeof (addr) + len + 1;
+    }
+  return true;
+}
+
+bool
+rlvm_export (const rlvm_inst_t * inst, const char *name, uint64_t * addr)
+{
+  /* Lookups leave the map alone, whatever its signature says */
+  lblmap_t *exports = (lblmap_t *) & inst->exports;
+  if (!has_key (exports, (char *) name))
+    return false;
+  *addr = get_val (exports, (char *) name);
+  return true;
+}
+
+status_t
+rlvm_call (rlvm_inst_t * inst, const char *name, size_t argc,
+	   const uint64_t * argv)
+{
+  uint64_t addr;
+  if (!rlvm_export (inst, name, &addr))
+    return (status_t)
+    {
+    .state = BAD_OPCODE,.uid = 0};
+  return rlvm_call_at (inst, addr, argc, argv);
+}
+
+/*
+ * Calls like CALL would, with the end of the code as the return
+ * address so exec_bytecode stops right after the matching RET.
+ */
+status_t
+rlvm_call_at (rlvm_inst_t * inst, uint64_t addr, size_t argc,
+	      const uint64_t * argv)
+{
+  rlvm_t *vm = &inst->vm;
+  if (argc > RLVM_CALL_ARGS)
+    return (status_t)
+    {
+    .state = BAD_OPCODE,.uid = 0};
+  if (vm->sp >= vm->stack_size)
+    return (status_t)
+    {
+    .state = STACK_OFLOW,.uid = 0};
+  const uint64_t sp = vm->sp;
+  const uint64_t esp = vm->esp;
+  memcpy (vm->iregs, argv, argc * sizeof (uint64_t));
+  vm->stack[vm->sp++] = inst->code->code_size;
+  vm->ip = addr;
+  vm->state = (status_t)
+  {
+  .state = CLEAN,.uid = 0};
+  const status_t state =
+    exec_bytecode (vm, inst->code->code_size, inst->code->code);
+  /* A halt or an uncaught fault leaves the frames of the call behind */
+  vm->sp = sp;
+  vm->esp = esp;
+  return state;
+}
+
+void
+rlvm_close (rlvm_inst_t * inst)
+{
+  free_map (&inst->exports);
+  clean_rlvm (&inst->vm);
+}
@@ -0,0 +1,217 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "filter.h"
+
+#include <string.h>
+
+/* Smallest output buffer handed to the program */
+#define MIN_OUTPUT 65536
+
+/*
+ * Calls the batch entry like CALL would, with the end of the code as
+ * the return address so exec_bytecode stops right after the RET.
+ * Returns false if the program halted or faulted instead.
+ */
+static bool
+call_entry (rlvm_t * vm, bcode_t * code, uint64_t entry, uint64_t * recs,
+	    uint64_t nrecs, char *obuf, uint64_t ocap, status_t * state)
+{
+  if (vm->sp >= vm->stack_size)
+    {
+      *state = (status_t)
+      {
+      .state = STACK_OFLOW,.uid = 0};
+      return false;
+    }
+  vm->iregs[0] = (uint64_t) recs;
+  vm->iregs[1] = nrecs;
+  vm->iregs[2] = (uint64_t) obuf;
+  vm->iregs[3] = ocap;
+  vm->stack[vm->sp++] = code->code_size;
+  vm->ip = entry;
+  vm->state = (status_t)
+  {
+  .state = CLEAN,.uid = 0};
+  *state = exec_bytecode (vm, code->code_size, code->code);
+  return state->state == CLEAN && vm->ip >= code->code_size;
+}
+
+/*
+ * Finds the records in buf[0, len). Fills recs (two words per record)
+ * and returns the number of bytes they span; a trailing partial record
+ * is left for the next read unless eof is set.
+ */
+static size_t
+split_records (char *buf, size_t len, bool eof, filter_delim_t delim,
+	       uint64_t ** recs, size_t * rcap, size_t * nrecs)
+{
+  size_t pos = 0;
+  *nrecs = 0;
+  while (pos < len)
+    {
+      uint64_t start, size, next;
+      if (delim == FILTER_NEWLINE)
+	{
+	  char *nl = memchr (buf + pos, '\n', len - pos);
+	  if (nl == NULL && !eof)
+	    break;
+	  start = pos;
+	  size = (nl == NULL ? buf + len : nl) - (buf + pos);
+	  next = nl == NULL ? len : start + size + 1;
+	}
+      else
+	{
+	  if (len - pos < 4)
+	    {
+	      if (eof)
+		{
+		  fprintf (stderr, "warning: dropped truncated record\n");
+		  pos = len;
+		}
+	      break;
+	    }
+	  const unsigned char *p = (unsigned char *) buf + pos;
+	  size = p[0] | p[1] << 8 | p[2] << 16 | (uint64_t) p[3] << 24;
+	  if (len - pos - 4 < size)
+	    {
+	      if (eof)
+		{
+		  fprintf (stderr, "warning: dropped truncated record\n");
+		  pos = len;
+		}
+	      break;
+	    }
+	  start = pos + 4;
+	  next = start + size;
+	}
+      if (*nrecs == *rcap)
+	*recs = realloc (*recs, (*rcap *= 2) * 2 * sizeof (uint64_t));
+      (*recs)[*nrecs * 2] = (uint64_t) (buf + start);
+      (*recs)[*nrecs * 2 + 1] = size;
+      ++*nrecs;
+      pos = next;
+    }
+  return pos;
+}
+
+status_t
+exec_filter (bcode_t * code, FILE * in, FILE * out, filter_delim_t delim,
+	     size_t batch_size)
+{
+  rlvm_t vm = init_rlvm (code->cstack_size, code->estack_size, code->ropool);
+  vm.fin = in;
+  vm.fout = out;
+  vm.natives = code->natives;
+  vm.native_count = code->native_count;
+
+  /* Run the set up, it halts with the address of the entry */
+  status_t state = exec_bytecode (&vm, code->code_size, code->code);
+  if (state.state != CLEAN)
+    {
+      clean_rlvm (&vm);
+      return state;
+    }
+  const uint64_t entry = state.uid;
+
+  if (batch_size == 0)
+    batch_size = 1;
+  size_t cap = batch_size;
+  char *buf = malloc (cap);
+  size_t len = 0;
+  size_t rcap = 1024;
+  uint64_t *recs = malloc (rcap * 2 * sizeof (uint64_t));
+  const size_t ocap = batch_size < MIN_OUTPUT ? MIN_OUTPUT : batch_size;
+  char *obuf = malloc (ocap);
+  bool eof = false;
+
+  while (!eof || len > 0)
+    {
+      /* One large read per batch, growing only for oversized records */
+      if (!eof)
+	{
+	  if (len == cap)
+	    buf = realloc (buf, cap *= 2);
+	  const size_t n = fread (buf + len, 1, cap - len, in);
+	  len += n;
+	  if (n == 0)
+	    eof = true;
+	  else if (len < cap && !feof (in) && !ferror (in))
+	    continue;		/* Short read from a pipe, fill up first */
+	  eof = eof || feof (in) || ferror (in);
+	}
+
+      size_t nrecs;
+      const size_t used =
+	split_records (buf, len, eof, delim, &recs, &rcap, &nrecs);
+      size_t done = 0;
+      while (done < nrecs)
+	{
+	  if (!call_entry (&vm, code, entry, recs + done * 2, nrecs - done,
+			   obuf, ocap, &state))
+	    goto finish;
+	  const uint64_t wrote = vm.iregs[0];
+	  const uint64_t taken = vm.iregs[1];
+	  if (wrote > ocap || (wrote == 0 && taken == 0))
+	    {
+	      /* Overran the buffer, or cannot make progress */
+	      state = (status_t)
+	      {
+	      .state = OUT_OF_MEM,.uid = 0};
+	      goto finish;
+	    }
+	  fwrite (obuf, 1, wrote, out);
+	  done += taken < nrecs - done ? taken : nrecs - done;
+	}
+      memmove (buf, buf + used, len - used);
+      len -= used;
+    }
+
+  /* Flush call, repeated for as long as it fills the whole buffer */
+  do
+    {
+      if (!call_entry (&vm, code, entry, recs, 0, obuf, ocap, &state))
+	goto finish;
+      if (vm.iregs[0] > ocap)
+	{
+	  state = (status_t)
+	  {
+	  .state = OUT_OF_MEM,.uid = 0};
+	  goto finish;
+	}
+      fwrite (obuf, 1, vm.iregs[0], out);
+    }
+  while (vm.iregs[0] == ocap);
+  state = (status_t)
+  {
+  .state = CLEAN,.uid = 0};
+
+finish:
+  fflush (out);
+  free (obuf);
+  free (recs);
+  free (buf);
+  clean_rlvm (&vm);
+  return state;
+}
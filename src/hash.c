@@ -0,0 +1,266 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "hash.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#define HASH_SSE42_DISPATCH
+#endif
+
+#define CRC32C_POLY 0x82F63B78
+
+static uint32_t crc32c_table[256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void
+__crc32c_init_table (void)
+{
+  uint32_t i;
+  for (i = 0; i < 256; ++i)
+    {
+      uint32_t c = i;
+      int k;
+      for (k = 0; k < 8; ++k)
+	c = (c >> 1) ^ (CRC32C_POLY & -(c & 1));
+      crc32c_table[i] = c;
+    }
+}
+
+static uint32_t
+__crc32c_table (uint32_t crc, const uint8_t * p, size_t len)
+{
+  pthread_once (&crc32c_once, __crc32c_init_table);
+  while (len-- > 0)
+    crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+#ifdef HASH_SSE42_DISPATCH
+__attribute__ ((target ("sse4.2"))) static uint32_t
+__crc32c_sse42 (uint32_t crc, const uint8_t * p, size_t len)
+{
+  uint64_t c = crc;
+  for (; len >= 8; len -= 8, p += 8)
+    {
+      uint64_t w;
+      memcpy (&w, p, sizeof (w));
+      c = _mm_crc32_u64 (c, w);
+    }
+  crc = c;
+  while (len-- > 0)
+    crc = _mm_crc32_u8 (crc, *p++);
+  return crc;
+}
+
+static bool
+__has_sse42 (void)
+{
+  static int has = -1;
+  if (has < 0)
+    {
+      __builtin_cpu_init ();
+      has = __builtin_cpu_supports ("sse4.2") != 0;
+    }
+  return has;
+}
+#endif
+
+uint32_t
+hash_crc32c (uint32_t crc, const void *buf, size_t len)
+{
+  crc = ~crc;
+#ifdef HASH_SSE42_DISPATCH
+  if (__has_sse42 ())
+    return ~__crc32c_sse42 (crc, buf, len);
+#endif
+  return ~__crc32c_table (crc, buf, len);
+}
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t
+__rotl (uint64_t x, int r)
+{
+  return x << r | x >> (64 - r);
+}
+
+static inline uint64_t
+__read64 (const uint8_t * p)
+{
+  uint64_t v;
+  memcpy (&v, p, sizeof (v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64 (v);
+#endif
+  return v;
+}
+
+static inline uint32_t
+__read32 (const uint8_t * p)
+{
+  uint32_t v;
+  memcpy (&v, p, sizeof (v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32 (v);
+#endif
+  return v;
+}
+
+static inline uint64_t
+__round (uint64_t acc, uint64_t in)
+{
+  acc += in * PRIME64_2;
+  return __rotl (acc, 31) * PRIME64_1;
+}
+
+static inline uint64_t
+__merge (uint64_t h, uint64_t acc)
+{
+  h ^= __round (0, acc);
+  return h * PRIME64_1 + PRIME64_4;
+}
+
+/* Consumes as many 32 byte stripes as there are, returns the rest */
+static size_t
+__stripes (uint64_t * acc, const uint8_t * p, size_t len)
+{
+  const uint8_t *const end = p + (len & ~(size_t) 31);
+  uint64_t v1 = acc[0], v2 = acc[1], v3 = acc[2], v4 = acc[3];
+  for (; p < end; p += 32)
+    {
+      v1 = __round (v1, __read64 (p));
+      v2 = __round (v2, __read64 (p + 8));
+      v3 = __round (v3, __read64 (p + 16));
+      v4 = __round (v4, __read64 (p + 24));
+    }
+  acc[0] = v1;
+  acc[1] = v2;
+  acc[2] = v3;
+  acc[3] = v4;
+  return len & 31;
+}
+
+/* Folds the accumulators and the tail of fewer than 32 bytes */
+static uint64_t
+__finish (const uint64_t * acc, uint64_t total, const uint8_t * p,
+	  size_t len)
+{
+  uint64_t h;
+  if (total >= 32)
+    {
+      h = __rotl (acc[0], 1) + __rotl (acc[1], 7) +
+	__rotl (acc[2], 12) + __rotl (acc[3], 18);
+      h = __merge (h, acc[0]);
+      h = __merge (h, acc[1]);
+      h = __merge (h, acc[2]);
+      h = __merge (h, acc[3]);
+    }
+  else
+    h = acc[2] + PRIME64_5;	/* acc[2] is still the seed */
+  h += total;
+
+  for (; len >= 8; len -= 8, p += 8)
+    {
+      h ^= __round (0, __read64 (p));
+      h = __rotl (h, 27) * PRIME64_1 + PRIME64_4;
+    }
+  if (len >= 4)
+    {
+      h ^= (uint64_t) __read32 (p) * PRIME64_1;
+      h = __rotl (h, 23) * PRIME64_2 + PRIME64_3;
+      len -= 4;
+      p += 4;
+    }
+  while (len-- > 0)
+    {
+      h ^= *p++ * PRIME64_5;
+      h = __rotl (h, 11) * PRIME64_1;
+    }
+
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+void
+hash_init (hash_state_t * st, uint64_t seed)
+{
+  memset (st, 0, sizeof (hash_state_t));
+  st->acc[0] = seed + PRIME64_1 + PRIME64_2;
+  st->acc[1] = seed + PRIME64_2;
+  st->acc[2] = seed;
+  st->acc[3] = seed - PRIME64_1;
+}
+
+uint64_t
+hash_xxh64 (const void *buf, size_t len, uint64_t seed)
+{
+  hash_state_t st;
+  hash_init (&st, seed);
+  const size_t rest = __stripes (st.acc, buf, len);
+  return __finish (st.acc, len, (const uint8_t *) buf + len - rest, rest);
+}
+
+void
+hash_update (hash_state_t * st, const void *buf, size_t len)
+{
+  const uint8_t *p = buf;
+  st->total += len;
+  if (st->buflen + len < 32)
+    {
+      memcpy (st->buf + st->buflen, p, len);
+      st->buflen += len;
+      return;
+    }
+  if (st->buflen > 0)
+    {
+      const size_t fill = 32 - st->buflen;
+      memcpy (st->buf + st->buflen, p, fill);
+      __stripes (st->acc, st->buf, 32);
+      p += fill;
+      len -= fill;
+      st->buflen = 0;
+    }
+  const size_t rest = __stripes (st->acc, p, len);
+  memcpy (st->buf, p + len - rest, rest);
+  st->buflen = rest;
+}
+
+uint64_t
+hash_digest (const hash_state_t * st)
+{
+  return __finish (st->acc, st->total, st->buf, st->buflen);
+}
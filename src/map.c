@@ -0,0 +1,336 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "map.h"
+#include "hash.h"
+#include "bits.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define GROUP 16
+#define CTRL_EMPTY 0x80
+#define CTRL_DELETED 0xFE
+
+/* A copied byte string key keeps its length in the word before it */
+#define KEY_LEN(key) (((const uint64_t *) (key))[-1])
+#define KEY_BLOCK(key) ((uint64_t *) (key) - 1)
+
+static uint64_t
+__hash (const map_t * map, uint64_t key, uint64_t len)
+{
+  if (map->bytes)
+    return hash_xxh64 ((const void *) key, len, 0);
+  /* Murmur3's finalizer, every key bit reaches every hash bit */
+  key ^= key >> 33;
+  key *= 0xFF51AFD7ED558CCDULL;
+  key ^= key >> 33;
+  key *= 0xC4CEB9FE1A85EC53ULL;
+  return key ^ key >> 33;
+}
+
+static bool
+__key_eq (const map_t * map, const map_slot_t * slot, uint64_t key,
+	  uint64_t len)
+{
+  if (!map->bytes)
+    return slot->key == key;
+  return KEY_LEN (slot->key) == len
+    && memcmp ((const void *) slot->key, (const void *) key, len) == 0;
+}
+
+/* Bit i is set if control byte i of the group equals h2 */
+static inline uint32_t
+__group_match (const uint8_t * g, uint8_t h2)
+{
+#ifdef __SSE2__
+  const __m128i ctrl = _mm_loadu_si128 ((const __m128i *) g);
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 (h2)));
+#else
+  uint32_t m = 0;
+  int i;
+  for (i = 0; i < GROUP; ++i)
+    m |= (uint32_t) (g[i] == h2) << i;
+  return m;
+#endif
+}
+
+/* Bit i is set if slot i of the group is empty or deleted */
+static inline uint32_t
+__group_free (const uint8_t * g)
+{
+#ifdef __SSE2__
+  return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) g));
+#else
+  uint32_t m = 0;
+  int i;
+  for (i = 0; i < GROUP; ++i)
+    m |= (uint32_t) (g[i] >> 7) << i;
+  return m;
+#endif
+}
+
+static bool
+__alloc_table (map_t * map, uint64_t cap)
+{
+  uint8_t *ctrl = malloc (cap);
+  map_slot_t *slots = malloc (cap * sizeof (map_slot_t));
+  if (ctrl == NULL || slots == NULL)
+    {
+      free (ctrl);
+      free (slots);
+      return false;
+    }
+  memset (ctrl, CTRL_EMPTY, cap);
+  map->ctrl = ctrl;
+  map->slots = slots;
+  map->cap = cap;
+  map->growth_left = cap - cap / 8 - map->size;
+  return true;
+}
+
+/*
+ * Groups are probed in triangular steps (1, 2, 3, ... groups apart),
+ * which visits every group since the group count is a power of 2.
+ * Returns the index of the slot with the key or -1.
+ */
+static int64_t
+__find (const map_t * map, uint64_t hash, uint64_t key, uint64_t len)
+{
+  const uint64_t gmask = map->cap / GROUP - 1;
+  const uint8_t h2 = hash & 0x7F;
+  uint64_t g = (hash >> 7) & gmask;
+  uint64_t i;
+  for (i = 0; i <= gmask; ++i)
+    {
+      const uint8_t *ctrl = map->ctrl + g * GROUP;
+      uint32_t m;
+      for (m = __group_match (ctrl, h2); m != 0; m &= m - 1)
+	{
+	  const uint64_t idx = g * GROUP + bits_ctz (m);
+	  if (__key_eq (map, &map->slots[idx], key, len))
+	    return idx;
+	}
+      /* An empty slot ends the probe, the key would have gone there */
+      if (__group_match (ctrl, CTRL_EMPTY) != 0)
+	return -1;
+      g = (g + i + 1) & gmask;
+    }
+  return -1;
+}
+
+/* First empty or deleted slot on the probe sequence of hash */
+static uint64_t
+__find_free (const map_t * map, uint64_t hash)
+{
+  const uint64_t gmask = map->cap / GROUP - 1;
+  uint64_t g = (hash >> 7) & gmask;
+  uint64_t i;
+  for (i = 0;; ++i)
+    {
+      const uint32_t m = __group_free (map->ctrl + g * GROUP);
+      if (m != 0)
+	return g * GROUP + bits_ctz (m);
+      g = (g + i + 1) & gmask;
+    }
+}
+
+/* Rebuilds the table, bigger unless it only ran out to tombstones */
+static bool
+__rehash (map_t * map)
+{
+  uint64_t cap = map->cap;
+  if (map->size + 1 > (cap - cap / 8) / 2)
+    cap *= 2;
+  map_t old = *map;
+  if (!__alloc_table (map, cap))
+    {
+      *map = old;
+      return false;
+    }
+  uint64_t i;
+  for (i = 0; i < old.cap; ++i)
+    if (!(old.ctrl[i] & 0x80))
+      {
+	const map_slot_t *slot = &old.slots[i];
+	const uint64_t hash = __hash (map, slot->key,
+				      map_key_len (&old, slot));
+	const uint64_t idx = __find_free (map, hash);
+	map->ctrl[idx] = hash & 0x7F;
+	map->slots[idx] = *slot;
+      }
+  map->growth_left = cap - cap / 8 - map->size;
+  free (old.ctrl);
+  free (old.slots);
+  return true;
+}
+
+map_t *
+map_new (bool bytes)
+{
+  map_t *map = calloc (1, sizeof (map_t));
+  if (map == NULL)
+    return NULL;
+  map->bytes = bytes;
+  if (!__alloc_table (map, GROUP))
+    {
+      free (map);
+      return NULL;
+    }
+  return map;
+}
+
+void
+map_free (map_t * map)
+{
+  if (map == NULL)
+    return;
+  if (map->bytes)
+    {
+      uint64_t i;
+      for (i = 0; i < map->cap; ++i)
+	if (!(map->ctrl[i] & 0x80))
+	  free (KEY_BLOCK (map->slots[i].key));
+    }
+  free (map->ctrl);
+  free (map->slots);
+  free (map);
+}
+
+map_slot_t *
+map_find (const map_t * map, uint64_t key, uint64_t len)
+{
+  const int64_t idx = __find (map, __hash (map, key, len), key, len);
+  return idx < 0 ? NULL : &map->slots[idx];
+}
+
+/* Returns the slot of the key, added with the value 0 if it was not there */
+static map_slot_t *
+__upsert (map_t * map, uint64_t key, uint64_t len)
+{
+  const uint64_t hash = __hash (map, key, len);
+  const int64_t found = __find (map, hash, key, len);
+  if (found >= 0)
+    return &map->slots[found];
+
+  if (map->bytes)
+    {
+      uint64_t *copy = malloc (sizeof (uint64_t) + len);
+      if (copy == NULL)
+	return NULL;
+      copy[0] = len;
+      memcpy (copy + 1, (const void *) key, len);
+      key = (uint64_t) (copy + 1);
+    }
+
+  uint64_t idx = __find_free (map, hash);
+  if (map->ctrl[idx] == CTRL_EMPTY && map->growth_left == 0)
+    {
+      if (!__rehash (map))
+	{
+	  if (map->bytes)
+	    free (KEY_BLOCK (key));
+	  return NULL;
+	}
+      idx = __find_free (map, hash);
+    }
+  if (map->ctrl[idx] == CTRL_EMPTY)
+    --map->growth_left;
+  map->ctrl[idx] = hash & 0x7F;
+  map->slots[idx] = (map_slot_t) {
+    .key = key,
+    .val = 0
+  };
+  ++map->size;
+  return &map->slots[idx];
+}
+
+bool
+map_put (map_t * map, uint64_t key, uint64_t len, uint64_t val)
+{
+  map_slot_t *slot = __upsert (map, key, len);
+  if (slot == NULL)
+    return false;
+  slot->val = val;
+  return true;
+}
+
+bool
+map_add (map_t * map, uint64_t key, uint64_t len, uint64_t inc,
+	 uint64_t * val)
+{
+  map_slot_t *slot = __upsert (map, key, len);
+  if (slot == NULL)
+    return false;
+  *val = slot->val += inc;
+  return true;
+}
+
+bool
+map_del (map_t * map, uint64_t key, uint64_t len)
+{
+  const int64_t idx = __find (map, __hash (map, key, len), key, len);
+  if (idx < 0)
+    return false;
+  if (map->bytes)
+    free (KEY_BLOCK (map->slots[idx].key));
+  /*
+   * Probes already stop at this group if it has an empty slot, so the
+   * slot can go back to empty. Otherwise it has to stay a tombstone.
+   */
+  const uint8_t *group = map->ctrl + (idx & ~(uint64_t) (GROUP - 1));
+  if (__group_match (group, CTRL_EMPTY) != 0)
+    {
+      map->ctrl[idx] = CTRL_EMPTY;
+      ++map->growth_left;
+    }
+  else
+    map->ctrl[idx] = CTRL_DELETED;
+  --map->size;
+  return true;
+}
+
+map_slot_t *
+map_next (const map_t * map, uint64_t * cursor)
+{
+  uint64_t i;
+  for (i = *cursor; i < map->cap; ++i)
+    if (!(map->ctrl[i] & 0x80))
+      {
+	*cursor = i + 1;
+	return &map->slots[i];
+      }
+  *cursor = map->cap;
+  return NULL;
+}
+
+uint64_t
+map_key_len (const map_t * map, const map_slot_t * slot)
+{
+  return map->bytes ? KEY_LEN (slot->key) : 0;
+}
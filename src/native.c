@@ -0,0 +1,112 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "native.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The registry. Lookups only happen when bytecode is loaded, never per
+ * call, so a plain array searched from the front is enough.
+ */
+typedef struct native_ent_t
+{
+  char *name;
+  native_t nat;
+} native_ent_t;
+
+static native_ent_t *registry;
+static size_t reg_len;
+static size_t reg_cap;
+
+static native_ent_t *
+__find (const char *name)
+{
+  size_t i;
+  for (i = 0; i < reg_len; ++i)
+    if (strcmp (registry[i].name, name) == 0)
+      return &registry[i];
+  return NULL;
+}
+
+bool
+native_register (const char *name, native_fn_t fn, void *data)
+{
+  native_ent_t *ent = __find (name);
+  if (ent != NULL)
+    {
+      ent->nat = (native_t)
+      {
+      .fn = fn,.data = data};
+      return true;
+    }
+  if (reg_len == reg_cap)
+    {
+      const size_t cap = reg_cap == 0 ? 16 : reg_cap * 2;
+      native_ent_t *grown = realloc (registry, cap * sizeof (native_ent_t));
+      if (grown == NULL)
+	return false;
+      registry = grown;
+      reg_cap = cap;
+    }
+  const size_t len = strlen (name) + 1;
+  char *copy = malloc (len);
+  if (copy == NULL)
+    return false;
+  memcpy (copy, name, len);
+  registry[reg_len++] = (native_ent_t)
+  {
+    .name = copy,.nat = (native_t)
+    {
+    .fn = fn,.data = data}
+  };
+  return true;
+}
+
+native_t *
+native_bind (const char *names, uint64_t size, uint64_t * count)
+{
+  uint64_t n = 0;
+  uint64_t i;
+  for (i = 0; i < size; ++i)
+    if (names[i] == '\0')
+      ++n;
+  *count = 0;
+  if (n == 0)
+    return NULL;
+  native_t *slots = calloc (n, sizeof (native_t));
+  if (slots == NULL)
+    return NULL;
+  const char *name = names;
+  for (i = 0; i < n; ++i)
+    {
+      const native_ent_t *ent = __find (name);
+      if (ent != NULL)
+	slots[i] = ent->nat;
+      name += strlen (name) + 1;
+    }
+  *count = n;
+  return slots;
+}
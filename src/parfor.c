@@ -0,0 +1,397 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "parfor.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+ * Using union to reinterpret_cast between a 64 bit integer and
+ * a double (which according to the IEEE, it is 64-bits)
+ */
+union fp_i_conv_t
+{
+  uint64_t ival;
+  double fval;
+};
+
+/* Each thread gets roughly this many chunks to even out the load */
+#define CHUNKS_PER_THREAD 4
+
+typedef struct parjob_t
+{
+  rlvm_t *vm;
+  uint64_t len;
+  opcode_t *ops;
+  opcode_t instr;
+  opcode_t red;
+  uint64_t lo;
+  uint64_t chunk;
+  uint64_t count;		/* Number of elements in the range */
+  uint64_t nchunks;
+  uint64_t next;		/* Next chunk to hand out (atomic) */
+  uint64_t icount;		/* Instructions executed by all chunks */
+  status_t fault;		/* First chunk that did not finish cleanly */
+  uint64_t *acc;		/* One partial reduction per thread */
+} parjob_t;
+
+static pthread_mutex_t pool_owner = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static parjob_t *pool_job = NULL;
+static uint64_t pool_gen = 0;
+static size_t pool_busy = 0;
+static size_t pool_size = 0;	/* Number of threads already spawned */
+static size_t pool_active = 0;	/* Workers taking part in pool_job */
+static size_t pool_want = 0;	/* Zero means one per online cpu */
+static __thread bool pool_worker = false;
+
+void
+set_parfor_threads (size_t count)
+{
+  pool_want = count;
+}
+
+size_t
+get_parfor_threads (void)
+{
+  if (pool_want == 0)
+    {
+      const long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+      return ncpu < 1 ? 1 : ncpu;
+    }
+  return pool_want;
+}
+
+bool
+red_defined (opcode_t pred)
+{
+  if (!pred.fvar.rt)
+    return pred.fvar.sa <= RED_SMAX;
+  switch (pred.fvar.sa)
+    {
+    case RED_ADD:
+    case RED_MUL:
+    case RED_MIN:
+    case RED_MAX:
+      return true;
+    default:
+      return false;
+    }
+}
+
+static inline uint64_t
+__red_identity (opcode_t red)
+{
+  if (red.fvar.rt)
+    {
+      union fp_i_conv_t conv;
+      switch (red.fvar.sa)
+	{
+	case RED_MUL:
+	  conv.fval = 1.0;
+	  break;
+	case RED_MIN:
+	  conv.fval = INFINITY;
+	  break;
+	case RED_MAX:
+	  conv.fval = -INFINITY;
+	  break;
+	default:
+	  conv.fval = 0.0;
+	  break;
+	}
+      return conv.ival;
+    }
+  switch (red.fvar.sa)
+    {
+    case RED_MUL:
+      return 1;
+    case RED_AND:
+    case RED_MIN:
+      return UINT64_MAX;
+    case RED_SMIN:
+      return INT64_MAX;
+    case RED_SMAX:
+      return (uint64_t) INT64_MIN;
+    default:
+      return 0;
+    }
+}
+
+static inline uint64_t
+__red_combine (opcode_t red, uint64_t lhs, uint64_t rhs)
+{
+  if (red.fvar.rt)
+    {
+      union fp_i_conv_t a = {.ival = lhs };
+      union fp_i_conv_t b = {.ival = rhs };
+      switch (red.fvar.sa)
+	{
+	case RED_MUL:
+	  a.fval *= b.fval;
+	  break;
+	case RED_MIN:
+	  a.fval = fmin (a.fval, b.fval);
+	  break;
+	case RED_MAX:
+	  a.fval = fmax (a.fval, b.fval);
+	  break;
+	default:
+	  a.fval += b.fval;
+	  break;
+	}
+      return a.ival;
+    }
+  switch (red.fvar.sa)
+    {
+    case RED_MUL:
+      return lhs * rhs;
+    case RED_AND:
+      return lhs & rhs;
+    case RED_OR:
+      return lhs | rhs;
+    case RED_XOR:
+      return lhs ^ rhs;
+    case RED_MIN:
+      return lhs < rhs ? lhs : rhs;
+    case RED_MAX:
+      return lhs > rhs ? lhs : rhs;
+    case RED_SMIN:
+      return (int64_t) lhs < (int64_t) rhs ? lhs : rhs;
+    case RED_SMAX:
+      return (int64_t) lhs > (int64_t) rhs ? lhs : rhs;
+    default:
+      return lhs + rhs;
+    }
+}
+
+static inline uint64_t *
+__red_reg (rlvm_t * vm, opcode_t red)
+{
+  if (red.fvar.rt)
+    return (uint64_t *) & vm->fregs[red.fvar.rs];
+  return &vm->iregs[red.fvar.rs];
+}
+
+/*
+ * Runs chunks until there are none left. The VM is set up once per
+ * thread and only its registers and stack pointers are reset between
+ * chunks, so a chunk costs about as much as a CALL.
+ */
+static void
+run_chunks (parjob_t * job, size_t slot)
+{
+  rlvm_t *vm = job->vm;
+  rlvm_t wvm = init_rlvm (vm->stack_size, vm->handler_size, vm->ropool);
+  wvm.fin = vm->fin;
+  wvm.fout = vm->fout;
+  wvm.ferr = vm->ferr;
+  wvm.natives = vm->natives;
+  wvm.native_count = vm->native_count;
+  const bool reduce = job->red.bytes != 0;
+  uint64_t acc = reduce ? __red_identity (job->red) : 0;
+  uint64_t c;
+
+  while ((c = __sync_fetch_and_add (&job->next, 1)) < job->nchunks)
+    {
+      if (job->fault.state != CLEAN)
+	break;
+      memcpy (wvm.iregs, vm->iregs, sizeof (wvm.iregs));
+      memcpy (wvm.fregs, vm->fregs, sizeof (wvm.fregs));
+      memcpy (wvm.vregs, vm->vregs, sizeof (wvm.vregs));
+      if (reduce)
+	*__red_reg (&wvm, job->red) = __red_identity (job->red);
+
+      const uint64_t off = c * job->chunk;
+      const uint64_t end =
+	job->count - off < job->chunk ? job->count : off + job->chunk;
+      wvm.iregs[job->instr.svar.rs] = job->lo + off;
+      wvm.iregs[job->instr.svar.rt] = job->lo + end;
+
+      wvm.sp = wvm.esp = 0;
+      wvm.red.bytes = 0;
+      wvm.state = (status_t)
+      {
+      .state = CLEAN,.uid = 0};
+      if (wvm.stack_size == 0)
+	{
+	  wvm.state = (status_t)
+	  {
+	  .state = STACK_OFLOW,.uid = 0};
+	}
+      else
+	{
+	  /* Returning to the end of the code stops the interpreter */
+	  wvm.stack[wvm.sp++] = job->len;
+	  wvm.ip = job->instr.svar.immediate;
+	  exec_bytecode (&wvm, job->len, job->ops);
+	}
+
+      if (wvm.state.state != CLEAN)
+	{
+	  __sync_bool_compare_and_swap (&job->fault.bytes, 0,
+					wvm.state.bytes);
+	  break;
+	}
+      if (reduce)
+	acc = __red_combine (job->red, acc, *__red_reg (&wvm, job->red));
+    }
+  job->acc[slot] = acc;
+  __sync_fetch_and_add (&job->icount, wvm.icount);
+  clean_rlvm (&wvm);
+}
+
+typedef struct poolarg_t
+{
+  size_t slot;
+  uint64_t gen;			/* Jobs up to this one are not ours */
+} poolarg_t;
+
+static void *
+pool_main (void *arg)
+{
+  const size_t slot = ((poolarg_t *) arg)->slot;
+  uint64_t seen = ((poolarg_t *) arg)->gen;
+
+  free (arg);
+  pool_worker = true;
+  pthread_mutex_lock (&pool_lock);
+  for (;;)
+    {
+      while (pool_gen == seen)
+	pthread_cond_wait (&pool_wake, &pool_lock);
+      seen = pool_gen;
+      if (slot >= pool_active)
+	continue;
+      parjob_t *job = pool_job;
+      pthread_mutex_unlock (&pool_lock);
+
+      run_chunks (job, slot);
+
+      pthread_mutex_lock (&pool_lock);
+      if (--pool_busy == 0)
+	pthread_cond_signal (&pool_done);
+    }
+  return NULL;
+}
+
+/*
+ * Grows the pool to nthreads - 1 workers (the calling thread is the
+ * last one) and returns how many of them a job may use. The pool
+ * never shrinks, workers past the count sit the job out. Must be
+ * called with pool_owner held.
+ */
+static size_t
+grow_pool (size_t nthreads)
+{
+  while (pool_size + 1 < nthreads)
+    {
+      pthread_t tid;
+      poolarg_t *arg = malloc (sizeof (poolarg_t));
+      if (arg == NULL)
+	break;
+      *arg = (poolarg_t)
+      {
+      .slot = pool_size,.gen = pool_gen};
+      if (pthread_create (&tid, NULL, &pool_main, arg) != 0)
+	{
+	  free (arg);
+	  break;
+	}
+      pthread_detach (tid);
+      ++pool_size;
+    }
+  return pool_size + 1 < nthreads ? pool_size : nthreads - 1;
+}
+
+status_t
+exec_parfor (rlvm_t * vm, const uint64_t len, opcode_t * ops, opcode_t instr)
+{
+  const uint64_t lo = vm->iregs[instr.svar.rs];
+  const uint64_t hi = vm->iregs[instr.svar.rt];
+  parjob_t job = (parjob_t)
+  {
+  .vm = vm,.len = len,.ops = ops,.instr = instr,.red = vm->red,.lo =
+      lo,.count = hi > lo ? hi - lo : 0,.next = 0,.icount = 0,.fault = (status_t)
+    {
+    .state = CLEAN,.uid = 0}
+  };
+  vm->red.bytes = 0;
+  if (job.count == 0)
+    return job.fault;
+
+  /*
+   * Nested PARFORs and PARFORs from VMs running on other host threads
+   * do not wait for the pool; they run their chunks on this thread.
+   */
+  size_t nworkers = 0;
+  const bool own_pool = !pool_worker
+    && pthread_mutex_trylock (&pool_owner) == 0;
+  if (own_pool)
+    nworkers = grow_pool (get_parfor_threads ());
+
+  job.nchunks = (nworkers + 1) * CHUNKS_PER_THREAD;
+  if (job.nchunks > job.count)
+    job.nchunks = job.count;
+  job.chunk = (job.count + job.nchunks - 1) / job.nchunks;
+  job.nchunks = (job.count + job.chunk - 1) / job.chunk;
+
+  uint64_t acc[nworkers + 1];
+  job.acc = acc;
+
+  if (nworkers > 0)
+    {
+      pthread_mutex_lock (&pool_lock);
+      pool_job = &job;
+      pool_active = nworkers;
+      pool_busy = nworkers;
+      ++pool_gen;
+      pthread_cond_broadcast (&pool_wake);
+      pthread_mutex_unlock (&pool_lock);
+    }
+  run_chunks (&job, nworkers);
+  if (nworkers > 0)
+    {
+      pthread_mutex_lock (&pool_lock);
+      while (pool_busy != 0)
+	pthread_cond_wait (&pool_done, &pool_lock);
+      pthread_mutex_unlock (&pool_lock);
+    }
+  if (own_pool)
+    pthread_mutex_unlock (&pool_owner);
+  vm->icount += job.icount;
+
+  if (job.fault.state == CLEAN && job.red.bytes != 0)
+    {
+      uint64_t *reg = __red_reg (vm, job.red);
+      size_t i;
+      for (i = 0; i <= nworkers; ++i)
+	*reg = __red_combine (job.red, *reg, acc[i]);
+    }
+  return job.fault;
+}
@@ -23,6 +23,9 @@
  */
 
 #include "rasm.h"
+#include "vector.h"
+
+#include <strings.h>
 
 typedef void (*disf_t) (opcode_t, FILE *);
 
@@ -129,6 +132,19 @@ dis_opcode_0 (opcode_t opcode, FILE * out)
 	  fprintf (out, "pldex r%d\n", opcode.fvar.rd);
 	  break;
 	}
+      break;
+    case 10:
+      {
+	static const char *const red_names[] =
+	  { "add", "mul", "and", "or", "xor", "min", "max", "smin", "smax" };
+	if (opcode.fvar.sa < sizeof (red_names) / sizeof (red_names[0]))
+	  fprintf (out, "pred %s,%s%d\n", red_names[opcode.fvar.sa],
+		   opcode.fvar.rt ? "fp" : "r", opcode.fvar.rs);
+	break;
+      }
+    case 11:
+      fprintf (out, "mark r%d\n", opcode.fvar.rd);
+      break;
     }
 }
 
@@ -213,29 +229,37 @@ dis_opcode_1 (opcode_t opcode, FILE * out)
 static void
 dis_opcode_2 (opcode_t opcode, FILE * out)
 {
-  switch (opcode.fvar.fn)
+  static const char *const name[] = {
+    "add", "sub", "mul", "div", "mod", "sqrt", "fma", "abs", "min", "max",
+    "floor", "ceil", "round", "exp", "log", "pow", "sin", "cos", "atan2"
+  };
+  const unsigned int fn = opcode.fvar.fn;
+  if (fn >= sizeof (name) / sizeof (name[0]))
     {
-    case 0:
-      fprintf (out, "add fp%d,fp%d,fp%d", opcode.fvar.rd, opcode.fvar.rs,
-	       opcode.fvar.rt);
-      break;
-    case 1:
-      fprintf (out, "sub fp%d,fp%d,fp%d", opcode.fvar.rd, opcode.fvar.rs,
-	       opcode.fvar.rt);
-      break;
-    case 2:
-      fprintf (out, "mul fp%d,fp%d,fp%d", opcode.fvar.rd, opcode.fvar.rs,
-	       opcode.fvar.rt);
+      fprintf (out, "(Unsupported instruction)\n");
+      return;
+    }
+  fprintf (out, "%s fp%d,fp%d", name[fn], opcode.fvar.rd, opcode.fvar.rs);
+  switch (fn)
+    {
+    case 5:
+    case 7:
+    case 10:
+    case 11:
+    case 12:
+    case 13:
+    case 14:
+    case 16:
+    case 17:
       break;
-    case 3:
-      fprintf (out, "div fp%d,fp%d,fp%d", opcode.fvar.rd, opcode.fvar.rs,
-	       opcode.fvar.rt);
+    case 6:
+      fprintf (out, ",fp%d,fp%d", opcode.fvar.rt, opcode.fvar.sa);
       break;
-    case 4:
-      fprintf (out, "mod fp%d,fp%d,fp%d", opcode.fvar.rd, opcode.fvar.rs,
-	       opcode.fvar.rt);
+    default:
+      fprintf (out, ",fp%d", opcode.fvar.rt);
       break;
     }
+  fprintf (out, "\n");
 }
 
 static void
@@ -607,6 +631,513 @@ dis_opcode_41 (opcode_t opcode, FILE * out)
   fprintf (out, "\n");
 }
 
+static void
+dis_opcode_42 (opcode_t opcode, FILE * out)
+{
+  fprintf (out, "parfor r%d,r%d,%u\n", opcode.svar.rs, opcode.svar.rt,
+	   opcode.svar.immediate);
+}
+
+static const char *const vec_op_names[] = {
+  "vld", "vst", "mov", "and", "or", "xor", "vblend", "vadd", "vsub", "vmul",
+  "vdiv", "vmin", "vmax", "vfma", "vcmp", "vshuf", "vbcst", "vsum", "vrmin",
+  "vrmax", "vmask", "vget", "vset", "vabs", "vsqrt", "vfloor", "vceil",
+  "vround"
+};
+
+static const char *const vec_type_names[] = {
+  "b", "w", "d", "q", "ps", "pd"
+};
+
+static const char *const vec_pred_names[] = {
+  "eq", "ne", "lt", "gt"
+};
+
+#define NAMES_LEN(names) (sizeof (names) / sizeof (names[0]))
+
+int
+parse_vec_op (const char *mnemonic)
+{
+  const char *dot = strchr (mnemonic, '.');
+  if (dot == NULL)
+    return -1;
+  const size_t len = dot - mnemonic;
+  int type;
+  for (type = 0; type < (int) NAMES_LEN (vec_type_names); ++type)
+    if (strcasecmp (dot + 1, vec_type_names[type]) == 0)
+      break;
+  if (type == NAMES_LEN (vec_type_names))
+    return -1;
+
+  /* Only the typed ones are written with a dot */
+  int op;
+  for (op = VEC_BLEND + 1; op < (int) NAMES_LEN (vec_op_names); ++op)
+    if (op != VEC_CMP && strlen (vec_op_names[op]) == len
+	&& strncasecmp (mnemonic, vec_op_names[op], len) == 0)
+      return op | type << 8;
+  int pred;
+  for (pred = 0; pred < (int) NAMES_LEN (vec_pred_names); ++pred)
+    if (len == 6 && strncasecmp (mnemonic, "vcmp", 4) == 0
+	&& strncasecmp (mnemonic + 4, vec_pred_names[pred], 2) == 0)
+      return VEC_CMP | (pred << 3 | type) << 8;
+  return -1;
+}
+
+static void
+dis_opcode_43 (opcode_t opcode, FILE * out)
+{
+  const unsigned int type = opcode.fvar.sa & 7;
+  const unsigned int pred = opcode.fvar.sa >> 3;
+  const char *reg = vec_is_float (type) ? "fp" : "r";
+  if (opcode.fvar.fn >= NAMES_LEN (vec_op_names)
+      || type >= NAMES_LEN (vec_type_names))
+    {
+      fprintf (out, "(Unsupported instruction)\n");
+      return;
+    }
+
+  switch (opcode.fvar.fn)
+    {
+    case VEC_LD:
+      fprintf (out, "vld v%d,r%d\n", opcode.fvar.rd, opcode.fvar.rs);
+      return;
+    case VEC_ST:
+      fprintf (out, "vst v%d,r%d\n", opcode.fvar.rt, opcode.fvar.rs);
+      return;
+    case VEC_MOV:
+      fprintf (out, "mov v%d,v%d\n", opcode.fvar.rd, opcode.fvar.rs);
+      return;
+    case VEC_AND:
+    case VEC_OR:
+    case VEC_XOR:
+    case VEC_BLEND:
+      fprintf (out, "%s v%d,v%d,v%d\n", vec_op_names[opcode.fvar.fn],
+	       opcode.fvar.rd, opcode.fvar.rs, opcode.fvar.rt);
+      return;
+    case VEC_CMP:
+      fprintf (out, "vcmp%s.%s v%d,v%d,v%d\n", vec_pred_names[pred & 3],
+	       vec_type_names[type], opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      return;
+    case VEC_BCST:
+      fprintf (out, "vbcst.%s v%d,%s%d\n", vec_type_names[type],
+	       opcode.fvar.rd, reg, opcode.fvar.rs);
+      return;
+    case VEC_SUM:
+    case VEC_RMIN:
+    case VEC_RMAX:
+      fprintf (out, "%s.%s %s%d,v%d\n", vec_op_names[opcode.fvar.fn],
+	       vec_type_names[type], reg, opcode.fvar.rd, opcode.fvar.rs);
+      return;
+    case VEC_MASK:
+      fprintf (out, "vmask.%s r%d,v%d\n", vec_type_names[type],
+	       opcode.fvar.rd, opcode.fvar.rs);
+      return;
+    case VEC_GET:
+      fprintf (out, "vget.%s %s%d,v%d,r%d\n", vec_type_names[type], reg,
+	       opcode.fvar.rd, opcode.fvar.rs, opcode.fvar.rt);
+      return;
+    case VEC_SET:
+      fprintf (out, "vset.%s v%d,%s%d,r%d\n", vec_type_names[type],
+	       opcode.fvar.rd, reg, opcode.fvar.rs, opcode.fvar.rt);
+      return;
+    case VEC_ABS:
+    case VEC_SQRT:
+    case VEC_FLOOR:
+    case VEC_CEIL:
+    case VEC_ROUND:
+      fprintf (out, "%s.%s v%d,v%d\n", vec_op_names[opcode.fvar.fn],
+	       vec_type_names[type], opcode.fvar.rd, opcode.fvar.rs);
+      return;
+    default:
+      fprintf (out, "%s.%s v%d,v%d,v%d\n", vec_op_names[opcode.fvar.fn],
+	       vec_type_names[type], opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      return;
+    }
+}
+
+static void
+dis_opcode_44 (opcode_t opcode, FILE * out)
+{
+  switch (opcode.fvar.fn)
+    {
+    case 0:
+      fprintf (out, "memcpy r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 1:
+      fprintf (out, "memmove r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 2:
+      fprintf (out, "memset r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 3:
+      fprintf (out, "memcmp r%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 4:
+      fprintf (out, "strlen r%d,r%d", opcode.fvar.rd, opcode.fvar.rs);
+      break;
+    case 5:
+      fprintf (out, "memchr r%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 6:
+      fprintf (out, "memrchr r%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 7:
+      fprintf (out, "strcmp r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 8:
+      fprintf (out, "strstr r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 9:
+      fprintf (out, "memmem r%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 10:
+      fprintf (out, "utf8chk r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 11:
+      fprintf (out, "crc32c r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case 12:
+      fprintf (out, "hash r%d,r%d,r%d,r%d", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 13:
+      fprintf (out, "hashinit r%d,r%d", opcode.fvar.rs, opcode.fvar.rt);
+      break;
+    case 14:
+      fprintf (out, "hashupd r%d,r%d,r%d", opcode.fvar.rs, opcode.fvar.rt,
+	       opcode.fvar.sa);
+      break;
+    case 15:
+      fprintf (out, "hashfin r%d,r%d", opcode.fvar.rd, opcode.fvar.rs);
+      break;
+    case 16:
+      fprintf (out, "csvscan r%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 17:
+      fprintf (out, "parseint r%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    case 18:
+      fprintf (out, "parseflt fp%d,r%d,r%d,r%d", opcode.fvar.rd,
+	       opcode.fvar.rs, opcode.fvar.rt, opcode.fvar.sa);
+      break;
+    default:
+      fprintf (out, "(Unsupported instruction)");
+      break;
+    }
+  fprintf (out, "\n");
+}
+
+/* The bytecode being disassembled, LDK looks its constant up in the pool */
+static const bcode_t *dis_code;
+
+static void
+dis_opcode_45 (opcode_t opcode, FILE * out)
+{
+  const bcode_t *code = dis_code;
+  const uint64_t off = RLVM_LDK_SLOT (opcode) * sizeof (uint64_t);
+  const bool fp = opcode.svar.rt & RLVM_LDK_FP;
+  fprintf (out, "mov %s%d,", fp ? "fp" : "r", opcode.svar.rs);
+  if (off + sizeof (uint64_t) > code->ropool_size)
+    {
+      fprintf (out, "(Constant out of the pool)\n");
+      return;
+    }
+  uint64_t k;
+  memcpy (&k, code->ropool + off, sizeof (k));
+  if (fp)
+    {
+      double d;
+      memcpy (&d, &k, sizeof (d));
+      fprintf (out, "%.17g\n", d);
+    }
+  else
+    fprintf (out, "0x%" PRIx64 "\n", k);
+}
+
+static void
+dis_opcode_46 (opcode_t opcode, FILE * out)
+{
+  static const char *const names = "bwdq";
+  const unsigned size = opcode.fvar.fn & 3;
+  const bool fp = opcode.fvar.fn & RLVM_HX_FP;
+  const int64_t disp = ((opcode.fvar.sa ^ 0x10) - 0x10) * (1 << size);
+  fprintf (out, "%s%c %s%d,[r%d+r%d*%d", opcode.fvar.fn & RLVM_HX_ST ?
+	   "st" : "ld", names[size], fp ? "fp" : "r", opcode.fvar.rd,
+	   opcode.fvar.rs, opcode.fvar.rt, 1 << (opcode.fvar.fn >> 2 & 3));
+  if (disp != 0)
+    fprintf (out, "%+" PRId64, disp);
+  fprintf (out, "]\n");
+}
+
+static void
+dis_opcode_47 (opcode_t opcode, FILE * out)
+{
+  static const char *const names = "bwdq";
+  const unsigned size = opcode.fvar.fn & 3;
+  const bool fp = opcode.fvar.fn & RLVM_HX_FP;
+  const int step = (opcode.fvar.sa ^ 0x10) - 0x10;
+  if ((opcode.fvar.fn & 0xC) != RLVM_SM_POST)
+    {
+      fprintf (out, "(Unsupported instruction)\n");
+      return;
+    }
+  fprintf (out, "%s%c %s%d,[r%d]",
+	   (opcode.fvar.fn & RLVM_HX_ST) ? "st" : "ld", names[size],
+	   fp ? "fp" : "r", opcode.fvar.rd, opcode.fvar.rs);
+  if (step != 0)
+    fprintf (out, "%+d", step);
+  fprintf (out, "\n");
+}
+
+static void
+dis_opcode_48 (opcode_t opcode, FILE * out)
+{
+  fprintf (out, "dbnz r%d,%u\n", opcode.svar.rs, opcode.svar.immediate);
+}
+
+static void
+dis_opcode_49 (opcode_t opcode, FILE * out)
+{
+  static const char *const cc[] = { "e", "l", "g", "z" };
+  const unsigned int flag = opcode.fvar.fn & 0xF;
+  const char *lhs = (flag & RLVM_CC_FP) ? "fp" : "r";
+  const char *dst = "r";
+  switch (opcode.fvar.fn & 0x30)
+    {
+    case RLVM_CC_SET:
+      fprintf (out, "set");
+      break;
+    case RLVM_CC_MOVF:
+      dst = "fp";
+      /* fall through */
+    case RLVM_CC_MOV:
+      fprintf (out, "cmov");
+      break;
+    case RLVM_CC_SELECT:
+      dst = (flag & RLVM_CC_FP) ? "fp" : "r";
+      fprintf (out, "select %s%d,r%d,%s%d,%s%d\n", dst, opcode.fvar.rd,
+	       opcode.fvar.sa, dst, opcode.fvar.rs, dst, opcode.fvar.rt);
+      return;
+    }
+  fprintf (out, "%s%s %s%d,%s%d", (flag & RLVM_CC_SIGNED) ? "s" : "",
+	   cc[flag & 3], dst, opcode.fvar.rd, lhs, opcode.fvar.rs);
+  if ((flag & 3) != RLVM_CC_ZERO)
+    fprintf (out, ",%s%d", lhs, opcode.fvar.rt);
+  if ((opcode.fvar.fn & 0x30) != RLVM_CC_SET)
+    fprintf (out, ",%s%d", dst, opcode.fvar.sa);
+  fprintf (out, "\n");
+}
+
+static void
+dis_opcode_50 (opcode_t opcode, FILE * out)
+{
+  static const char *const name[] =
+    { "popcnt", "clz", "ctz", "bswap", "pext", "pdep", "mulhu", "mulhs" };
+  if (opcode.fvar.fn >= sizeof (name) / sizeof (name[0]))
+    {
+      fprintf (out, "(Unsupported instruction)\n");
+      return;
+    }
+  fprintf (out, "%s r%d,r%d", name[opcode.fvar.fn], opcode.fvar.rd,
+	   opcode.fvar.rs);
+  if (opcode.fvar.fn >= RLVM_BIT_PEXT)
+    fprintf (out, ",r%d", opcode.fvar.rt);
+  fprintf (out, "\n");
+}
+
+static void
+dis_opcode_51 (opcode_t opcode, FILE * out)
+{
+  const bcode_t *code = dis_code;
+  const uint64_t off = opcode.svar.immediate;
+  fprintf (out, "switch r%d,%u", opcode.svar.rs, opcode.svar.immediate);
+  uint32_t cases;
+  if (off + sizeof (cases) > code->ropool_size)
+    {
+      fprintf (out, " (Table out of the pool)\n");
+      return;
+    }
+  memcpy (&cases, code->ropool + off, sizeof (cases));
+  fprintf (out, " (%" PRIu32 " cases)\n", cases);
+}
+
+static void
+dis_opcode_52 (opcode_t opcode, FILE * out)
+{
+  if (opcode.svar.rt & 1)
+    fprintf (out, "tailcall r%d,%u\n", opcode.svar.rs, opcode.svar.immediate);
+  else
+    fprintf (out, "tailcall %u\n", opcode.svar.immediate);
+}
+
+static void
+dis_opcode_53 (opcode_t opcode, FILE * out)
+{
+  const bcode_t *code = dis_code;
+  const uint64_t off = RLVM_LDK_SLOT (opcode) * sizeof (uint64_t);
+  fprintf (out, (opcode.svar.rs & RLVM_SAVE_RESTORE) ? "restore " : "save ");
+  if (off + sizeof (uint64_t) > code->ropool_size)
+    {
+      fprintf (out, "(Mask out of the pool)\n");
+      return;
+    }
+  uint64_t mask;
+  memcpy (&mask, code->ropool + off, sizeof (mask));
+  int r;
+  const char *sep = "";
+  for (r = 0; r < 64; ++r)
+    if (mask >> r & 1)
+      {
+	fprintf (out, "%s%s%d", sep, r < 32 ? "r" : "fp", r & 31);
+	sep = ",";
+      }
+  fprintf (out, "\n");
+}
+
+static void
+dis_opcode_54 (opcode_t opcode, FILE * out)
+{
+  static const char *const name[] =
+    { "lds r", "lds fp", "sts r", "stfbs fp" };
+  const int64_t off = opcode.svar.immediate & 0x2000
+    ? (int64_t) (opcode.svar.immediate & 0x3FFF) - 0x4000
+    : (int64_t) (opcode.svar.immediate & 0x3FFF);
+  fprintf (out, "%s%d,[r%d%+" PRId64 "]\n", name[opcode.svar.immediate >> 14],
+	   opcode.svar.rt, opcode.svar.rs, off);
+}
+
+static void
+dis_opcode_55 (opcode_t opcode, FILE * out)
+{
+  const int rs = opcode.fvar.rs;
+  const int rt = opcode.fvar.rt;
+  const int rd = opcode.fvar.rd;
+  const int sa = opcode.fvar.sa;
+  switch (opcode.fvar.fn)
+    {
+    case RLVM_MAP_NEW:
+      if (sa & 1)
+	fprintf (out, "mapnew r%d,1\n", rd);
+      else
+	fprintf (out, "mapnew r%d\n", rd);
+      break;
+    case RLVM_MAP_FREE:
+      fprintf (out, "mapfree r%d\n", rs);
+      break;
+    case RLVM_MAP_GET:
+      fprintf (out, "mapget r%d,r%d,r%d,r%d\n", rd, rs, rt, sa);
+      break;
+    case RLVM_MAP_PUT:
+      fprintf (out, "mapput r%d,r%d,r%d\n", rs, rt, rd);
+      break;
+    case RLVM_MAP_DEL:
+      fprintf (out, "mapdel r%d,r%d,r%d\n", rd, rs, rt);
+      break;
+    case RLVM_MAP_LEN:
+      fprintf (out, "maplen r%d,r%d\n", rd, rs);
+      break;
+    case RLVM_MAP_NEXT:
+      fprintf (out, "mapnext r%d,r%d,r%d,r%d\n", rd, rs, rt, sa);
+      break;
+    case RLVM_MAP_ADD:
+      fprintf (out, "mapadd r%d,r%d,r%d,r%d\n", rd, rs, rt, sa);
+      break;
+    default:
+      fprintf (out, "(Unsupported instruction)\n");
+      break;
+    }
+}
+
+static void
+dis_opcode_56 (opcode_t opcode, FILE * out)
+{
+  static const char *const prefix[] = { "", "s", "f", "?" };
+  const int kind = opcode.fvar.fn & RLVM_SORT_KIND;
+  if (opcode.fvar.fn & RLVM_SORT_LBOUND)
+    {
+      fprintf (out, "%slbound%s r%d,r%d,r%d,%s%d\n",
+	       kind == RLVM_SORT_SIGNED ? "s" : "",
+	       opcode.fvar.fn & RLVM_SORT_DESC ? "d" : "",
+	       opcode.fvar.rd, opcode.fvar.rs, opcode.fvar.rt,
+	       kind == RLVM_SORT_FLOAT ? "fp" : "r", opcode.fvar.sa);
+      return;
+    }
+  fprintf (out, "%ssort%s r%d,r%d", prefix[kind],
+	   opcode.fvar.fn & RLVM_SORT_DESC ? "d" : "",
+	   opcode.fvar.rs, opcode.fvar.rt);
+  if (opcode.fvar.fn & RLVM_SORT_PAIRS)
+    fprintf (out, ",r%d", opcode.fvar.rd);
+  fprintf (out, "\n");
+}
+
+static void
+dis_opcode_57 (opcode_t opcode, FILE * out)
+{
+  static const char *const name[] =
+    { "sbnew", "sbfree", "sbchr", "sbstr", "sbint", "sbuint", "sbhex",
+    "sbflt", "sbflush", "sblen"
+  };
+  const unsigned int fn = opcode.fvar.fn;
+  if (fn >= sizeof (name) / sizeof (name[0]))
+    {
+      fprintf (out, "(Unsupported instruction)\n");
+      return;
+    }
+  fprintf (out, "%s ", name[fn]);
+  switch (fn)
+    {
+    case RLVM_SB_NEW:
+      fprintf (out, "r%d\n", opcode.fvar.rd);
+      break;
+    case RLVM_SB_FREE:
+      fprintf (out, "r%d\n", opcode.fvar.rs);
+      break;
+    case RLVM_SB_FLT:
+      fprintf (out, "r%d,fp%d\n", opcode.fvar.rs, opcode.fvar.rt);
+      break;
+    case RLVM_SB_FLUSH:
+      fprintf (out, "r%d,r%d,r%d\n", opcode.fvar.rd, opcode.fvar.rs,
+	       opcode.fvar.rt);
+      break;
+    case RLVM_SB_LEN:
+      fprintf (out, "r%d,r%d\n", opcode.fvar.rd, opcode.fvar.rs);
+      break;
+    default:
+      fprintf (out, "r%d,r%d\n", opcode.fvar.rs, opcode.fvar.rt);
+      break;
+    }
+}
+
+static void
+dis_opcode_58 (opcode_t opcode, FILE * out)
+{
+  const bcode_t *code = dis_code;
+  const char *name = code->imports;
+  const char *end = code->imports + code->imports_size;
+  uint64_t slot;
+  for (slot = 0; name < end && slot < opcode.tvar.target; ++slot)
+    name += strlen (name) + 1;
+  if (name < end)
+    fprintf (out, "ncall %s\n", name);
+  else
+    fprintf (out, "ncall %u (Missing import)\n", opcode.tvar.target);
+}
+
 int
 disassemble (bcode_t * code, size_t count, FILE * out)
 {
@@ -624,9 +1155,19 @@ disassemble (bcode_t * code, size_t count, FILE * out)
       fprintf (out,
 	       "Code stack size:    %" PRIu64 "\n"
 	       "Error stack size:   %" PRIu64 "\n"
-	       "Data pool size:     %" PRIu64 "\n\n"
-	       "Disassembly of section TEXT\n",
+	       "Data pool size:     %" PRIu64 "\n",
 	       code[i].cstack_size, code[i].estack_size, code[i].ropool_size);
+      uint64_t off = 0;
+      while (off < code[i].exports_size)
+	{
+	  uint64_t addr;
+	  memcpy (&addr, code[i].exports + off, sizeof (addr));
+	  const char *name = code[i].exports + off + sizeof (addr);
+	  fprintf (out, "Export:             %s at %016" PRIx64 "\n", name,
+		   addr);
+	  off += sizeof (addr) + strlen (name) + 1;
+	}
+      fprintf (out, "\nDisassembly of section TEXT\n");
 
       static const disf_t dis_table[] =
 	{ &dis_opcode_0, &dis_opcode_1, &dis_opcode_2, &dis_opcode_3,
@@ -639,11 +1180,16 @@ disassemble (bcode_t * code, size_t count, FILE * out)
 	&dis_opcode_28, &dis_opcode_29, &dis_opcode_30, &dis_opcode_31,
 	&dis_opcode_32, &dis_opcode_33, &dis_opcode_34, &dis_opcode_35,
 	&dis_opcode_36, &dis_opcode_37, &dis_opcode_38, &dis_opcode_39,
-	&dis_opcode_40, &dis_opcode_41
+	&dis_opcode_40, &dis_opcode_41, &dis_opcode_42, &dis_opcode_43,
+	&dis_opcode_44, &dis_opcode_45, &dis_opcode_46, &dis_opcode_47,
+	&dis_opcode_48, &dis_opcode_49, &dis_opcode_50,
+	&dis_opcode_51, &dis_opcode_52, &dis_opcode_53, &dis_opcode_54,
+	&dis_opcode_55, &dis_opcode_56, &dis_opcode_57, &dis_opcode_58
       };
       static const size_t dtab_len =
 	sizeof (dis_table) / sizeof (dis_table[0]);
 
+      dis_code = &code[i];
       uint64_t ip;
       for (ip = 0; ip < code[i].code_size; ++ip)
 	{
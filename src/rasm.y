@@ -1,6 +1,7 @@
 %{
 #include "rasm.h"
 #include "bcode.h"
+#include "parfor.h"
 #include "lblmap.h"
 #include "instrbuf.h"
 
@@ -17,6 +18,17 @@ typedef enum section_t
   TEXT = 0, DATA
 } section_t;
 
+/* Operand shapes of the typed vector instructions */
+typedef enum vshape_t
+{
+  VS_VVV = 0,			/* v, v, v */
+  VS_VR,			/* v, r or v, fp */
+  VS_RV,			/* r, v or fp, v */
+  VS_RVR,			/* r, v, r or fp, v, r */
+  VS_VRR,			/* v, r, r or v, fp, r */
+  VS_VV				/* v, v */
+} vshape_t;
+
 typedef struct trunit_t
 {
   uint64_t stack_size;
@@ -38,6 +50,29 @@ extern "C"
 
   extern uint64_t get_lbl_addr (bool pref_data, char *str);
 
+  extern opcode_t vec_opc (int vop, vshape_t shape, bool fp, int d, int a,
+			   int b);
+
+  extern opcode_t mov_imm (int reg, uint64_t val);
+
+  extern opcode_t hx_opc (int mode, int reg, uint64_t addr);
+
+  extern opcode_t sm_opc (int mode, int reg, uint64_t addr);
+
+  extern opcode_t mov_fimm (int reg, double val);
+
+  extern opcode_t tailcall_opc (int reg, bool frame, uint64_t addr);
+
+  extern opcode_t save_opc (bool restore, uint64_t mask);
+
+  extern opcode_t frame_opc (int mode, int reg, uint64_t addr);
+
+  extern uint64_t import_slot (char *name);
+
+  extern void jt_add (char *lbl);
+
+  extern void jt_emit (void);
+
   extern FILE *yyin;
 
   extern int line_num;
@@ -73,17 +108,23 @@ extern "C"
  * 2 - Handle label collisions and generate code
  */
 
-%token COLON COMMA
-%token D_GLOBAL D_SECTION D_STACK D_ESTACK S_TEXT S_DATA S_STDOUT S_STDERR S_STDIN S_DB S_DW S_DD S_DQ K_HALT K_MOV K_MH32 K_ML32 K_ML16 K_ML8 K_SWP K_I2F K_B2F K_F2IF K_F2B K_F2IC K_RMEH K_THROW K_PUSH K_POP K_LDEX K_PLDEX K_ADD K_SUB K_MUL K_DIV K_MOD K_AND K_OR K_XOR K_NOT K_LSH K_RSH K_SRSH K_ROL K_ROR K_CALL K_JMP K_RET K_JE K_JL K_JG K_JLS K_JGS K_JOF K_JZ K_INEH K_LDS K_STS K_STFBS K_ALLOC K_FREE K_LDB K_LDW K_LDD K_LDQ K_STB K_STW K_STD K_STQ K_SJE K_SJL K_SJSL K_SJG K_SJSG K_SJZ K_LDC K_FOPEN K_FCLOSE K_FFLUSH K_FREWIND K_FREAD K_FWRTB K_FWRTQ K_FWRTS
+%token COLON COMMA LBRACK RBRACK PLUS MINUS STAR
+%token D_GLOBAL D_SECTION D_STACK D_ESTACK D_JUMPTABLE S_TEXT S_DATA S_STDOUT S_STDERR S_STDIN S_DB S_DW S_DD S_DQ
+%token <sval> K_HALT K_MOV K_MH32 K_ML32 K_ML16 K_ML8 K_SWP K_I2F K_B2F K_F2IF K_F2B K_F2IC K_RMEH K_THROW K_PUSH K_POP K_LDEX K_PLDEX K_ADD K_SUB K_MUL K_DIV K_MOD K_AND K_OR K_XOR K_NOT K_LSH K_RSH K_SRSH K_ROL K_ROR K_CALL K_JMP K_RET K_JE K_JL K_JG K_JLS K_JGS K_JOF K_JZ K_INEH K_LDS K_STS K_STFBS K_ALLOC K_FREE K_LDB K_LDW K_LDD K_LDQ K_STB K_STW K_STD K_STQ K_SJE K_SJL K_SJSL K_SJG K_SJSG K_SJZ K_LDC K_FOPEN K_FCLOSE K_FFLUSH K_FREWIND K_FREAD K_FWRTB K_FWRTQ K_FWRTS K_PRED K_PARFOR K_MIN K_MAX K_SMIN K_SMAX K_VLD K_VST K_VBLEND K_MEMCPY K_MEMMOVE K_MEMSET K_MEMCMP K_STRLEN K_MEMCHR K_MEMRCHR K_STRCMP K_STRSTR K_MEMMEM K_UTF8CHK K_CRC32C K_HASH K_HASHINIT K_HASHUPD K_HASHFIN K_DBNZ K_SETE K_SETL K_SETSL K_SETG K_SETSG K_SETZ K_CMOVE K_CMOVL K_CMOVSL K_CMOVG K_CMOVSG K_CMOVZ K_SELECT K_POPCNT K_CLZ K_CTZ K_BSWAP K_PEXT K_PDEP K_MULHU K_MULHS K_SWITCH K_TAILCALL K_MARK K_SAVE K_RESTORE K_MAPNEW K_MAPFREE K_MAPGET K_MAPPUT K_MAPDEL K_MAPLEN K_MAPNEXT K_MAPADD K_SORT K_SSORT K_FSORT K_SORTD K_SSORTD K_FSORTD K_LBOUND K_SLBOUND K_SBNEW K_SBFREE K_SBCHR K_SBSTR K_SBINT K_SBUINT K_SBHEX K_SBFLT K_SBFLUSH K_SBLEN K_CSVSCAN K_PARSEINT K_PARSEFLT K_SQRT K_FMA K_ABS K_FLOOR K_CEIL K_ROUND K_EXP K_LOG K_POW K_SIN K_COS K_ATAN2 K_NCALL
 
 %union
 {
   uint64_t ival;
+  double dval;
   char *sval;
 }
 
 %token <sval> LABEL STR
-%token <ival> INT IREG FREG
+%token <sval> VREG
+%token <ival> INT IREG FREG VOP
+%token <dval> FLT
+%type <sval> label keyword
+%type <ival> vreg sortOp redOp setCc cmovCc hxAddr hxScale hxDisp smAddr regMask regRange frameAddr
 
 %%
 
@@ -106,6 +147,22 @@ data:
 bytes:
     defLabel
     | cbytes
+    | jumpTable
+    ;
+
+jumpTable:
+    D_JUMPTABLE jtLabels {
+      jt_emit ();
+    }
+    ;
+
+jtLabels:
+    label {
+      jt_add ($1);
+    }
+    | jtLabels COMMA label {
+      jt_add ($3);
+    }
     ;
 
 cbytes:
@@ -165,7 +222,7 @@ stmt:
     ;
 
 defLabel:
-    LABEL COLON	{
+    label COLON	{
       switch (pass)
 	{
 	case 0:
@@ -195,7 +252,7 @@ defLabel:
     ;
 
 visDirectives:
-    D_GLOBAL LABEL {
+    D_GLOBAL label {
       switch (pass)
 	{
 	case 0:
@@ -477,12 +534,69 @@ visInstr:
     | K_MOD FREG COMMA FREG COMMA FREG {
       opc = RLVM_MODF ($2, $4, $6);
     }
+    | K_SQRT FREG COMMA FREG {
+      opc = RLVM_SQRTF ($2, $4);
+    }
+    | K_FMA FREG COMMA FREG COMMA FREG COMMA FREG {
+      opc = RLVM_FMAF ($2, $4, $6, $8);
+    }
+    | K_ABS FREG COMMA FREG {
+      opc = RLVM_ABSF ($2, $4);
+    }
+    | K_MIN FREG COMMA FREG COMMA FREG {
+      opc = RLVM_MINF ($2, $4, $6);
+    }
+    | K_MAX FREG COMMA FREG COMMA FREG {
+      opc = RLVM_MAXF ($2, $4, $6);
+    }
+    | K_FLOOR FREG COMMA FREG {
+      opc = RLVM_FLOORF ($2, $4);
+    }
+    | K_CEIL FREG COMMA FREG {
+      opc = RLVM_CEILF ($2, $4);
+    }
+    | K_ROUND FREG COMMA FREG {
+      opc = RLVM_ROUNDF ($2, $4);
+    }
+    | K_EXP FREG COMMA FREG {
+      opc = RLVM_EXPF ($2, $4);
+    }
+    | K_LOG FREG COMMA FREG {
+      opc = RLVM_LOGF ($2, $4);
+    }
+    | K_POW FREG COMMA FREG COMMA FREG {
+      opc = RLVM_POWF ($2, $4, $6);
+    }
+    | K_SIN FREG COMMA FREG {
+      opc = RLVM_SINF ($2, $4);
+    }
+    | K_COS FREG COMMA FREG {
+      opc = RLVM_COSF ($2, $4);
+    }
+    | K_ATAN2 FREG COMMA FREG COMMA FREG {
+      opc = RLVM_ATAN2F ($2, $4, $6);
+    }
     | K_MOV IREG COMMA INT {
-      opc = RLVM_IRLDI ($2, 0, $4);
+      opc = mov_imm ($2, $4);
+    }
+    | K_MOV FREG COMMA INT {
+      opc = mov_fimm ($2, (int64_t) $4);
+    }
+    | K_MOV FREG COMMA FLT {
+      opc = mov_fimm ($2, $4);
     }
     | K_MOV IREG COMMA INT COMMA K_LSH INT {
       opc = RLVM_IRLDI ($2, $7, $4);
     }
+    | K_MOV IREG COMMA label {
+      if (pass == 2)
+	{
+	  const uint64_t addr = get_lbl_addr (false, $4);
+	  if (addr > UINT16_MAX)
+	    yyerror ("Label address does not fit in MOV");
+	  opc = RLVM_IRLDI ($2, 0, addr);
+	}
+    }
     | K_ADD IREG COMMA IREG COMMA INT {
       opc = RLVM_ADDI ($2, $4, $6);
     }
@@ -507,46 +621,46 @@ visInstr:
     | K_XOR IREG COMMA IREG COMMA INT {
       opc = RLVM_XORI ($2, $4, $6);
     }
-    | K_CALL LABEL {
+    | K_CALL label {
       if (pass == 2)
 	opc = RLVM_CALL (get_lbl_addr (false, $2));
     }
-    | K_JMP LABEL {
+    | K_JMP label {
       if (pass == 2)
 	opc = RLVM_JMP (get_lbl_addr (false, $2));
     }
     | K_RET {
       opc = RLVM_RET ();
     }
-    | K_JE IREG COMMA IREG COMMA LABEL {
+    | K_JE IREG COMMA IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JE ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JL IREG COMMA IREG COMMA LABEL {
+    | K_JL IREG COMMA IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JL ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JG IREG COMMA IREG COMMA LABEL {
+    | K_JG IREG COMMA IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JG ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JLS IREG COMMA IREG COMMA LABEL {
+    | K_JLS IREG COMMA IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JLS ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JGS IREG COMMA IREG COMMA LABEL {
+    | K_JGS IREG COMMA IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JGS ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JE FREG COMMA FREG COMMA LABEL {
+    | K_JE FREG COMMA FREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JFE ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JL FREG COMMA FREG COMMA LABEL {
+    | K_JL FREG COMMA FREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JFL ($2, $4, get_lbl_addr (false, $6));
     }
-    | K_JG FREG COMMA FREG COMMA LABEL {
+    | K_JG FREG COMMA FREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JFG ($2, $4, get_lbl_addr (false, $6));
     }
@@ -562,15 +676,30 @@ visInstr:
     | K_JMP IREG COMMA K_LSH INT COMMA INT {
       opc = RLVM_JIR ($2, $5, $7);
     }
-    | K_JZ IREG COMMA LABEL {
+    | K_JZ IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JIRZ ($2, get_lbl_addr (false, $4));
     }
-    | K_JZ FREG COMMA LABEL {
+    | K_TAILCALL label {
+      if (pass == 2)
+	opc = tailcall_opc (0, false, get_lbl_addr (false, $2));
+    }
+    | K_TAILCALL IREG COMMA label {
+      if (pass == 2)
+	opc = tailcall_opc ($2, true, get_lbl_addr (false, $4));
+    }
+    | K_MARK IREG {
+      opc = RLVM_MARK ($2);
+    }
+    | K_DBNZ IREG COMMA label {
+      if (pass == 2)
+	opc = RLVM_DBNZ ($2, get_lbl_addr (false, $4));
+    }
+    | K_JZ FREG COMMA label {
       if (pass == 2)
 	opc = RLVM_JFRZ ($2, get_lbl_addr (false, $4));
     }
-    | K_INEH LABEL {
+    | K_INEH label {
       if (pass == 2)
 	opc = RLVM_INEH (get_lbl_addr (false, $2));
     }
@@ -589,6 +718,24 @@ visInstr:
     | K_STFBS FREG COMMA INT {
       opc = RLVM_FBST ($2, $4);
     }
+    | K_LDS IREG COMMA frameAddr {
+      opc = frame_opc (RLVM_FRAME_LD, $2, $4);
+    }
+    | K_LDS FREG COMMA frameAddr {
+      opc = frame_opc (RLVM_FRAME_LDF, $2, $4);
+    }
+    | K_STS IREG COMMA frameAddr {
+      opc = frame_opc (RLVM_FRAME_ST, $2, $4);
+    }
+    | K_STFBS FREG COMMA frameAddr {
+      opc = frame_opc (RLVM_FRAME_STF, $2, $4);
+    }
+    | K_SAVE regMask {
+      opc = save_opc (false, $2);
+    }
+    | K_RESTORE regMask {
+      opc = save_opc (true, $2);
+    }
     | K_ALLOC IREG COMMA INT {
       opc = RLVM_ALLOCI ($2, $4);
     }
@@ -622,6 +769,78 @@ visInstr:
     | K_STQ IREG COMMA IREG COMMA INT {
       opc = RLVM_STQ ($2, $4, $6);
     }
+    | K_LDB IREG COMMA hxAddr {
+      opc = hx_opc (0, $2, $4);
+    }
+    | K_LDW IREG COMMA hxAddr {
+      opc = hx_opc (1, $2, $4);
+    }
+    | K_LDD IREG COMMA hxAddr {
+      opc = hx_opc (2, $2, $4);
+    }
+    | K_LDQ IREG COMMA hxAddr {
+      opc = hx_opc (3, $2, $4);
+    }
+    | K_LDD FREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_FP | 2, $2, $4);
+    }
+    | K_LDQ FREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_FP | 3, $2, $4);
+    }
+    | K_STB IREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_ST | 0, $2, $4);
+    }
+    | K_STW IREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_ST | 1, $2, $4);
+    }
+    | K_STD IREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_ST | 2, $2, $4);
+    }
+    | K_STQ IREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_ST | 3, $2, $4);
+    }
+    | K_STD FREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_ST | RLVM_HX_FP | 2, $2, $4);
+    }
+    | K_STQ FREG COMMA hxAddr {
+      opc = hx_opc (RLVM_HX_ST | RLVM_HX_FP | 3, $2, $4);
+    }
+    | K_LDB IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | 0, $2, $4);
+    }
+    | K_LDW IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | 1, $2, $4);
+    }
+    | K_LDD IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | 2, $2, $4);
+    }
+    | K_LDQ IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | 3, $2, $4);
+    }
+    | K_LDD FREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_FP | 2, $2, $4);
+    }
+    | K_LDQ FREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_FP | 3, $2, $4);
+    }
+    | K_STB IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_ST | 0, $2, $4);
+    }
+    | K_STW IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_ST | 1, $2, $4);
+    }
+    | K_STD IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_ST | 2, $2, $4);
+    }
+    | K_STQ IREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_ST | 3, $2, $4);
+    }
+    | K_STD FREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_ST | RLVM_HX_FP | 2, $2, $4);
+    }
+    | K_STQ FREG COMMA smAddr {
+      opc = sm_opc (RLVM_SM_POST | RLVM_HX_ST | RLVM_HX_FP | 3, $2, $4);
+    }
     | K_SJE IREG COMMA IREG {
       opc = RLVM_SIREQ ($2, $4);
     }
@@ -652,14 +871,170 @@ visInstr:
     | K_SJZ FREG {
       opc = RLVM_SFRZ ($2);
     }
+    | setCc IREG COMMA IREG COMMA IREG {
+      opc = RLVM_SETCC ($1, $2, $4, $6);
+    }
+    | setCc IREG COMMA FREG COMMA FREG {
+      if ($1 & RLVM_CC_SIGNED)
+	yyerror ("Signed compare is not defined on float registers");
+      opc = RLVM_SETCC ($1 | RLVM_CC_FP, $2, $4, $6);
+    }
+    | K_SETZ IREG COMMA IREG {
+      opc = RLVM_SETCC (RLVM_CC_ZERO, $2, $4, 0);
+    }
+    | K_SETZ IREG COMMA FREG {
+      opc = RLVM_SETCC (RLVM_CC_ZERO | RLVM_CC_FP, $2, $4, 0);
+    }
+    | cmovCc IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_CMOV ($1, $2, $4, $6, $8);
+    }
+    | cmovCc IREG COMMA FREG COMMA FREG COMMA IREG {
+      if ($1 & RLVM_CC_SIGNED)
+	yyerror ("Signed compare is not defined on float registers");
+      opc = RLVM_CMOV ($1 | RLVM_CC_FP, $2, $4, $6, $8);
+    }
+    | cmovCc FREG COMMA IREG COMMA IREG COMMA FREG {
+      opc = RLVM_CMOVF ($1, $2, $4, $6, $8);
+    }
+    | cmovCc FREG COMMA FREG COMMA FREG COMMA FREG {
+      if ($1 & RLVM_CC_SIGNED)
+	yyerror ("Signed compare is not defined on float registers");
+      opc = RLVM_CMOVF ($1 | RLVM_CC_FP, $2, $4, $6, $8);
+    }
+    | K_CMOVZ IREG COMMA IREG COMMA IREG {
+      opc = RLVM_CMOV (RLVM_CC_ZERO, $2, $4, 0, $6);
+    }
+    | K_CMOVZ IREG COMMA FREG COMMA IREG {
+      opc = RLVM_CMOV (RLVM_CC_ZERO | RLVM_CC_FP, $2, $4, 0, $6);
+    }
+    | K_CMOVZ FREG COMMA IREG COMMA FREG {
+      opc = RLVM_CMOVF (RLVM_CC_ZERO, $2, $4, 0, $6);
+    }
+    | K_CMOVZ FREG COMMA FREG COMMA FREG {
+      opc = RLVM_CMOVF (RLVM_CC_ZERO | RLVM_CC_FP, $2, $4, 0, $6);
+    }
+    | K_SELECT IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_SELECT ($2, $4, $6, $8);
+    }
+    | K_SELECT FREG COMMA IREG COMMA FREG COMMA FREG {
+      opc = RLVM_FSELECT ($2, $4, $6, $8);
+    }
+    | K_POPCNT IREG COMMA IREG {
+      opc = RLVM_POPCNT ($2, $4);
+    }
+    | K_CLZ IREG COMMA IREG {
+      opc = RLVM_CLZ ($2, $4);
+    }
+    | K_CTZ IREG COMMA IREG {
+      opc = RLVM_CTZ ($2, $4);
+    }
+    | K_BSWAP IREG COMMA IREG {
+      opc = RLVM_BSWAP ($2, $4);
+    }
+    | K_PEXT IREG COMMA IREG COMMA IREG {
+      opc = RLVM_PEXT ($2, $4, $6);
+    }
+    | K_PDEP IREG COMMA IREG COMMA IREG {
+      opc = RLVM_PDEP ($2, $4, $6);
+    }
+    | K_MULHU IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MULHU ($2, $4, $6);
+    }
+    | K_MULHS IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MULHS ($2, $4, $6);
+    }
+    | K_MAPNEW IREG {
+      opc = RLVM_MAPNEW ($2, 0);
+    }
+    | K_MAPNEW IREG COMMA INT {
+      opc = RLVM_MAPNEW ($2, $4 != 0);
+    }
+    | K_MAPFREE IREG {
+      opc = RLVM_MAPFREE ($2);
+    }
+    | K_MAPGET IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MAPGET ($2, $4, $6, $8);
+    }
+    | K_MAPPUT IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MAPPUT ($2, $4, $6);
+    }
+    | K_MAPDEL IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MAPDEL ($2, $4, $6);
+    }
+    | K_MAPLEN IREG COMMA IREG {
+      opc = RLVM_MAPLEN ($2, $4);
+    }
+    | K_MAPNEXT IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MAPNEXT ($2, $4, $6, $8);
+    }
+    | K_MAPADD IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MAPADD ($2, $4, $6, $8);
+    }
+    | sortOp IREG COMMA IREG {
+      opc = RLVM_SORT ($2, $4, $1);
+    }
+    | sortOp IREG COMMA IREG COMMA IREG {
+      opc = RLVM_SORTKV ($2, $4, $6, $1);
+    }
+    | K_LBOUND IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_LBOUND ($2, $4, $6, $8, RLVM_SORT_UNSIGNED);
+    }
+    | K_SLBOUND IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_LBOUND ($2, $4, $6, $8, RLVM_SORT_SIGNED);
+    }
+    | K_LBOUND IREG COMMA IREG COMMA IREG COMMA FREG {
+      opc = RLVM_LBOUND ($2, $4, $6, $8, RLVM_SORT_FLOAT);
+    }
+    | K_SBNEW IREG {
+      opc = RLVM_SBNEW ($2);
+    }
+    | K_SBFREE IREG {
+      opc = RLVM_SBFREE ($2);
+    }
+    | K_SBCHR IREG COMMA IREG {
+      opc = RLVM_SBCHR ($2, $4);
+    }
+    | K_SBSTR IREG COMMA IREG {
+      opc = RLVM_SBSTR ($2, $4);
+    }
+    | K_SBINT IREG COMMA IREG {
+      opc = RLVM_SBINT ($2, $4);
+    }
+    | K_SBUINT IREG COMMA IREG {
+      opc = RLVM_SBUINT ($2, $4);
+    }
+    | K_SBHEX IREG COMMA IREG {
+      opc = RLVM_SBHEX ($2, $4);
+    }
+    | K_SBFLT IREG COMMA FREG {
+      opc = RLVM_SBFLT ($2, $4);
+    }
+    | K_SBFLUSH IREG COMMA IREG COMMA IREG {
+      opc = RLVM_SBFLUSH ($2, $4, $6);
+    }
+    | K_SBLEN IREG COMMA IREG {
+      opc = RLVM_SBLEN ($2, $4);
+    }
+    | K_NCALL label {
+      opc = RLVM_NCALL (import_slot ($2));
+    }
     | K_LDC IREG COMMA IREG COMMA INT {
       if (pass == 2)
 	opc = RLVM_LDPO ($2, $4, $6);
     }
-    | K_LDC IREG COMMA LABEL {
+    | K_LDC IREG COMMA label {
       if (pass == 2)
 	opc = RLVM_LDPA ($2, get_lbl_addr (true, $4));
     }
+    | K_SWITCH IREG COMMA label {
+      if (pass == 2)
+	{
+	  const uint64_t addr = get_lbl_addr (true, $4);
+	  if (addr > UINT16_MAX)
+	    yyerror ("Jump table is not in the first 64K of the pool");
+	  opc = RLVM_SWITCH ($2, addr);
+	}
+    }
     | K_FREAD IREG COMMA IREG {
       opc = RLVM_FREAD_CH ($2, $4);
     }
@@ -702,6 +1077,442 @@ visInstr:
     | K_FWRTS IREG COMMA IREG COMMA IREG {
       opc = RLVM_FWRITE_STR ($2, $4, $6);
     }
+    | K_PRED redOp COMMA IREG {
+      opc = RLVM_PRED ($4, 0, $2);
+    }
+    | K_PRED redOp COMMA FREG {
+      opc = RLVM_PRED ($4, 1, $2);
+      if (!red_defined (opc))
+	yyerror ("Reduction is not defined on float registers");
+    }
+    | K_PARFOR IREG COMMA IREG COMMA label {
+      if (pass == 2)
+	opc = RLVM_PARFOR ($2, $4, get_lbl_addr (false, $6));
+    }
+    | K_VLD vreg COMMA IREG {
+      opc = RLVM_VLD ($2, $4);
+    }
+    | K_VST vreg COMMA IREG {
+      opc = RLVM_VST ($2, $4);
+    }
+    | K_MOV vreg COMMA vreg {
+      opc = RLVM_VOP (VEC_MOV, 0, $2, $4, 0);
+    }
+    | K_AND vreg COMMA vreg COMMA vreg {
+      opc = RLVM_VOP (VEC_AND, 0, $2, $4, $6);
+    }
+    | K_OR vreg COMMA vreg COMMA vreg {
+      opc = RLVM_VOP (VEC_OR, 0, $2, $4, $6);
+    }
+    | K_XOR vreg COMMA vreg COMMA vreg {
+      opc = RLVM_VOP (VEC_XOR, 0, $2, $4, $6);
+    }
+    | K_VBLEND vreg COMMA vreg COMMA vreg {
+      opc = RLVM_VOP (VEC_BLEND, 0, $2, $4, $6);
+    }
+    | K_MEMCPY IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMCPY ($2, $4, $6);
+    }
+    | K_MEMMOVE IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMMOVE ($2, $4, $6);
+    }
+    | K_MEMSET IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMSET ($2, $4, $6);
+    }
+    | K_MEMCMP IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMCMP ($2, $4, $6, $8);
+    }
+    | K_STRLEN IREG COMMA IREG {
+      opc = RLVM_STRLEN ($2, $4);
+    }
+    | K_MEMCHR IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMCHR ($2, $4, $6, $8);
+    }
+    | K_MEMRCHR IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMRCHR ($2, $4, $6, $8);
+    }
+    | K_STRCMP IREG COMMA IREG COMMA IREG {
+      opc = RLVM_STRCMP ($2, $4, $6);
+    }
+    | K_STRSTR IREG COMMA IREG COMMA IREG {
+      opc = RLVM_STRSTR ($2, $4, $6);
+    }
+    | K_MEMMEM IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_MEMMEM ($2, $4, $6, $8);
+    }
+    | K_UTF8CHK IREG COMMA IREG COMMA IREG {
+      opc = RLVM_UTF8CHK ($2, $4, $6);
+    }
+    | K_CRC32C IREG COMMA IREG COMMA IREG {
+      opc = RLVM_CRC32C ($2, $4, $6);
+    }
+    | K_HASH IREG COMMA IREG COMMA IREG {
+      opc = RLVM_HASH ($2, $4, $6, $2);
+    }
+    | K_HASH IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_HASH ($2, $4, $6, $8);
+    }
+    | K_HASHINIT IREG COMMA IREG {
+      opc = RLVM_HASHINIT ($2, $4);
+    }
+    | K_HASHUPD IREG COMMA IREG COMMA IREG {
+      opc = RLVM_HASHUPD ($2, $4, $6);
+    }
+    | K_HASHFIN IREG COMMA IREG {
+      opc = RLVM_HASHFIN ($2, $4);
+    }
+    | K_CSVSCAN IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_CSVSCAN ($2, $4, $6, $8);
+    }
+    | K_PARSEINT IREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_PARSEINT ($2, $4, $6, $8);
+    }
+    | K_PARSEFLT FREG COMMA IREG COMMA IREG COMMA IREG {
+      opc = RLVM_PARSEFLT ($2, $4, $6, $8);
+    }
+    | VOP vreg COMMA vreg COMMA vreg {
+      opc = vec_opc ($1, VS_VVV, false, $2, $4, $6);
+    }
+    | VOP vreg COMMA vreg {
+      opc = vec_opc ($1, VS_VV, false, $2, $4, 0);
+    }
+    | VOP vreg COMMA IREG {
+      opc = vec_opc ($1, VS_VR, false, $2, $4, 0);
+    }
+    | VOP vreg COMMA FREG {
+      opc = vec_opc ($1, VS_VR, true, $2, $4, 0);
+    }
+    | VOP IREG COMMA vreg {
+      opc = vec_opc ($1, VS_RV, false, $2, $4, 0);
+    }
+    | VOP FREG COMMA vreg {
+      opc = vec_opc ($1, VS_RV, true, $2, $4, 0);
+    }
+    | VOP IREG COMMA vreg COMMA IREG {
+      opc = vec_opc ($1, VS_RVR, false, $2, $4, $6);
+    }
+    | VOP FREG COMMA vreg COMMA IREG {
+      opc = vec_opc ($1, VS_RVR, true, $2, $4, $6);
+    }
+    | VOP vreg COMMA IREG COMMA IREG {
+      opc = vec_opc ($1, VS_VRR, false, $2, $4, $6);
+    }
+    | VOP vreg COMMA FREG COMMA IREG {
+      opc = vec_opc ($1, VS_VRR, true, $2, $4, $6);
+    }
+    ;
+
+/* [base + index * scale + disp] as base | index << 5 | log2 (scale) << 10 | disp << 12 */
+hxAddr:
+    LBRACK IREG PLUS IREG hxScale hxDisp RBRACK {
+      $$ = $2 | $4 << 5 | $5 << 10 | $6 << 12;
+    }
+    ;
+
+/* [base], [base]+ or [base]- (by one element or #) as base | step << 5 */
+smAddr:
+    LBRACK IREG RBRACK { $$ = $2; }
+    | LBRACK IREG RBRACK PLUS { $$ = $2 | 1 << 5; }
+    | LBRACK IREG RBRACK MINUS { $$ = $2 | (uint64_t) -1 << 5; }
+    | LBRACK IREG RBRACK PLUS INT { $$ = $2 | $5 << 5; }
+    | LBRACK IREG RBRACK MINUS INT { $$ = $2 | -$5 << 5; }
+    | LBRACK IREG RBRACK INT {
+      /* [r1]-2 lexes the step as a negative number */
+      if ((int64_t) $4 >= 0)
+	yyerror ("Expected + or - before the step");
+      $$ = $2 | $4 << 5;
+    }
+    ;
+
+hxScale:
+    /* Empty */ { $$ = 0; }
+    | STAR INT {
+      switch ($2)
+	{
+	case 1:
+	  $$ = 0;
+	  break;
+	case 2:
+	  $$ = 1;
+	  break;
+	case 4:
+	  $$ = 2;
+	  break;
+	case 8:
+	  $$ = 3;
+	  break;
+	default:
+	  yyerror ("Index scale must be 1, 2, 4 or 8");
+	  $$ = 0;
+	  break;
+	}
+    }
+    ;
+
+hxDisp:
+    /* Empty */ { $$ = 0; }
+    | PLUS INT { $$ = $2; }
+    | MINUS INT { $$ = -$2; }
+    | INT {
+      /* [r1 + r2*8-16] lexes the displacement as a negative number */
+      if ((int64_t) $1 >= 0)
+	yyerror ("Expected + or - before the displacement");
+      $$ = $1;
+    }
+    ;
+
+frameAddr:
+    LBRACK IREG hxDisp RBRACK {
+      if ((int64_t) $3 < -8192 || (int64_t) $3 > 8191)
+	yyerror ("Frame offset must be between -8192 and 8191");
+      $$ = $2 | ($3 & 0x3FFF) << 5;
+    }
+    ;
+
+regMask:
+    regRange
+    | regMask COMMA regRange { $$ = $1 | $3; }
+    ;
+
+regRange:
+    IREG { $$ = (uint64_t) 1 << $1; }
+    | FREG { $$ = (uint64_t) 1 << ($1 + 32); }
+    | IREG MINUS IREG {
+      if ($3 < $1)
+	yyerror ("Register range goes backwards");
+      $$ = (((uint64_t) 2 << $3) - 1) & ~(((uint64_t) 1 << $1) - 1);
+    }
+    | FREG MINUS FREG {
+      if ($3 < $1)
+	yyerror ("Register range goes backwards");
+      $$ = ((((uint64_t) 2 << $3) - 1) & ~(((uint64_t) 1 << $1) - 1)) << 32;
+    }
+    ;
+
+setCc:
+    K_SETE { $$ = RLVM_CC_EQ; }
+    | K_SETL { $$ = RLVM_CC_LT; }
+    | K_SETSL { $$ = RLVM_CC_LT | RLVM_CC_SIGNED; }
+    | K_SETG { $$ = RLVM_CC_GT; }
+    | K_SETSG { $$ = RLVM_CC_GT | RLVM_CC_SIGNED; }
+    ;
+
+cmovCc:
+    K_CMOVE { $$ = RLVM_CC_EQ; }
+    | K_CMOVL { $$ = RLVM_CC_LT; }
+    | K_CMOVSL { $$ = RLVM_CC_LT | RLVM_CC_SIGNED; }
+    | K_CMOVG { $$ = RLVM_CC_GT; }
+    | K_CMOVSG { $$ = RLVM_CC_GT | RLVM_CC_SIGNED; }
+    ;
+
+/*
+ * A label may share its name with a keyword or a vector register, the
+ * lexer hands both their text for this. Labels own their string,
+ * keywords and registers do not.
+ */
+label:
+    LABEL
+    | keyword {
+      $$ = strdup ($1);
+    }
+    | VREG {
+      $$ = strdup ($1);
+    }
+    ;
+
+vreg:
+    VREG {
+      $$ = atoi ($1 + 1);
+    }
+    ;
+
+keyword:
+    K_HALT
+    | K_MOV
+    | K_MH32
+    | K_ML32
+    | K_ML16
+    | K_ML8
+    | K_SWP
+    | K_I2F
+    | K_B2F
+    | K_F2IF
+    | K_F2B
+    | K_F2IC
+    | K_RMEH
+    | K_THROW
+    | K_PUSH
+    | K_POP
+    | K_LDEX
+    | K_PLDEX
+    | K_ADD
+    | K_SUB
+    | K_MUL
+    | K_DIV
+    | K_MOD
+    | K_AND
+    | K_OR
+    | K_XOR
+    | K_NOT
+    | K_LSH
+    | K_RSH
+    | K_SRSH
+    | K_ROL
+    | K_ROR
+    | K_CALL
+    | K_JMP
+    | K_RET
+    | K_JE
+    | K_JL
+    | K_JG
+    | K_JLS
+    | K_JGS
+    | K_JOF
+    | K_JZ
+    | K_INEH
+    | K_LDS
+    | K_STS
+    | K_STFBS
+    | K_ALLOC
+    | K_FREE
+    | K_LDB
+    | K_LDW
+    | K_LDD
+    | K_LDQ
+    | K_STB
+    | K_STW
+    | K_STD
+    | K_STQ
+    | K_SJE
+    | K_SJL
+    | K_SJSL
+    | K_SJG
+    | K_SJSG
+    | K_SJZ
+    | K_LDC
+    | K_FOPEN
+    | K_FCLOSE
+    | K_FFLUSH
+    | K_FREWIND
+    | K_FREAD
+    | K_FWRTB
+    | K_FWRTQ
+    | K_FWRTS
+    | K_PRED
+    | K_PARFOR
+    | K_MIN
+    | K_MAX
+    | K_SMIN
+    | K_SMAX
+    | K_VLD
+    | K_VST
+    | K_VBLEND
+    | K_MEMCPY
+    | K_MEMMOVE
+    | K_MEMSET
+    | K_MEMCMP
+    | K_STRLEN
+    | K_MEMCHR
+    | K_MEMRCHR
+    | K_STRCMP
+    | K_STRSTR
+    | K_MEMMEM
+    | K_UTF8CHK
+    | K_CRC32C
+    | K_HASH
+    | K_HASHINIT
+    | K_HASHUPD
+    | K_HASHFIN
+    | K_DBNZ
+    | K_SETE
+    | K_SETL
+    | K_SETSL
+    | K_SETG
+    | K_SETSG
+    | K_SETZ
+    | K_CMOVE
+    | K_CMOVL
+    | K_CMOVSL
+    | K_CMOVG
+    | K_CMOVSG
+    | K_CMOVZ
+    | K_SELECT
+    | K_POPCNT
+    | K_CLZ
+    | K_CTZ
+    | K_BSWAP
+    | K_PEXT
+    | K_PDEP
+    | K_MULHU
+    | K_MULHS
+    | K_SWITCH
+    | K_TAILCALL
+    | K_MARK
+    | K_SAVE
+    | K_RESTORE
+    | K_MAPNEW
+    | K_MAPFREE
+    | K_MAPGET
+    | K_MAPPUT
+    | K_MAPDEL
+    | K_MAPLEN
+    | K_MAPNEXT
+    | K_MAPADD
+    | K_SORT
+    | K_SSORT
+    | K_FSORT
+    | K_SORTD
+    | K_SSORTD
+    | K_FSORTD
+    | K_LBOUND
+    | K_SLBOUND
+    | K_SBNEW
+    | K_SBFREE
+    | K_SBCHR
+    | K_SBSTR
+    | K_SBINT
+    | K_SBUINT
+    | K_SBHEX
+    | K_SBFLT
+    | K_SBFLUSH
+    | K_SBLEN
+    | K_CSVSCAN
+    | K_PARSEINT
+    | K_PARSEFLT
+    | K_SQRT
+    | K_FMA
+    | K_ABS
+    | K_FLOOR
+    | K_CEIL
+    | K_ROUND
+    | K_EXP
+    | K_LOG
+    | K_POW
+    | K_SIN
+    | K_COS
+    | K_ATAN2
+    | K_NCALL
+    ;
+
+redOp:
+    K_ADD { $$ = RED_ADD; }
+    | K_MUL { $$ = RED_MUL; }
+    | K_AND { $$ = RED_AND; }
+    | K_OR { $$ = RED_OR; }
+    | K_XOR { $$ = RED_XOR; }
+    | K_MIN { $$ = RED_MIN; }
+    | K_MAX { $$ = RED_MAX; }
+    | K_SMIN { $$ = RED_SMIN; }
+    | K_SMAX { $$ = RED_SMAX; }
+    ;
+
+sortOp:
+    K_SORT { $$ = RLVM_SORT_UNSIGNED; }
+    | K_SSORT { $$ = RLVM_SORT_SIGNED; }
+    | K_FSORT { $$ = RLVM_SORT_FLOAT; }
+    | K_SORTD { $$ = RLVM_SORT_UNSIGNED | RLVM_SORT_DESC; }
+    | K_SSORTD { $$ = RLVM_SORT_SIGNED | RLVM_SORT_DESC; }
+    | K_FSORTD { $$ = RLVM_SORT_FLOAT | RLVM_SORT_DESC; }
     ;
 
 %%
@@ -716,6 +1527,139 @@ size_t tunit_idx;
 uint64_t code_len;
 uint64_t pool_len;
 section_t section;
+bool optimize = false;
+
+/*
+ * Wide constants. Pass 0 collects every distinct value MOV cannot
+ * encode as an immediate, they are appended to the pool (aligned to 8
+ * bytes) after all the data and loaded with LDK by slot.
+ */
+static lblmap_t kmap;
+static uint64_t *kvals;
+static uint64_t kcount;
+static uint64_t kcap;
+static uint64_t kbase;		/* Pool slot of kvals[0] */
+
+/*
+ * Imports. Pass 0 gives every distinct name NCALL uses the next slot
+ * and appends it to the table that goes into the bytecode.
+ */
+static lblmap_t imap;
+static char *inames;
+static uint64_t inames_len;
+static uint64_t nimports;
+
+/*
+ * Jump tables. Their entries are text addresses, which are not all
+ * known while pass 0 writes the pool, so pass 0 writes zeros and keeps
+ * a fixup per entry that is patched once every pass is done.
+ */
+typedef struct jt_fixup_t
+{
+  uint64_t off;
+  char *lbl;
+  size_t unit;
+  int line;
+} jt_fixup_t;
+
+static char **jt_lbls;		/* Labels of the table being parsed */
+static size_t jt_len;
+static size_t jt_cap;
+static jt_fixup_t *jt_fix;
+static size_t jt_nfix;
+static size_t jt_fixcap;
+
+/* Marks the code addresses that a label points at */
+static void
+mark_labels (lblmap_t * map, bool *marks, uint64_t len)
+{
+  size_t i;
+  for (i = 0; i < map->bucket_size; ++i)
+    {
+      lblmap_ent_t *ent;
+      for (ent = map->ptr[i]; ent != NULL; ent = ent->next)
+	if (!ent->data_flag && ent->val < len)
+	  marks[ent->val] = true;
+    }
+}
+
+/*
+ * Writes the export table: the address and name of every global text
+ * label. Data labels are left out, there is nothing to call there.
+ */
+static char *
+collect_exports (lblmap_t * map, uint64_t * size)
+{
+  char *buf = NULL;
+  size_t len = 0;
+  FILE *f = open_memstream (&buf, &len);
+  size_t i;
+  for (i = 0; i < map->bucket_size; ++i)
+    {
+      lblmap_ent_t *ent;
+      for (ent = map->ptr[i]; ent != NULL; ent = ent->next)
+	if (!ent->data_flag)
+	  {
+	    fwrite (&ent->val, sizeof (ent->val), 1, f);
+	    fwrite (ent->key, sizeof (char), strlen (ent->key) + 1, f);
+	  }
+    }
+  fclose (f);
+  *size = len;
+  return buf;
+}
+
+/*
+ * Rewrites SUB rN, rN, 1 / JZ rN, out / JMP top, with out right after
+ * the JMP, into DBNZ rN, top / JMP out. The loop then takes a single
+ * dispatch per round. The JMP top stays behind (dead) so no address
+ * moves, which is also why nothing a label points into is touched.
+ */
+static void
+fold_counted_loops (bcode_t * obj, const bool *marks)
+{
+  uint64_t ip;
+  for (ip = 0; ip + 2 < obj->code_size; ++ip)
+    {
+      const opcode_t dec = obj->code[ip];
+      const opcode_t jz = obj->code[ip + 1];
+      const opcode_t jmp = obj->code[ip + 2];
+      if (dec.svar.opcode != 5 || dec.svar.rs != dec.svar.rt
+	  || dec.svar.immediate != 1)
+	continue;
+      if (jz.svar.opcode != 25 || jz.svar.rt != 0
+	  || jz.svar.rs != dec.svar.rs || jz.svar.immediate != ip + 3)
+	continue;
+      if (jmp.tvar.opcode != 13 || jmp.tvar.target > UINT16_MAX)
+	continue;
+      if (marks[ip + 1] || marks[ip + 2])
+	continue;
+      obj->code[ip] = RLVM_DBNZ (dec.svar.rs, jmp.tvar.target);
+      obj->code[ip + 1] = RLVM_JMP (ip + 3);
+    }
+}
+
+/*
+ * Rewrites CALL x / RET into TAILCALL x. The callee then returns
+ * straight to our caller. The RET stays so jumps to it still work.
+ * Without the return address in between, a callee that reads its
+ * caller's frame with LDS from its own MARK finds those words one
+ * slot closer, so such code must not be assembled with -O.
+ */
+static void
+fold_tail_calls (bcode_t * obj)
+{
+  uint64_t ip;
+  for (ip = 0; ip + 1 < obj->code_size; ++ip)
+    {
+      const opcode_t call = obj->code[ip];
+      if (call.tvar.opcode != 12 || obj->code[ip + 1].tvar.opcode != 14)
+	continue;
+      if (call.tvar.target > UINT16_MAX)
+	continue;
+      obj->code[ip] = RLVM_TAILCALL (0, 0, call.tvar.target);
+    }
+}
 
 static inline
 int
@@ -746,6 +1690,16 @@ assemble (FILE **in, size_t count)
 
   code_len = pass = 0;
   glmap = init_map (64);
+  kmap = init_map (64);
+  kvals = NULL;
+  kcount = kcap = 0;
+  imap = init_map (64);
+  inames = NULL;
+  inames_len = nimports = 0;
+  jt_fix = NULL;
+  jt_nfix = jt_fixcap = 0;
+  jt_lbls = NULL;
+  jt_len = jt_cap = 0;
 
   for (tunit_idx = 0; tunit_idx < count; ++tunit_idx)
     {
@@ -763,6 +1717,20 @@ assemble (FILE **in, size_t count)
     }
   ++pass, code_len = 0;
 
+  if (kcount > 0)
+    {
+      fflush (ropool);
+      while (pool_len % sizeof (uint64_t) != 0)
+	{
+	  putc (0, ropool);
+	  fflush (ropool);
+	}
+      kbase = pool_len / sizeof (uint64_t);
+      if (kbase + kcount > RLVM_LDK_SLOTS)
+	yyerror ("Constants do not fit in the pool");
+      fwrite (kvals, sizeof (uint64_t), kcount, ropool);
+    }
+
   for (tunit_idx = 0; tunit_idx < count; ++tunit_idx)
     {
       yyin = in[tunit_idx];
@@ -791,6 +1759,20 @@ assemble (FILE **in, size_t count)
   fflush (ropool);
   fclose (ropool);
 
+  for (i = 0; i < jt_nfix; ++i)
+    {
+      tunit_idx = jt_fix[i].unit;
+      line_num = jt_fix[i].line;
+      const uint64_t addr = get_lbl_addr (false, jt_fix[i].lbl);
+      if (addr > UINT32_MAX)
+	yyerror ("Jump table target does not fit");
+      const uint32_t ent = addr;
+      memcpy (pool_dat + jt_fix[i].off, &ent, sizeof (ent));
+      free (jt_fix[i].lbl);
+    }
+  free (jt_fix);
+  free (jt_lbls);
+
   size_t final_cssize = 0;
   size_t final_essize = 0;
 
@@ -809,8 +1791,11 @@ assemble (FILE **in, size_t count)
     .ropool_size = pool_len,
     .code_size = code_len,
     .code = calloc (sizeof (opcode_t), code_len),
-    .ropool = pool_dat /* DO NOT FREE ropool_dat! */
+    .ropool = pool_dat, /* DO NOT FREE ropool_dat! */
+    .imports_size = inames_len,
+    .imports = inames
   };
+  obj.exports = collect_exports (&glmap, &obj.exports_size);
 
   size_t off;
   for (i = off = 0; i < count; ++i)
@@ -820,7 +1805,24 @@ assemble (FILE **in, size_t count)
       off += trans_unit[i].ibuf.size;
     }
 
+  if (optimize && code_len > 0)
+    {
+      bool *marks = calloc (code_len, sizeof (bool));
+      mark_labels (&glmap, marks, code_len);
+      for (i = 0; i < count; ++i)
+	mark_labels (&trans_unit[i].lmap, marks, code_len);
+      fold_counted_loops (&obj, marks);
+      fold_tail_calls (&obj);
+      free (marks);
+    }
+
+  if (!link_natives (&obj))
+    yyerror ("Out of memory binding native imports");
+
   free_map (&glmap);
+  free_map (&kmap);
+  free_map (&imap);
+  free (kvals);
   for (i = 0; i < count; ++i)
     {
       free_map (&trans_unit[i].lmap);
@@ -831,6 +1833,53 @@ assemble (FILE **in, size_t count)
   return obj;
 }
 
+opcode_t
+vec_opc (int vop, vshape_t shape, bool fp, int d, int a, int b)
+{
+  const int op = vop & 0xFF;
+  const int sa = vop >> 8;
+  vshape_t want;
+  switch (op)
+    {
+    case VEC_BCST:
+      want = VS_VR;
+      break;
+    case VEC_SUM:
+    case VEC_RMIN:
+    case VEC_RMAX:
+    case VEC_MASK:
+      want = VS_RV;
+      break;
+    case VEC_GET:
+      want = VS_RVR;
+      break;
+    case VEC_SET:
+      want = VS_VRR;
+      break;
+    case VEC_ABS:
+    case VEC_SQRT:
+    case VEC_FLOOR:
+    case VEC_CEIL:
+    case VEC_ROUND:
+      want = VS_VV;
+      break;
+    default:
+      want = VS_VVV;
+      break;
+    }
+  if (shape != want)
+    yyerror ("Wrong operands for vector instruction");
+  /* The scalar side follows the lanes, except for the mask */
+  const bool want_fp = op == VEC_MASK ? false : vec_is_float (sa & 7);
+  if (shape != VS_VVV && shape != VS_VV && fp != want_fp)
+    yyerror ("Register type does not match the lanes");
+  if (op == VEC_DIV && !vec_is_float (sa & 7))
+    yyerror ("VDIV is only defined on float lanes");
+  if (op >= VEC_SQRT && op <= VEC_ROUND && !vec_is_float (sa & 7))
+    yyerror ("Rounding and VSQRT are only defined on float lanes");
+  return RLVM_VOP (op, sa, d, a, b);
+}
+
 void
 yyerror (char *s)
 {
@@ -876,3 +1925,163 @@ get_lbl_addr (bool pref_data, char *str)
   yyerror ("Undefined label");
   return 0;			/* Never reaches this line */
 }
+
+static uint64_t
+const_slot (uint64_t val)
+{
+  char key[17];
+  snprintf (key, sizeof (key), "%016" PRIx64, val);
+  if (pass == 0)
+    {
+      if (!has_key (&kmap, key))
+	{
+	  if (kcount == kcap)
+	    {
+	      kcap = kcap == 0 ? 16 : kcap * 2;
+	      kvals = realloc (kvals, kcap * sizeof (uint64_t));
+	    }
+	  kvals[kcount] = val;
+	  put_entry (&kmap, strdup (key), kcount++, 0);
+	}
+      return 0;
+    }
+  if (pass != 2)
+    return 0;
+  return kbase + get_val (&kmap, key);
+}
+
+uint64_t
+import_slot (char *name)
+{
+  if (pass == 0)
+    {
+      if (!has_key (&imap, name))
+	{
+	  if (nimports == (1 << 26))
+	    yyerror ("Too many native imports");
+	  const size_t len = strlen (name) + 1;
+	  inames = realloc (inames, inames_len + len);
+	  memcpy (inames + inames_len, name, len);
+	  inames_len += len;
+	  put_entry (&imap, strdup (name), nimports++, 0);
+	}
+      return 0;
+    }
+  if (pass != 2)
+    return 0;
+  return get_val (&imap, name);
+}
+
+opcode_t
+tailcall_opc (int reg, bool frame, uint64_t addr)
+{
+  if (addr > UINT16_MAX)
+    yyerror ("Tail call target is past the first 64K instructions");
+  return RLVM_TAILCALL (reg, frame, addr);
+}
+
+opcode_t
+save_opc (bool restore, uint64_t mask)
+{
+  return RLVM_SAVE (restore ? RLVM_SAVE_RESTORE : 0, const_slot (mask));
+}
+
+opcode_t
+frame_opc (int mode, int reg, uint64_t addr)
+{
+  return RLVM_FRAME (mode, reg, addr & 31, addr >> 5);
+}
+
+void
+jt_add (char *lbl)
+{
+  if (jt_len == jt_cap)
+    {
+      jt_cap = jt_cap == 0 ? 16 : jt_cap * 2;
+      jt_lbls = realloc (jt_lbls, jt_cap * sizeof (char *));
+    }
+  jt_lbls[jt_len++] = lbl;
+}
+
+/*
+ * Writes the table as 32 bit words: the number of cases, the default
+ * target (the first label) and then one target per case.
+ */
+void
+jt_emit (void)
+{
+  size_t i;
+  if (pass != 0)
+    {
+      for (i = 0; i < jt_len; ++i)
+	free (jt_lbls[i]);
+      jt_len = 0;
+      return;
+    }
+  if (jt_len - 1 > UINT32_MAX)
+    yyerror ("Too many cases in jump table");
+  fflush (ropool);
+  const uint64_t base = pool_len;
+  const uint32_t cases = jt_len - 1;
+  fwrite (&cases, sizeof (cases), 1, ropool);
+  for (i = 0; i < jt_len; ++i)
+    {
+      const uint32_t zero = 0;
+      fwrite (&zero, sizeof (zero), 1, ropool);
+      if (jt_nfix == jt_fixcap)
+	{
+	  jt_fixcap = jt_fixcap == 0 ? 16 : jt_fixcap * 2;
+	  jt_fix = realloc (jt_fix, jt_fixcap * sizeof (jt_fixup_t));
+	}
+      jt_fix[jt_nfix++] = (jt_fixup_t) {
+	.off = base + (i + 1) * sizeof (uint32_t),
+	.lbl = jt_lbls[i],
+	.unit = tunit_idx,
+	.line = line_num
+      };
+    }
+  jt_len = 0;
+}
+
+opcode_t
+mov_imm (int reg, uint64_t val)
+{
+  /* LDI takes 16 bits shifted left by up to 31 */
+  size_t sh = 0;
+  while (sh < 31 && (val >> sh) > UINT16_MAX && ((val >> sh) & 1) == 0)
+    ++sh;
+  if ((val >> sh) <= UINT16_MAX)
+    return RLVM_IRLDI (reg, sh, val >> sh);
+  return RLVM_LDK (reg, const_slot (val));
+}
+
+opcode_t
+mov_fimm (int reg, double val)
+{
+  uint64_t bits;
+  memcpy (&bits, &val, sizeof (bits));
+  return RLVM_LDKF (reg, const_slot (bits));
+}
+
+opcode_t
+hx_opc (int mode, int reg, uint64_t addr)
+{
+  const int size = 1 << (mode & 3);
+  const int64_t disp = (int64_t) addr >> 12;
+  if (disp % size != 0 || disp / size < -16 || disp / size > 15)
+    yyerror ("Displacement does not fit");
+  return RLVM_HX (mode, reg, addr & 0x1F, addr >> 5 & 0x1F, addr >> 10 & 3,
+		  disp / size);
+}
+
+opcode_t
+sm_opc (int mode, int reg, uint64_t addr)
+{
+  const int base = addr & 0x1F;
+  const int64_t step = (int64_t) addr >> 5;
+  if (step < -16 || step > 15)
+    yyerror ("Step must be -16 to 15 elements");
+  if (!(mode & (RLVM_HX_ST | RLVM_HX_FP)) && reg == base && step != 0)
+    yyerror ("Cannot load into the register being stepped");
+  return RLVM_SM (mode, reg, base, step);
+}
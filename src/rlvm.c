@@ -23,6 +23,18 @@
  */
 
 #include "rlvm.h"
+#include "parfor.h"
+#include "vector.h"
+#include "text.h"
+#include "hash.h"
+#include "bits.h"
+#include "map.h"
+#include "sort.h"
+#include "strbuf.h"
+#include "csv.h"
+#include "native.h"
+
+#include <string.h>
 
 /*
  * Using union to reinterpret_cast between a 64 bit integer and
@@ -56,7 +68,7 @@ init_rlvm (uint64_t stack_size, uint64_t handler_size, char *pool)
 					   sizeof (uint64_t)),.estack =
       handler_size == 0 ? NULL : calloc (handler_size,
 					     sizeof (ehandle_t)),.ropool =
-      pool};
+      pool,.fin = stdin,.fout = stdout,.ferr = stderr,.icount = 0};
 }
 
 void
@@ -108,6 +120,39 @@ __rotate_right (uint64_t x, size_t times)
   return x >> times | x << (64 - times);
 }
 
+/* Evaluates a compare flag of opcode 38 or 49 on rs and rt */
+static inline bool
+__compare (const rlvm_t * vm, unsigned int flag, size_t rs, size_t rt)
+{
+  if (flag & RLVM_CC_FP)
+    switch (flag & 3)
+      {
+      case RLVM_CC_EQ:
+	return vm->fregs[rs] == vm->fregs[rt];
+      case RLVM_CC_LT:
+	return vm->fregs[rs] < vm->fregs[rt];
+      case RLVM_CC_GT:
+	return vm->fregs[rs] > vm->fregs[rt];
+      default:
+	return vm->fregs[rs] == 0;
+      }
+  switch (flag & 3)
+    {
+    case RLVM_CC_EQ:
+      return vm->iregs[rs] == vm->iregs[rt];
+    case RLVM_CC_LT:
+      return (flag & RLVM_CC_SIGNED)
+	? (int64_t) vm->iregs[rs] < (int64_t) vm->iregs[rt]
+	: vm->iregs[rs] < vm->iregs[rt];
+    case RLVM_CC_GT:
+      return (flag & RLVM_CC_SIGNED)
+	? (int64_t) vm->iregs[rs] > (int64_t) vm->iregs[rt]
+	: vm->iregs[rs] > vm->iregs[rt];
+    default:
+      return vm->iregs[rs] == 0;
+    }
+}
+
 #define VM_THROW(vm, st, id, flbl)		\
   do						\
     {						\
@@ -122,9 +167,11 @@ __rotate_right (uint64_t x, size_t times)
 status_t
 exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 {
+  uint64_t icount = 0;
   while (vm->ip < len)
     {
       const opcode_t instr = ops[vm->ip];
+      ++icount;
       switch (instr.fvar.opcode)
 	{
 	  /* 6 bits means range is [0, 63] */
@@ -173,12 +220,13 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 	      switch (instr.fvar.rt)
 		{
 		case 0:	/* Float takes int's textual value */
-		  vm->fregs[instr.fvar.rd] = instr.fvar.rs;
+		  vm->fregs[instr.fvar.rd] =
+		    (int64_t) vm->iregs[instr.fvar.rs];
 		  break;
 		case 1:	/* Float takes int's bits */
 		  {
 		    union fp_i_conv_t conv = (union fp_i_conv_t) {
-		      .ival = instr.fvar.rs
+		      .ival = vm->iregs[instr.fvar.rs]
 		    };
 		    vm->fregs[instr.fvar.rd] = conv.fval;
 		    break;
@@ -213,11 +261,11 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 	      VM_THROW (vm, USER_DEFINED, vm->iregs[instr.fvar.rs], on_fault);
 	    case 8:		/* op: STK rs: r# rt: r# rd: r# sa: n */
 	      /* If sa has the thrid bit on, it means pop. Push otherwise */
-	      if ((instr.fvar.sa & 4) == 1)
+	      if (instr.fvar.sa & 4)
 		{
-		  if (vm->sp - (instr.fvar.sa & 2) == 0)
+		  if (vm->sp < (uint64_t) (instr.fvar.sa & 3) + 1)
 		    VM_THROW (vm, STACK_UFLOW, 0, on_fault);
-		  switch (instr.fvar.sa & 2)
+		  switch (instr.fvar.sa & 3)
 		    {
 		    case 2:
 		      vm->iregs[instr.fvar.rs] = vm->stack[--vm->sp];
@@ -234,9 +282,9 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 		    }
 		  break;
 		}
-	      if (vm->sp >= vm->stack_size - (instr.fvar.sa & 2))
+	      if (vm->sp + (instr.fvar.sa & 3) >= vm->stack_size)
 		VM_THROW (vm, STACK_OFLOW, 0, on_fault);
-	      switch (instr.fvar.sa & 2)
+	      switch (instr.fvar.sa & 3)
 		{
 		case 2:
 		  vm->stack[vm->sp++] = vm->iregs[instr.fvar.rd];
@@ -265,6 +313,14 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 		  break;
 		}
 	      break;
+	    case 10:		/* op: PRED rs: r# rt: mode sa: reduction */
+	      if (!red_defined (instr))
+		VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	      vm->red = instr;
+	      break;
+	    case 11:		/* op: MARK rd: r# */
+	      vm->iregs[instr.fvar.rd] = vm->sp;
+	      break;
 	    }
 	  break;
 	case 1:		/* op: @ALU rs: r# rt: r# rd: r# */
@@ -360,10 +416,61 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 	      vm->fregs[instr.fvar.rd] = fmod (vm->fregs[instr.fvar.rs],
 					       vm->fregs[instr.fvar.rt]);
 	      break;
+	    case 5:		/* rd = sqrt (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = sqrt (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 6:		/* rd = rs * rt + sa [fp] */
+	      vm->fregs[instr.fvar.rd] = fma (vm->fregs[instr.fvar.rs],
+					      vm->fregs[instr.fvar.rt],
+					      vm->fregs[instr.fvar.sa]);
+	      break;
+	    case 7:		/* rd = abs (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = fabs (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 8:		/* rd = min (rs, rt) [fp] */
+	      vm->fregs[instr.fvar.rd] = fmin (vm->fregs[instr.fvar.rs],
+					       vm->fregs[instr.fvar.rt]);
+	      break;
+	    case 9:		/* rd = max (rs, rt) [fp] */
+	      vm->fregs[instr.fvar.rd] = fmax (vm->fregs[instr.fvar.rs],
+					       vm->fregs[instr.fvar.rt]);
+	      break;
+	    case 10:		/* rd = floor (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = floor (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 11:		/* rd = ceil (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = ceil (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 12:		/* rd = round (rs), halves away from 0 [fp] */
+	      vm->fregs[instr.fvar.rd] = round (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 13:		/* rd = exp (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = exp (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 14:		/* rd = log (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = log (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 15:		/* rd = pow (rs, rt) [fp] */
+	      vm->fregs[instr.fvar.rd] = pow (vm->fregs[instr.fvar.rs],
+					      vm->fregs[instr.fvar.rt]);
+	      break;
+	    case 16:		/* rd = sin (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = sin (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 17:		/* rd = cos (rs) [fp] */
+	      vm->fregs[instr.fvar.rd] = cos (vm->fregs[instr.fvar.rs]);
+	      break;
+	    case 18:		/* rd = atan2 (rs, rt) [fp] */
+	      vm->fregs[instr.fvar.rd] = atan2 (vm->fregs[instr.fvar.rs],
+						vm->fregs[instr.fvar.rt]);
+	      break;
+	    default:
+	      VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
 	    }
 	  break;
 	case 3:		/* op: LDI rs: r# rt: << immediate: val */
-	  vm->iregs[instr.svar.rs] = instr.svar.immediate << instr.svar.rt;
+	  vm->iregs[instr.svar.rs] =
+	    (uint64_t) instr.svar.immediate << instr.svar.rt;
 	  break;
 	case 4:		/* op: ADDI rs: r# rt: r# immediate: val */
 	  vm->iregs[instr.svar.rs] =
@@ -534,7 +641,8 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 	case 28:		/* op: ALLOC rt: r# rs: r# immediate: val */
 	  if (instr.svar.immediate == 0)
 	    {
-	      vm->iregs[instr.svar.rt] = (uint64_t) malloc (instr.svar.rs);
+	      vm->iregs[instr.svar.rt] =
+		(uint64_t) malloc (vm->iregs[instr.svar.rs]);
 	    }
 	  else
 	    {
@@ -548,110 +656,76 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 	case 30:		/* op: HLDB rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint8_t *ptr = (uint8_t *) (((char *) instr.fvar.rs) + offset);
+	    uint8_t *ptr =
+	      (uint8_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    vm->iregs[instr.svar.rt] = *ptr;
 	    break;
 	  }
 	case 31:		/* op: HLDW rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint16_t *ptr = (uint16_t *) (((char *) instr.fvar.rs) + offset);
+	    uint16_t *ptr =
+	      (uint16_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    vm->iregs[instr.svar.rt] = *ptr;
 	    break;
 	  }
 	case 32:		/* op: HLDD rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint32_t *ptr = (uint32_t *) (((char *) instr.fvar.rs) + offset);
+	    uint32_t *ptr =
+	      (uint32_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    vm->iregs[instr.svar.rt] = *ptr;
 	    break;
 	  }
 	case 33:		/* op: HLDQ rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint64_t *ptr = (uint64_t *) (((char *) instr.fvar.rs) + offset);
+	    uint64_t *ptr =
+	      (uint64_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    vm->iregs[instr.svar.rt] = *ptr;
 	    break;
 	  }
 	case 34:		/* op: HSTB rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint8_t *ptr = (uint8_t *) (((char *) instr.fvar.rs) + offset);
+	    uint8_t *ptr =
+	      (uint8_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    *ptr = vm->iregs[instr.svar.rt];
 	    break;
 	  }
 	case 35:		/* op: HSTW rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint16_t *ptr = (uint16_t *) (((char *) instr.fvar.rs) + offset);
+	    uint16_t *ptr =
+	      (uint16_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    *ptr = vm->iregs[instr.svar.rt];
 	    break;
 	  }
 	case 36:		/* op: HSTD rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint32_t *ptr = (uint32_t *) (((char *) instr.fvar.rs) + offset);
+	    uint32_t *ptr =
+	      (uint32_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    *ptr = vm->iregs[instr.svar.rt];
 	    break;
 	  }
 	case 37:		/* op: HSTQ rs: base rt: r# immediate: signed offset */
 	  {
 	    const int64_t offset = __pad_sign_bit (instr.svar.immediate, 16);
-	    uint64_t *ptr = (uint64_t *) (((char *) instr.fvar.rs) + offset);
+	    uint64_t *ptr =
+	      (uint64_t *) (((char *) vm->iregs[instr.svar.rs]) + offset);
 	    *ptr = vm->iregs[instr.svar.rt];
 	    break;
 	  }
 	case 38:		/* op: SCJMP rs: r# rt: r# immediate: flag */
-	  {
-	    /*
-	     * Float point related will have the 4th bit on.
-	     * < and > have 3rd bit for unsigned int comparisons
-	     */
-	    bool rst = false;
-	    switch (instr.svar.immediate & 7)
-	      {
-	      case 0:		/* equal */
-		rst =
-		  (instr.svar.immediate & 8) ? (vm->fregs[instr.svar.rs] ==
-						vm->fregs[instr.svar.rt])
-		  : (vm->iregs[instr.svar.rs] == vm->iregs[instr.svar.rt]);
-		break;
-	      case 1:		/* lesser than */
-		if (instr.svar.immediate & 8)
-		  rst = vm->fregs[instr.svar.rs] < vm->fregs[instr.svar.rt];
-		else if (instr.svar.immediate & 4)
-		  rst =
-		    ((int64_t) vm->iregs[instr.svar.rs]) <
-		    ((int64_t) vm->iregs[instr.svar.rt]);
-		else
-		  rst = vm->iregs[instr.svar.rs] < vm->iregs[instr.svar.rt];
-		break;
-	      case 2:		/* greater than */
-		if (instr.svar.immediate & 8)
-		  rst = vm->fregs[instr.svar.rs] > vm->fregs[instr.svar.rt];
-		else if (instr.svar.immediate & 4)
-		  rst =
-		    ((int64_t) vm->iregs[instr.svar.rs]) >
-		    ((int64_t) vm->iregs[instr.svar.rt]);
-		else
-		  rst = vm->iregs[instr.svar.rs] > vm->iregs[instr.svar.rt];
-		break;
-	      case 3:		/* zero */
-		rst =
-		  (instr.svar.immediate & 8) ? (vm->fregs[instr.svar.rs] ==
-						0) : (vm->iregs[instr.
-								svar.rs] ==
-						      0);
-		break;
-	      }
-	    /*
-	     * If rst is true, the next line is executed.
-	     * The next line is skipped otherwise.
-	     */
-	    if (!rst)
-	      vm->ip += 1;
-	    break;
-	  }
+	  /*
+	   * If the compare holds, the next line is executed.
+	   * The next line is skipped otherwise.
+	   */
+	  if (!__compare (vm, instr.svar.immediate, instr.svar.rs,
+			  instr.svar.rt))
+	    vm->ip += 1;
+	  break;
 	case 39:		/* op: LDPO rs: base rt: r# imm: signed offset */
 	  vm->iregs[instr.svar.rt] =
 	    (uint64_t) (vm->ropool + vm->iregs[instr.svar.rs] +
@@ -699,13 +773,13 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 			 (char *) vm->iregs[instr.fvar.rt]);
 	      break;
 	    case 7:		/* Gives rd stdout */
-	      vm->iregs[instr.fvar.rd] = (uint64_t) stdout;
+	      vm->iregs[instr.fvar.rd] = (uint64_t) vm->fout;
 	      break;
 	    case 8:		/* Gives rd stderr */
-	      vm->iregs[instr.fvar.rd] = (uint64_t) stderr;
+	      vm->iregs[instr.fvar.rd] = (uint64_t) vm->ferr;
 	      break;
 	    case 9:		/* Gives rd stdin */
-	      vm->iregs[instr.fvar.rd] = (uint64_t) stdin;
+	      vm->iregs[instr.fvar.rd] = (uint64_t) vm->fin;
 	      break;
 	    case 10:		/* Open file (rt points to string specifying mode) */
 	      vm->iregs[instr.fvar.rd] =
@@ -725,6 +799,548 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
 	      break;
 	    }
 	  break;
+	case 42:		/* op: PARFOR rs: r# rt: r# immediate: val */
+	  {
+	    const status_t st = exec_parfor (vm, len, ops, instr);
+	    if (st.state != CLEAN)
+	      VM_THROW (vm, st.state, st.uid, on_fault);
+	    break;
+	  }
+	case 43:		/* op: VEC rs: v# rt: v# rd: v# sa: type fn: op */
+	  if (!exec_vector (vm, instr))
+	    VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	  break;
+	case 44:		/* op: MEM rs: r# rt: r# rd: r# sa: r# fn: mode */
+	  switch (instr.fvar.fn)
+	    {
+	    case 0:		/* memcpy (rd, rs, rt) */
+	      memcpy ((void *) vm->iregs[instr.fvar.rd],
+		      (const void *) vm->iregs[instr.fvar.rs],
+		      vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 1:		/* memmove (rd, rs, rt) */
+	      memmove ((void *) vm->iregs[instr.fvar.rd],
+		       (const void *) vm->iregs[instr.fvar.rs],
+		       vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 2:		/* memset (rd, rs, rt) */
+	      memset ((void *) vm->iregs[instr.fvar.rd],
+		      (int) (vm->iregs[instr.fvar.rs] & 0xFF),
+		      vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 3:		/* rd = sign of memcmp (rs, rt, sa) */
+	      {
+		const int cmp = memcmp ((const void *) vm->iregs[instr.fvar.rs],
+					(const void *) vm->iregs[instr.fvar.rt],
+					vm->iregs[instr.fvar.sa]);
+		vm->iregs[instr.fvar.rd] = (cmp > 0) - (cmp < 0);
+		break;
+	      }
+	    case 4:		/* rd = strlen (rs) */
+	      vm->iregs[instr.fvar.rd] =
+		strlen ((const char *) vm->iregs[instr.fvar.rs]);
+	      break;
+	    case 5:		/* rd = memchr (rs, rt, sa) or 0 */
+	      vm->iregs[instr.fvar.rd] = (uint64_t)
+		memchr ((const void *) vm->iregs[instr.fvar.rs],
+			(int) (vm->iregs[instr.fvar.rt] & 0xFF),
+			vm->iregs[instr.fvar.sa]);
+	      break;
+	    case 6:		/* rd = memrchr (rs, rt, sa) or 0 */
+	      vm->iregs[instr.fvar.rd] = (uint64_t)
+		text_memrchr ((const void *) vm->iregs[instr.fvar.rs],
+			      (int) (vm->iregs[instr.fvar.rt] & 0xFF),
+			      vm->iregs[instr.fvar.sa]);
+	      break;
+	    case 7:		/* rd = sign of strcmp (rs, rt) */
+	      {
+		const int cmp = strcmp ((const char *) vm->iregs[instr.fvar.rs],
+					(const char *) vm->iregs[instr.fvar.rt]);
+		vm->iregs[instr.fvar.rd] = (cmp > 0) - (cmp < 0);
+		break;
+	      }
+	    case 8:		/* rd = strstr (rs, rt) or 0 */
+	      vm->iregs[instr.fvar.rd] = (uint64_t)
+		strstr ((const char *) vm->iregs[instr.fvar.rs],
+			(const char *) vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 9:		/* rd = memmem (rs, rt, sa, rd) or 0 */
+	      vm->iregs[instr.fvar.rd] = (uint64_t)
+		text_memmem ((const void *) vm->iregs[instr.fvar.rs],
+			     vm->iregs[instr.fvar.rt],
+			     (const void *) vm->iregs[instr.fvar.sa],
+			     vm->iregs[instr.fvar.rd]);
+	      break;
+	    case 10:		/* rd = valid UTF-8 prefix length of (rs, rt) */
+	      vm->iregs[instr.fvar.rd] =
+		text_utf8_valid ((const uint8_t *) vm->iregs[instr.fvar.rs],
+				 vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 11:		/* rd = crc32c of (rs, rt) continuing rd */
+	      vm->iregs[instr.fvar.rd] =
+		hash_crc32c (vm->iregs[instr.fvar.rd],
+			     (const void *) vm->iregs[instr.fvar.rs],
+			     vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 12:		/* rd = xxh64 of (rs, rt) seeded with sa */
+	      vm->iregs[instr.fvar.rd] =
+		hash_xxh64 ((const void *) vm->iregs[instr.fvar.rs],
+			    vm->iregs[instr.fvar.rt],
+			    vm->iregs[instr.fvar.sa]);
+	      break;
+	    case 13:		/* starts hash state rs seeded with rt */
+	      hash_init ((hash_state_t *) vm->iregs[instr.fvar.rs],
+			 vm->iregs[instr.fvar.rt]);
+	      break;
+	    case 14:		/* feeds (rt, sa) to hash state rs */
+	      hash_update ((hash_state_t *) vm->iregs[instr.fvar.rs],
+			   (const void *) vm->iregs[instr.fvar.rt],
+			   vm->iregs[instr.fvar.sa]);
+	      break;
+	    case 15:		/* rd = digest of hash state rs */
+	      vm->iregs[instr.fvar.rd] =
+		hash_digest ((const hash_state_t *) vm->iregs[instr.fvar.rs]);
+	      break;
+	    case 16:		/* rd = fields of (rs, rs + 1) into (rt, rt + 1) */
+	      vm->iregs[instr.fvar.rd] =
+		csv_scan ((const char *) vm->iregs[instr.fvar.rs],
+			  vm->iregs[(instr.fvar.rs + 1) & 31],
+			  vm->iregs[instr.fvar.sa],
+			  (csv_field_t *) vm->iregs[instr.fvar.rt],
+			  vm->iregs[(instr.fvar.rt + 1) & 31],
+			  &vm->iregs[(instr.fvar.rd + 1) & 31]);
+	      break;
+	    case 17:		/* rd = int at (rs, rt), sa = whether it is one */
+	      {
+		int64_t v = 0;
+		vm->iregs[instr.fvar.sa] =
+		  csv_parse_i64 ((const char *) vm->iregs[instr.fvar.rs],
+				 vm->iregs[instr.fvar.rt], &v);
+		vm->iregs[instr.fvar.rd] = v;
+		break;
+	      }
+	    case 18:		/* fd = double at (rs, rt), sa = whether it is one */
+	      {
+		double v = 0;
+		vm->iregs[instr.fvar.sa] =
+		  csv_parse_f64 ((const char *) vm->iregs[instr.fvar.rs],
+				 vm->iregs[instr.fvar.rt], &v);
+		vm->fregs[instr.fvar.rd] = v;
+		break;
+	      }
+	    default:
+	      VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	    }
+	  break;
+	case 45:		/* op: LDK rs: r# rt: fp | slot high imm: slot */
+	  {
+	    const char *k = vm->ropool + RLVM_LDK_SLOT (instr) * sizeof (uint64_t);
+	    if (instr.svar.rt & RLVM_LDK_FP)
+	      memcpy (&vm->fregs[instr.svar.rs], k, sizeof (double));
+	    else
+	      memcpy (&vm->iregs[instr.svar.rs], k, sizeof (uint64_t));
+	    break;
+	  }
+	case 46:		/* op: HX rs: base rt: index rd: r# sa: disp fn: mode */
+	  {
+	    const unsigned size = instr.fvar.fn & 3;
+	    char *ptr = (char *) (vm->iregs[instr.fvar.rs] +
+				  (vm->iregs[instr.fvar.rt] <<
+				   (instr.fvar.fn >> 2 & 3)) +
+				  (__pad_sign_bit (instr.fvar.sa, 5) << size));
+	    switch (instr.fvar.fn & ~0xC)
+	      {
+	      case 0:
+		vm->iregs[instr.fvar.rd] = *(uint8_t *) ptr;
+		break;
+	      case 1:
+		vm->iregs[instr.fvar.rd] = *(uint16_t *) ptr;
+		break;
+	      case 2:
+		vm->iregs[instr.fvar.rd] = *(uint32_t *) ptr;
+		break;
+	      case 3:
+		vm->iregs[instr.fvar.rd] = *(uint64_t *) ptr;
+		break;
+	      case RLVM_HX_FP | 2:
+		vm->fregs[instr.fvar.rd] = *(float *) ptr;
+		break;
+	      case RLVM_HX_FP | 3:
+		vm->fregs[instr.fvar.rd] = *(double *) ptr;
+		break;
+	      case RLVM_HX_ST | 0:
+		*(uint8_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_HX_ST | 1:
+		*(uint16_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_HX_ST | 2:
+		*(uint32_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_HX_ST | 3:
+		*(uint64_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_HX_ST | RLVM_HX_FP | 2:
+		*(float *) ptr = vm->fregs[instr.fvar.rd];
+		break;
+	      case RLVM_HX_ST | RLVM_HX_FP | 3:
+		*(double *) ptr = vm->fregs[instr.fvar.rd];
+		break;
+	      default:
+		VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	      }
+	    break;
+	  }
+	case 47:		/* op: STREAM rs: base rd: r# sa: step fn: mode */
+	  {
+	    char *ptr = (char *) vm->iregs[instr.fvar.rs];
+	    switch (instr.fvar.fn)
+	      {
+	      case RLVM_SM_POST | 0:
+		vm->iregs[instr.fvar.rd] = *(uint8_t *) ptr;
+		break;
+	      case RLVM_SM_POST | 1:
+		vm->iregs[instr.fvar.rd] = *(uint16_t *) ptr;
+		break;
+	      case RLVM_SM_POST | 2:
+		vm->iregs[instr.fvar.rd] = *(uint32_t *) ptr;
+		break;
+	      case RLVM_SM_POST | 3:
+		vm->iregs[instr.fvar.rd] = *(uint64_t *) ptr;
+		break;
+	      case RLVM_SM_POST | RLVM_HX_FP | 2:
+		vm->fregs[instr.fvar.rd] = *(float *) ptr;
+		break;
+	      case RLVM_SM_POST | RLVM_HX_FP | 3:
+		vm->fregs[instr.fvar.rd] = *(double *) ptr;
+		break;
+	      case RLVM_SM_POST | RLVM_HX_ST | 0:
+		*(uint8_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_SM_POST | RLVM_HX_ST | 1:
+		*(uint16_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_SM_POST | RLVM_HX_ST | 2:
+		*(uint32_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_SM_POST | RLVM_HX_ST | 3:
+		*(uint64_t *) ptr = vm->iregs[instr.fvar.rd];
+		break;
+	      case RLVM_SM_POST | RLVM_HX_ST | RLVM_HX_FP | 2:
+		*(float *) ptr = vm->fregs[instr.fvar.rd];
+		break;
+	      case RLVM_SM_POST | RLVM_HX_ST | RLVM_HX_FP | 3:
+		*(double *) ptr = vm->fregs[instr.fvar.rd];
+		break;
+	      default:
+		VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	      }
+	    /* Every access steps the base by sa elements */
+	    vm->iregs[instr.fvar.rs] +=
+	      __pad_sign_bit (instr.fvar.sa, 5) << (instr.fvar.fn & 3);
+	    break;
+	  }
+	case 48:		/* op: DBNZ rs: r# immediate: val */
+	  if (--vm->iregs[instr.svar.rs] != 0)
+	    {
+	      vm->ip = instr.svar.immediate;
+	      continue;
+	    }
+	  break;
+	case 49:		/* op: SETcc/CMOVcc/SELECT fn: kind | flag */
+	  {
+	    const unsigned int flag = instr.fvar.fn & 0xF;
+	    const size_t rd = instr.fvar.rd;
+	    const size_t sa = instr.fvar.sa;
+	    switch (instr.fvar.fn & 0x30)
+	      {
+	      case RLVM_CC_SET:
+		vm->iregs[rd] =
+		  __compare (vm, flag, instr.fvar.rs, instr.fvar.rt);
+		break;
+	      case RLVM_CC_MOV:
+		vm->iregs[rd] =
+		  __compare (vm, flag, instr.fvar.rs, instr.fvar.rt)
+		  ? vm->iregs[sa] : vm->iregs[rd];
+		break;
+	      case RLVM_CC_MOVF:
+		vm->fregs[rd] =
+		  __compare (vm, flag, instr.fvar.rs, instr.fvar.rt)
+		  ? vm->fregs[sa] : vm->fregs[rd];
+		break;
+	      case RLVM_CC_SELECT:
+		if (flag & RLVM_CC_FP)
+		  vm->fregs[rd] = vm->iregs[sa]
+		    ? vm->fregs[instr.fvar.rs] : vm->fregs[instr.fvar.rt];
+		else
+		  vm->iregs[rd] = vm->iregs[sa]
+		    ? vm->iregs[instr.fvar.rs] : vm->iregs[instr.fvar.rt];
+		break;
+	      }
+	    break;
+	  }
+	case 50:		/* op: BIT rs: r# rt: r# rd: r# fn: op */
+	  {
+	    const uint64_t a = vm->iregs[instr.fvar.rs];
+	    const uint64_t b = vm->iregs[instr.fvar.rt];
+	    uint64_t *rd = &vm->iregs[instr.fvar.rd];
+	    switch (instr.fvar.fn)
+	      {
+	      case RLVM_BIT_POPCNT:
+		*rd = bits_popcount (a);
+		break;
+	      case RLVM_BIT_CLZ:
+		*rd = bits_clz (a);
+		break;
+	      case RLVM_BIT_CTZ:
+		*rd = bits_ctz (a);
+		break;
+	      case RLVM_BIT_BSWAP:
+		*rd = bits_bswap (a);
+		break;
+	      case RLVM_BIT_PEXT:
+		*rd = bits_pext (a, b);
+		break;
+	      case RLVM_BIT_PDEP:
+		*rd = bits_pdep (a, b);
+		break;
+	      case RLVM_BIT_MULHU:
+		*rd = bits_mulhu (a, b);
+		break;
+	      case RLVM_BIT_MULHS:
+		*rd = bits_mulhs (a, b);
+		break;
+	      default:
+		VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	      }
+	    break;
+	  }
+	case 51:		/* op: SWITCH rs: r# immediate: table */
+	  {
+	    /* Table is the case count, the default and one target each */
+	    const char *tbl = vm->ropool + instr.svar.immediate;
+	    const uint64_t idx = vm->iregs[instr.svar.rs];
+	    uint32_t cases, dst;
+	    memcpy (&cases, tbl, sizeof (cases));
+	    memcpy (&dst, tbl + sizeof (uint32_t) *
+		    (idx < cases ? idx + 2 : 1), sizeof (dst));
+	    vm->ip = dst;
+	    continue;
+	  }
+	case 52:		/* op: TAILCALL rs: mark rt: mode immediate: val */
+	  /* The return address of the current frame is left on top */
+	  if (instr.svar.rt & 1)
+	    {
+	      if (vm->iregs[instr.svar.rs] > vm->sp)
+		VM_THROW (vm, STACK_OFLOW, 0, on_fault);
+	      vm->sp = vm->iregs[instr.svar.rs];
+	    }
+	  vm->ip = instr.svar.immediate;
+	  continue;
+	case 53:		/* op: SAVE rs: mode rt: slot high imm: slot */
+	  {
+	    uint64_t mask;
+	    memcpy (&mask, vm->ropool + RLVM_LDK_SLOT (instr) *
+		    sizeof (uint64_t), sizeof (mask));
+	    const uint64_t n = bits_popcount (mask);
+	    uint64_t *top;
+	    if (instr.svar.rs & RLVM_SAVE_RESTORE)
+	      {
+		if (vm->sp < n)
+		  VM_THROW (vm, STACK_UFLOW, 0, on_fault);
+		vm->sp -= n;
+		for (top = vm->stack + vm->sp; mask != 0; mask &= mask - 1)
+		  {
+		    const uint64_t r = bits_ctz (mask);
+		    if (r < 32)
+		      vm->iregs[r] = *top++;
+		    else
+		      memcpy (&vm->fregs[r - 32], top++, sizeof (double));
+		  }
+	      }
+	    else
+	      {
+		if (vm->sp + n > vm->stack_size)
+		  VM_THROW (vm, STACK_OFLOW, 0, on_fault);
+		for (top = vm->stack + vm->sp; mask != 0; mask &= mask - 1)
+		  {
+		    const uint64_t r = bits_ctz (mask);
+		    if (r < 32)
+		      *top++ = vm->iregs[r];
+		    else
+		      memcpy (top++, &vm->fregs[r - 32], sizeof (double));
+		  }
+		vm->sp += n;
+	      }
+	    break;
+	  }
+	case 54:		/* op: FRAME rs: base rt: r# immediate: mode | offset */
+	  {
+	    const uint64_t idx = vm->iregs[instr.svar.rs] +
+	      __pad_sign_bit (instr.svar.immediate, 14);
+	    if (idx >= vm->stack_size)
+	      VM_THROW (vm, STACK_OFLOW, 0, on_fault);
+	    uint64_t *slot = vm->stack + idx;
+	    switch (instr.svar.immediate >> 14)
+	      {
+	      case RLVM_FRAME_LD:
+		vm->iregs[instr.svar.rt] = *slot;
+		break;
+	      case RLVM_FRAME_LDF:
+		memcpy (&vm->fregs[instr.svar.rt], slot, sizeof (double));
+		break;
+	      case RLVM_FRAME_ST:
+		*slot = vm->iregs[instr.svar.rt];
+		break;
+	      case RLVM_FRAME_STF:
+		memcpy (slot, &vm->fregs[instr.svar.rt], sizeof (double));
+		break;
+	      }
+	    break;
+	  }
+	case 55:		/* op: MAP rs: map rt: key rd: r# sa: r# fn: op */
+	  {
+	    map_t *map = (map_t *) vm->iregs[instr.fvar.rs];
+	    uint64_t key = 0;
+	    uint64_t len = 0;
+	    if ((instr.fvar.fn >= RLVM_MAP_GET && instr.fvar.fn <= RLVM_MAP_DEL)
+		|| instr.fvar.fn == RLVM_MAP_ADD)
+	      {
+		/* Byte string keys take the length from the next register */
+		key = vm->iregs[instr.fvar.rt];
+		if (map->bytes)
+		  len = vm->iregs[(instr.fvar.rt + 1) & 31];
+	      }
+	    switch (instr.fvar.fn)
+	      {
+	      case RLVM_MAP_NEW:
+		vm->iregs[instr.fvar.rd] = (uint64_t) map_new (instr.fvar.sa & 1);
+		break;
+	      case RLVM_MAP_FREE:
+		map_free (map);
+		break;
+	      case RLVM_MAP_GET:
+		{
+		  const map_slot_t *slot = map_find (map, key, len);
+		  vm->iregs[instr.fvar.rd] = slot == NULL ? 0 : slot->val;
+		  vm->iregs[instr.fvar.sa] = slot != NULL;
+		  break;
+		}
+	      case RLVM_MAP_PUT:
+		if (!map_put (map, key, len, vm->iregs[instr.fvar.rd]))
+		  VM_THROW (vm, OUT_OF_MEM, 0, on_fault);
+		break;
+	      case RLVM_MAP_DEL:
+		vm->iregs[instr.fvar.rd] = map_del (map, key, len);
+		break;
+	      case RLVM_MAP_LEN:
+		vm->iregs[instr.fvar.rd] = map->size;
+		break;
+	      case RLVM_MAP_NEXT:
+		{
+		  uint64_t cursor = vm->iregs[instr.fvar.rd];
+		  const map_slot_t *slot = map_next (map, &cursor);
+		  if (slot == NULL)
+		    {
+		      vm->iregs[instr.fvar.rd] = 0;
+		      break;
+		    }
+		  vm->iregs[instr.fvar.rd] = cursor;
+		  vm->iregs[instr.fvar.rt] = slot->key;
+		  if (map->bytes)
+		    vm->iregs[(instr.fvar.rt + 1) & 31] = map_key_len (map, slot);
+		  vm->iregs[instr.fvar.sa] = slot->val;
+		  break;
+		}
+	      case RLVM_MAP_ADD:
+		if (!map_add (map, key, len, vm->iregs[instr.fvar.sa],
+			      &vm->iregs[instr.fvar.rd]))
+		  VM_THROW (vm, OUT_OF_MEM, 0, on_fault);
+		break;
+	      default:
+		VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	      }
+	    break;
+	  }
+	case 56:		/* op: SORT rs: r# rt: r# rd: r# sa: r# fn: flags */
+	  {
+	    uint64_t *keys = (uint64_t *) vm->iregs[instr.fvar.rs];
+	    const uint64_t n = vm->iregs[instr.fvar.rt];
+	    const sort_kind_t kind = instr.fvar.fn & RLVM_SORT_KIND;
+	    const bool desc = instr.fvar.fn & RLVM_SORT_DESC;
+	    if (kind > SORT_FLOAT)
+	      VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	    if (instr.fvar.fn & RLVM_SORT_LBOUND)
+	      {
+		uint64_t key = vm->iregs[instr.fvar.sa];
+		if (kind == SORT_FLOAT)
+		  memcpy (&key, &vm->fregs[instr.fvar.sa], sizeof (double));
+		vm->iregs[instr.fvar.rd] =
+		  sort_lower_bound (keys, n, key, kind, desc);
+		break;
+	      }
+	    uint64_t *vals = instr.fvar.fn & RLVM_SORT_PAIRS
+	      ? (uint64_t *) vm->iregs[instr.fvar.rd] : NULL;
+	    if (!sort_words (keys, vals, n, kind, desc))
+	      VM_THROW (vm, OUT_OF_MEM, 0, on_fault);
+	    break;
+	  }
+	case 57:		/* op: SB rs: buf rt: r# rd: r# fn: op */
+	  {
+	    strbuf_t *sb = (strbuf_t *) vm->iregs[instr.fvar.rs];
+	    const uint64_t val = vm->iregs[instr.fvar.rt];
+	    bool ok = true;
+	    switch (instr.fvar.fn)
+	      {
+	      case RLVM_SB_NEW:
+		vm->iregs[instr.fvar.rd] = (uint64_t) strbuf_new ();
+		break;
+	      case RLVM_SB_FREE:
+		strbuf_free (sb);
+		break;
+	      case RLVM_SB_CHR:
+		ok = strbuf_putc (sb, val);
+		break;
+	      case RLVM_SB_STR:
+		ok = strbuf_puts (sb, (const char *) val);
+		break;
+	      case RLVM_SB_INT:
+		ok = strbuf_put_i64 (sb, val);
+		break;
+	      case RLVM_SB_UINT:
+		ok = strbuf_put_u64 (sb, val);
+		break;
+	      case RLVM_SB_HEX:
+		ok = strbuf_put_hex (sb, val);
+		break;
+	      case RLVM_SB_FLT:
+		ok = strbuf_put_f64 (sb, vm->fregs[instr.fvar.rt]);
+		break;
+	      case RLVM_SB_FLUSH:
+		vm->iregs[instr.fvar.rd] = strbuf_flush (sb, (FILE *) val);
+		break;
+	      case RLVM_SB_LEN:
+		vm->iregs[instr.fvar.rd] = sb->len;
+		break;
+	      default:
+		VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	      }
+	    if (!ok)
+	      VM_THROW (vm, OUT_OF_MEM, 0, on_fault);
+	    break;
+	  }
+	case 58:		/* op: NCALL target: slot */
+	  {
+	    if (instr.tvar.target >= vm->native_count)
+	      VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	    const native_t *nat = &vm->natives[instr.tvar.target];
+	    if (nat->fn == NULL)
+	      VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
+	    const status_t st = nat->fn (vm, nat->data);
+	    if (st.state != CLEAN)
+	      VM_THROW (vm, st.state, st.uid, on_fault);
+	    break;
+	  }
 	default:
 	  VM_THROW (vm, BAD_OPCODE, instr.bytes, on_fault);
 	}
@@ -747,5 +1363,6 @@ exec_bytecode (rlvm_t * vm, const uint64_t len, opcode_t * ops)
       while (vm->sp != handle.old_sp)
 	vm->sp -= 1;
     }
+  vm->icount += icount;
   return vm->state;
 }
@@ -0,0 +1,364 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "runner.h"
+#include "lblmap.h"
+
+#include <time.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct manifest_t
+{
+  job_t *jobs;
+  size_t njobs;
+  bcode_t *images;
+  size_t nimages;
+  size_t next;			/* Next job to hand out (atomic) */
+} manifest_t;
+
+const char *
+state_name (status_t state)
+{
+  static const char *const names[] = {
+    "CLEAN", "DIV_BY_ZERO", "STACK_OFLOW", "STACK_UFLOW", "OUT_OF_MEM",
+    "BAD_OPCODE", "USER_DEFINED"
+  };
+  if ((size_t) state.state < sizeof (names) / sizeof (names[0]))
+    return names[state.state];
+  return "UNKNOWN";
+}
+
+static char *
+dup_str (const char *str)
+{
+  if (str == NULL)
+    return NULL;
+  size_t len = strlen (str) + 1;
+  char *cpy = malloc (len);
+  memcpy (cpy, str, len);
+  return cpy;
+}
+
+/*
+ * Fills in $man->jobs from the manifest. Returns false on a
+ * malformed line (more than three fields).
+ */
+static bool
+parse_manifest (FILE * f, manifest_t * man)
+{
+  size_t cap = 16;
+  size_t lineno = 0;
+  char *line = NULL;
+  size_t linecap = 0;
+  man->jobs = malloc (cap * sizeof (job_t));
+  man->njobs = 0;
+  while (getline (&line, &linecap, f) != -1)
+    {
+      ++lineno;
+      char *save = NULL;
+      char *fields[4] = { NULL };
+      size_t n = 0;
+      char *tok;
+      for (tok = strtok_r (line, " \t\r\n", &save);
+	   tok != NULL && n < 4; tok = strtok_r (NULL, " \t\r\n", &save))
+	fields[n++] = tok;
+      if (n == 0 || fields[0][0] == '#')
+	continue;
+      if (n > 3)
+	{
+	  fprintf (stderr, "error: manifest line %zu has too many fields\n",
+		   lineno);
+	  free (line);
+	  return false;
+	}
+      if (man->njobs == cap)
+	man->jobs = realloc (man->jobs, (cap *= 2) * sizeof (job_t));
+      man->jobs[man->njobs++] = (job_t)
+      {
+      .prog = dup_str (fields[0]),.input = dup_str (fields[1]),.output =
+	  dup_str (fields[2]),.image = 0,.ran = false,.state = (status_t)
+	{
+	.state = CLEAN,.uid = 0}
+	,.icount = 0,.wall = 0};
+    }
+  free (line);
+  return true;
+}
+
+/*
+ * Reads every distinct program once. Jobs naming the same file share
+ * one image (the code and the read-only pool are never written by
+ * the interpreter).
+ */
+static bool
+load_images (manifest_t * man)
+{
+  lblmap_t seen = init_map (64);
+  size_t cap = 4;
+  man->images = malloc (cap * sizeof (bcode_t));
+  man->nimages = 0;
+  size_t i;
+  for (i = 0; i < man->njobs; ++i)
+    {
+      job_t *job = &man->jobs[i];
+      if (has_key (&seen, job->prog))
+	{
+	  job->image = get_val (&seen, job->prog);
+	  continue;
+	}
+      FILE *f = fopen (job->prog, "rb");
+      if (f == NULL)
+	{
+	  fprintf (stderr, "error: failed to read file %s\n", job->prog);
+	  free_map (&seen);
+	  return false;
+	}
+      if (man->nimages == cap)
+	man->images = realloc (man->images, (cap *= 2) * sizeof (bcode_t));
+      if (read_bytecode (f, &man->images[man->nimages]) == NULL)
+	{
+	  fprintf (stderr,
+		   "error: failed interpreting bytecode from %s\n",
+		   job->prog);
+	  fclose (f);
+	  free_map (&seen);
+	  return false;
+	}
+      fclose (f);
+      job->image = man->nimages;
+      put_entry (&seen, dup_str (job->prog), man->nimages++, 0);
+    }
+  free_map (&seen);
+  return true;
+}
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+run_job (manifest_t * man, job_t * job)
+{
+  FILE *in = stdin;
+  FILE *out = stdout;
+  if (job->input != NULL && (in = fopen (job->input, "r")) == NULL)
+    {
+      fprintf (stderr, "error: failed to read file %s\n", job->input);
+      return;
+    }
+  if (job->output != NULL && (out = fopen (job->output, "w")) == NULL)
+    {
+      fprintf (stderr, "error: failed to open file %s\n", job->output);
+      if (in != stdin)
+	fclose (in);
+      return;
+    }
+
+  bcode_t *code = &man->images[job->image];
+  rlvm_t vm = init_rlvm (code->cstack_size, code->estack_size, code->ropool);
+  vm.fin = in;
+  vm.fout = out;
+  vm.natives = code->natives;
+  vm.native_count = code->native_count;
+
+  const double start = now ();
+  job->state = exec_bytecode (&vm, code->code_size, code->code);
+  job->wall = now () - start;
+  job->icount = vm.icount;
+  job->ran = true;
+
+  clean_rlvm (&vm);
+  if (in != stdin)
+    fclose (in);
+  if (out != stdout)
+    fclose (out);
+  else
+    fflush (out);
+}
+
+static void *
+runner_main (void *arg)
+{
+  manifest_t *man = arg;
+  size_t i;
+  while ((i = __sync_fetch_and_add (&man->next, 1)) < man->njobs)
+    run_job (man, &man->jobs[i]);
+  return NULL;
+}
+
+static void
+json_str (FILE * f, const char *str)
+{
+  if (str == NULL)
+    {
+      fputs ("null", f);
+      return;
+    }
+  fputc ('"', f);
+  for (; *str != '\0'; ++str)
+    {
+      const unsigned char ch = *str;
+      if (ch == '"' || ch == '\\')
+	fprintf (f, "\\%c", ch);
+      else if (ch < 0x20)
+	fprintf (f, "\\u%04x", ch);
+      else
+	fputc (ch, f);
+    }
+  fputc ('"', f);
+}
+
+static void
+csv_str (FILE * f, const char *str)
+{
+  if (str == NULL)
+    return;
+  if (strpbrk (str, ",\"\n") == NULL)
+    {
+      fputs (str, f);
+      return;
+    }
+  fputc ('"', f);
+  for (; *str != '\0'; ++str)
+    {
+      if (*str == '"')
+	fputc ('"', f);
+      fputc (*str, f);
+    }
+  fputc ('"', f);
+}
+
+void
+begin_summary (FILE * f, summary_fmt_t fmt)
+{
+  if (fmt == SUMMARY_JSON)
+    fputs ("[\n", f);
+  else
+    fputs ("job,program,input,state,uid,seconds,instructions\n", f);
+}
+
+void
+end_summary (FILE * f, summary_fmt_t fmt)
+{
+  if (fmt == SUMMARY_JSON)
+    fputs ("\n]\n", f);
+  fflush (f);
+}
+
+/* Rows are numbered on from *nrows, the rows of earlier manifests */
+static void
+write_summary (manifest_t * man, FILE * f, summary_fmt_t fmt, size_t * nrows)
+{
+  size_t i;
+  for (i = 0; i < man->njobs; ++i, ++*nrows)
+    {
+      job_t *job = &man->jobs[i];
+      const char *state = job->ran ? state_name (job->state) : "NOT_RUN";
+      if (fmt == SUMMARY_JSON)
+	{
+	  fprintf (f, "%s  {\"job\": %zu, \"program\": ",
+		   *nrows != 0 ? ",\n" : "", *nrows);
+	  json_str (f, job->prog);
+	  fputs (", \"input\": ", f);
+	  json_str (f, job->input);
+	  fprintf (f, ", \"state\": \"%s\", \"uid\": %" PRIu64
+		   ", \"seconds\": %.6f, \"instructions\": %" PRIu64 "}",
+		   state, (uint64_t) job->state.uid, job->wall, job->icount);
+	}
+      else
+	{
+	  fprintf (f, "%zu,", *nrows);
+	  csv_str (f, job->prog);
+	  fputc (',', f);
+	  csv_str (f, job->input);
+	  fprintf (f, ",%s,%" PRIu64 ",%.6f,%" PRIu64 "\n", state,
+		   (uint64_t) job->state.uid, job->wall, job->icount);
+	}
+    }
+  fflush (f);
+}
+
+static void
+free_manifest (manifest_t * man)
+{
+  size_t i;
+  for (i = 0; i < man->nimages; ++i)
+    clean_bcode (&man->images[i]);
+  for (i = 0; i < man->njobs; ++i)
+    {
+      free (man->jobs[i].prog);
+      free (man->jobs[i].input);
+      free (man->jobs[i].output);
+    }
+  free (man->images);
+  free (man->jobs);
+}
+
+int
+run_manifest (FILE * manifest, size_t nthreads, FILE * summary,
+	      summary_fmt_t fmt, size_t * nrows)
+{
+  manifest_t man = {
+  .jobs = NULL,.njobs = 0,.images = NULL,.nimages = 0,.next = 0};
+  if (!parse_manifest (manifest, &man))
+    {
+      free_manifest (&man);
+      return 2;
+    }
+  if (!load_images (&man))
+    {
+      free_manifest (&man);
+      return 3;
+    }
+
+  if (nthreads == 0)
+    nthreads = 1;
+  if (nthreads > man.njobs)
+    nthreads = man.njobs == 0 ? 1 : man.njobs;
+
+  /* The calling thread takes jobs too */
+  pthread_t threads[nthreads];
+  size_t i;
+  size_t spawned = 0;
+  for (i = 1; i < nthreads; ++i)
+    if (pthread_create (&threads[spawned], NULL, runner_main, &man) == 0)
+      ++spawned;
+  runner_main (&man);
+  for (i = 0; i < spawned; ++i)
+    pthread_join (threads[i], NULL);
+
+  write_summary (&man, summary, fmt, nrows);
+
+  int ret = 0;
+  for (i = 0; i < man.njobs; ++i)
+    if (!man.jobs[i].ran || man.jobs[i].state.state != CLEAN)
+      ret = 4;
+  free_manifest (&man);
+  return ret;
+}
@@ -0,0 +1,897 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "serve.h"
+#include "bcode.h"
+#include "hash.h"
+#include "lblmap.h"
+
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/* Programs past this count run uncached */
+#define CACHE_MAX 256
+
+/* Number of most recent request latencies kept for percentiles */
+#define LATENCY_WINDOW 4096
+
+/* Maximum number of connections with a request waiting for a worker */
+#define QUEUE_MAX 1024
+
+/* Time a client gets to send a whole request or to take a reply */
+#define IO_TIMEOUT_NS (5 * 1000000000ULL)
+
+/* Wall-clock limit of a run in nanoseconds, 0 for none */
+static uint64_t run_timeout_ns;
+
+/* Runs of a child before it is replaced, which bounds what leaks */
+#define CHILD_RUNS 1024
+
+/*
+ * Held from creating the pipes of a child until the daemon closes the
+ * ends of the child, so no other child inherits them. Descriptors are
+ * noted in max_fd under it, a child closes all of them.
+ */
+static pthread_mutex_t fork_lock = PTHREAD_MUTEX_INITIALIZER;
+static int max_fd = 2;
+
+typedef struct image_t
+{
+  bcode_t code;
+  uint64_t seq;			/* Number of images cached before it */
+} image_t;
+
+/*
+ * The process a worker runs programs in. It is forked off the daemon,
+ * so it can run every image that was cached before the fork.
+ */
+typedef struct child_t
+{
+  pid_t pid;			/* 0 when there is none */
+  int to;			/* Requests of the worker */
+  int from;			/* Replies of the child */
+  uint64_t seq;			/* Number of images cached before the fork */
+  uint64_t runs;
+} child_t;
+
+/* Request of a worker to its child, followed by input_len bytes */
+typedef struct run_req_t
+{
+  image_t *img;
+  uint64_t input_len;
+} run_req_t;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static lblmap_t cache;
+static size_t cache_size = 0;
+
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_wake = PTHREAD_COND_INITIALIZER;
+static int queue[QUEUE_MAX];
+static size_t queue_head = 0;
+static size_t queue_len = 0;
+
+/* Workers hand idle connections back to the dispatcher through this */
+static int idle_pipe[2];
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct
+{
+  uint64_t requests;
+  uint64_t runs;
+  uint64_t failed;		/* Bad requests, bad bytecode and errors */
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t timeouts;
+  uint64_t crashes;
+  uint64_t busy;		/* Workers serving a connection */
+  uint64_t workers;
+  uint64_t latency[LATENCY_WINDOW];	/* Nanoseconds, ring buffer */
+  uint64_t nlatency;
+} stats;
+
+uint64_t
+serve_now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+char *
+serve_slurp (FILE * f, size_t * len)
+{
+  size_t cap = 4096;
+  char *buf = malloc (cap);
+  *len = 0;
+  size_t n;
+  while (buf != NULL && (n = fread (buf + *len, 1, cap - *len, f)) > 0)
+    if ((*len += n) == cap)
+      {
+	char *grown = realloc (buf, cap *= 2);
+	if (grown == NULL)
+	  free (buf);
+	buf = grown;
+      }
+  return buf;
+}
+
+int
+serve_cmp_u64 (const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *) a;
+  const uint64_t y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+/* Callers hold fork_lock */
+static void
+note_fd (int fd)
+{
+  if (fd > max_fd)
+    max_fd = fd;
+}
+
+/*
+ * Waits until fd is ready for events. A deadline of 0 waits forever,
+ * otherwise returns false once serve_now_ns passes it.
+ */
+static bool
+wait_fd (int fd, short events, uint64_t deadline)
+{
+  if (deadline == 0)
+    return true;
+  while (true)
+    {
+      const uint64_t now = serve_now_ns ();
+      if (now >= deadline)
+	return false;
+      struct pollfd pfd = {.fd = fd,.events = events };
+      const int n = poll (&pfd, 1, (deadline - now + 999999) / 1000000);
+      if (n > 0)
+	return true;
+      if (n < 0 && errno != EINTR)
+	return false;
+    }
+}
+
+static bool
+read_full (int fd, void *buf, size_t len, uint64_t deadline)
+{
+  char *p = buf;
+  while (len > 0)
+    {
+      if (!wait_fd (fd, POLLIN, deadline))
+	return false;
+      const ssize_t n = read (fd, p, len);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return false;
+      p += n;
+      len -= n;
+    }
+  return true;
+}
+
+static bool
+write_full (int fd, const void *buf, size_t len, uint64_t deadline)
+{
+  const char *p = buf;
+  while (len > 0)
+    {
+      if (!wait_fd (fd, POLLOUT, deadline))
+	return false;
+      const ssize_t n = write (fd, p, len);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return false;
+      p += n;
+      len -= n;
+    }
+  return true;
+}
+
+static bool
+read_reply (int fd, serve_reply_t * reply, uint64_t deadline)
+{
+  reply->out = NULL;
+  reply->err = NULL;
+  if (!read_full (fd, &reply->head, sizeof (reply->head), deadline)
+      || reply->head.out_len > SERVE_MAX_PAYLOAD
+      || reply->head.err_len > SERVE_MAX_PAYLOAD)
+    return false;
+  reply->out = malloc (reply->head.out_len + 1);
+  reply->err = malloc (reply->head.err_len + 1);
+  if (reply->out == NULL || reply->err == NULL
+      || !read_full (fd, reply->out, reply->head.out_len, deadline)
+      || !read_full (fd, reply->err, reply->head.err_len, deadline))
+    {
+      clean_serve_reply (reply);
+      return false;
+    }
+  reply->out[reply->head.out_len] = '\0';
+  reply->err[reply->head.err_len] = '\0';
+  return true;
+}
+
+static void
+hash_key (uint64_t hash, char *key)
+{
+  snprintf (key, 17, "%016" PRIx64, hash);
+}
+
+/*
+ * Looks up a cached image. Images are never evicted, so the pointer
+ * stays valid after the lock is released.
+ */
+static image_t *
+cache_find (uint64_t hash)
+{
+  char key[17];
+  hash_key (hash, key);
+  pthread_mutex_lock (&cache_lock);
+  image_t *img = (image_t *) get_val (&cache, key);
+  pthread_mutex_unlock (&cache_lock);
+  return img;
+}
+
+/*
+ * Offers img to the cache. Returns the cached image (which may be one
+ * another worker inserted first) or NULL if the cache is full, in which
+ * case the caller still owns img.
+ */
+static image_t *
+cache_insert (uint64_t hash, image_t * img)
+{
+  char key[17];
+  hash_key (hash, key);
+  pthread_mutex_lock (&cache_lock);
+  image_t *old = (image_t *) get_val (&cache, key);
+  char *owned;
+  if (old == NULL && cache_size < CACHE_MAX
+      && (owned = malloc (sizeof (key))) != NULL)
+    {
+      memcpy (owned, key, sizeof (key));
+      put_entry (&cache, owned, (uint64_t) img, 0);
+      img->seq = cache_size++;
+      old = img;
+    }
+  pthread_mutex_unlock (&cache_lock);
+  if (old != NULL && old != img)
+    {
+      clean_bcode (&img->code);
+      free (img);
+    }
+  return old;
+}
+
+static image_t *
+load_image (const void *code, size_t len)
+{
+  FILE *f = fmemopen ((void *) code, len, "rb");
+  if (f == NULL)
+    return NULL;
+  image_t *img = calloc (1, sizeof (image_t));
+  if (img == NULL || read_bytecode (f, &img->code) == NULL)
+    {
+      free (img);
+      img = NULL;
+    }
+  fclose (f);
+  return img;
+}
+
+static void
+run_image (image_t * img, const void *input, size_t input_len,
+	   serve_reply_t * reply)
+{
+  FILE *in = input_len == 0 ? fopen ("/dev/null", "r")
+    : fmemopen ((void *) input, input_len, "r");
+  size_t out_len = 0;
+  size_t err_len = 0;
+  FILE *out = open_memstream (&reply->out, &out_len);
+  FILE *err = open_memstream (&reply->err, &err_len);
+  if (in == NULL || out == NULL || err == NULL)
+    {
+      if (in != NULL)
+	fclose (in);
+      if (out != NULL)
+	fclose (out);
+      if (err != NULL)
+	fclose (err);
+      free (reply->out);
+      free (reply->err);
+      reply->out = NULL;
+      reply->err = NULL;
+      reply->head.status = SERVE_ERROR;
+      return;
+    }
+
+  rlvm_t vm = init_rlvm (img->code.cstack_size, img->code.estack_size,
+			 img->code.ropool);
+  vm.fin = in;
+  vm.fout = out;
+  vm.ferr = err;
+  vm.natives = img->code.natives;
+  vm.native_count = img->code.native_count;
+
+  const uint64_t start = serve_now_ns ();
+  const status_t state =
+    exec_bytecode (&vm, img->code.code_size, img->code.code);
+  reply->head.wall_ns = serve_now_ns () - start;
+  reply->head.status = SERVE_OK;
+  reply->head.state = state.state;
+  reply->head.uid = state.uid;
+  reply->head.icount = vm.icount;
+  clean_rlvm (&vm);
+
+  fclose (in);
+  fclose (out);
+  fclose (err);
+  reply->head.out_len = out_len;
+  reply->head.err_len = err_len;
+}
+
+/*
+ * Closes every descriptor of the daemon except in and out, then runs
+ * the images the worker names until it hangs up. Never returns.
+ */
+static void
+child_main (int in, int out)
+{
+  int fd;
+  for (fd = 3; fd <= max_fd; ++fd)
+    if (fd != in && fd != out)
+      close (fd);
+
+  run_req_t req;
+  while (read_full (in, &req, sizeof (req), 0))
+    {
+      char *input = malloc (req.input_len + 1);
+      if (input == NULL || !read_full (in, input, req.input_len, 0))
+	break;
+      serve_reply_t reply = {.head = {0},.out = NULL,.err = NULL };
+      run_image (req.img, input, req.input_len, &reply);
+      free (input);
+      const bool ok = write_full (out, &reply.head, sizeof (reply.head), 0)
+	&& write_full (out, reply.out, reply.head.out_len, 0)
+	&& write_full (out, reply.err, reply.head.err_len, 0);
+      clean_serve_reply (&reply);
+      if (!ok)
+	break;
+    }
+  _exit (0);
+}
+
+static bool
+start_child (child_t * child)
+{
+  int to[2];
+  int from[2];
+  pthread_mutex_lock (&fork_lock);
+  if (pipe (to) != 0)
+    {
+      pthread_mutex_unlock (&fork_lock);
+      return false;
+    }
+  if (pipe (from) != 0)
+    {
+      close (to[0]);
+      close (to[1]);
+      pthread_mutex_unlock (&fork_lock);
+      return false;
+    }
+  note_fd (to[0]);
+  note_fd (to[1]);
+  note_fd (from[0]);
+  note_fd (from[1]);
+
+  pthread_mutex_lock (&cache_lock);
+  child->seq = cache_size;
+  pthread_mutex_unlock (&cache_lock);
+  const pid_t pid = fork ();
+  if (pid == 0)
+    child_main (to[0], from[1]);
+  close (to[0]);
+  close (from[1]);
+  pthread_mutex_unlock (&fork_lock);
+  if (pid < 0)
+    {
+      close (to[1]);
+      close (from[0]);
+      return false;
+    }
+  child->pid = pid;
+  child->to = to[1];
+  child->from = from[0];
+  child->runs = 0;
+  return true;
+}
+
+/*
+ * Kills the child (if it is still there) and returns its wait status.
+ */
+static int
+stop_child (child_t * child)
+{
+  close (child->to);
+  close (child->from);
+  kill (child->pid, SIGKILL);
+  int wstatus = 0;
+  while (waitpid (child->pid, &wstatus, 0) < 0 && errno == EINTR)
+    ;
+  child->pid = 0;
+  return wstatus;
+}
+
+/*
+ * Runs img in the child of the worker, so a program that crashes or
+ * leaks only takes the child with it, and kills the child once the run
+ * timeout passes. An uncached (owned) image gets a child of its own.
+ */
+static void
+run_isolated (child_t * child, image_t * img, bool owned,
+	      const void *input, size_t input_len, serve_reply_t * reply)
+{
+  if (child->pid != 0
+      && (owned || img->seq >= child->seq || child->runs == CHILD_RUNS))
+    stop_child (child);
+  if (child->pid == 0 && !start_child (child))
+    {
+      reply->head.status = SERVE_ERROR;
+      return;
+    }
+  ++child->runs;
+
+  const uint64_t start = serve_now_ns ();
+  const uint64_t deadline = run_timeout_ns == 0 ? 0 : start + run_timeout_ns;
+  const run_req_t req = {.img = img,.input_len = input_len };
+  if (write_full (child->to, &req, sizeof (req), deadline)
+      && write_full (child->to, input, input_len, deadline)
+      && read_reply (child->from, reply, deadline))
+    {
+      if (owned)
+	stop_child (child);
+      return;
+    }
+
+  /* The child is either stuck or dead, it goes in both cases */
+  const bool late = deadline != 0 && serve_now_ns () >= deadline;
+  const int wstatus = stop_child (child);
+  clean_serve_reply (reply);
+  reply->head = (serve_rep_t)
+  {
+  .status = SERVE_ERROR};
+  if (late)
+    reply->head.status = SERVE_TIMEOUT;
+  else if (WIFSIGNALED (wstatus))
+    {
+      reply->head.status = SERVE_CRASHED;
+      reply->head.uid = WTERMSIG (wstatus);
+    }
+  reply->head.wall_ns = serve_now_ns () - start;
+}
+
+static void
+stats_json (serve_reply_t * reply)
+{
+  static uint64_t window[LATENCY_WINDOW];
+  static pthread_mutex_t window_lock = PTHREAD_MUTEX_INITIALIZER;
+
+  pthread_mutex_lock (&queue_lock);
+  const size_t depth = queue_len;
+  pthread_mutex_unlock (&queue_lock);
+  pthread_mutex_lock (&cache_lock);
+  const size_t cached = cache_size;
+  pthread_mutex_unlock (&cache_lock);
+
+  pthread_mutex_lock (&window_lock);
+  pthread_mutex_lock (&stats_lock);
+  const size_t n = stats.nlatency < LATENCY_WINDOW
+    ? stats.nlatency : LATENCY_WINDOW;
+  memcpy (window, stats.latency, n * sizeof (uint64_t));
+  const uint64_t requests = stats.requests;
+  const uint64_t runs = stats.runs;
+  const uint64_t failed = stats.failed;
+  const uint64_t hits = stats.hits;
+  const uint64_t misses = stats.misses;
+  const uint64_t timeouts = stats.timeouts;
+  const uint64_t crashes = stats.crashes;
+  const uint64_t busy = stats.busy;
+  const uint64_t workers = stats.workers;
+  pthread_mutex_unlock (&stats_lock);
+
+  qsort (window, n, sizeof (uint64_t), serve_cmp_u64);
+  size_t len = 0;
+  FILE *f = open_memstream (&reply->out, &len);
+  if (f == NULL)
+    {
+      pthread_mutex_unlock (&window_lock);
+      reply->out = NULL;
+      reply->head.status = SERVE_ERROR;
+      return;
+    }
+#define PCT(p) (n == 0 ? 0 : window[(n - 1) * (p) / 100] / 1000)
+  fprintf (f, "{\"requests\": %" PRIu64 ", \"runs\": %" PRIu64
+	   ", \"failed\": %" PRIu64 ", \"timeouts\": %" PRIu64
+	   ", \"crashes\": %" PRIu64 ", \"queue_depth\": %zu"
+	   ", \"busy_workers\": %" PRIu64 ", \"workers\": %" PRIu64
+	   ", \"cached_programs\": %zu, \"cache_hits\": %" PRIu64
+	   ", \"cache_misses\": %" PRIu64 ", \"cache_hit_rate\": %.4f"
+	   ", \"latency_us\": {\"samples\": %zu, \"p50\": %" PRIu64
+	   ", \"p90\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"max\": %" PRIu64
+	   "}}\n", requests, runs, failed, timeouts, crashes, depth, busy,
+	   workers, cached, hits, misses, hits + misses == 0 ? 0.0
+	   : (double) hits / (hits + misses), n, PCT (50), PCT (90),
+	   PCT (99), PCT (100));
+#undef PCT
+  pthread_mutex_unlock (&window_lock);
+  fclose (f);
+  reply->head.status = SERVE_OK;
+  reply->head.out_len = len;
+}
+
+/*
+ * Serves one request, running programs in child. Returns false when
+ * the connection should be dropped (EOF, transport error or malformed
+ * header).
+ */
+static bool
+handle_request (int fd, child_t * child)
+{
+  /* The whole request has to arrive in time, not just every read */
+  const uint64_t start = serve_now_ns ();
+  serve_req_t req;
+  if (!read_full (fd, &req, sizeof (req), start + IO_TIMEOUT_NS))
+    return false;
+
+  serve_reply_t reply = {.head = {0},.out = NULL,.err = NULL };
+  char *code = NULL;
+  char *input = NULL;
+  bool keep = true;
+  bool hit = false;
+  bool miss = false;
+  if (req.code_len > SERVE_MAX_PAYLOAD || req.input_len > SERVE_MAX_PAYLOAD)
+    {
+      reply.head.status = SERVE_BAD_REQUEST;
+      keep = false;
+      goto respond;
+    }
+  code = malloc (req.code_len + 1);
+  input = malloc (req.input_len + 1);
+  if (code == NULL || input == NULL)
+    {
+      /* The payload stays unread, so the connection cannot be reused */
+      reply.head.status = SERVE_ERROR;
+      keep = false;
+      goto respond;
+    }
+  if (!read_full (fd, code, req.code_len, start + IO_TIMEOUT_NS)
+      || !read_full (fd, input, req.input_len, start + IO_TIMEOUT_NS))
+    {
+      free (code);
+      free (input);
+      return false;
+    }
+
+  switch (req.kind)
+    {
+    case SERVE_STATS:
+      stats_json (&reply);
+      break;
+    case SERVE_RUN:
+      {
+	image_t *img = NULL;
+	bool owned = false;
+	if (req.code_len == 0)
+	  {
+	    if ((img = cache_find (req.hash)) == NULL)
+	      {
+		reply.head.status = SERVE_MISS;
+		break;
+	      }
+	    hit = true;
+	  }
+	else
+	  {
+	    /* Never trust the hash of the client when the code is here */
+	    const uint64_t hash = hash_xxh64 (code, req.code_len, 0);
+	    if ((img = cache_find (hash)) != NULL)
+	      hit = true;
+	    else
+	      {
+		miss = true;
+		if ((img = load_image (code, req.code_len)) == NULL)
+		  {
+		    reply.head.status = SERVE_BAD_BYTECODE;
+		    break;
+		  }
+		image_t *cached = cache_insert (hash, img);
+		if (cached == NULL)
+		  owned = true;
+		else
+		  img = cached;
+	      }
+	  }
+	run_isolated (child, img, owned, input, req.input_len, &reply);
+	if (owned)
+	  {
+	    clean_bcode (&img->code);
+	    free (img);
+	  }
+      }
+      break;
+    default:
+      reply.head.status = SERVE_BAD_REQUEST;
+      break;
+    }
+
+respond:
+  free (code);
+  free (input);
+  const uint64_t deadline = serve_now_ns () + IO_TIMEOUT_NS;
+  if (!write_full (fd, &reply.head, sizeof (reply.head), deadline)
+      || !write_full (fd, reply.out, reply.head.out_len, deadline)
+      || !write_full (fd, reply.err, reply.head.err_len, deadline))
+    keep = false;
+
+  const uint64_t latency = serve_now_ns () - start;
+  pthread_mutex_lock (&stats_lock);
+  ++stats.requests;
+  if (req.kind == SERVE_RUN && reply.head.status == SERVE_OK)
+    ++stats.runs;
+  if (reply.head.status == SERVE_BAD_REQUEST
+      || reply.head.status == SERVE_BAD_BYTECODE
+      || reply.head.status == SERVE_ERROR)
+    ++stats.failed;
+  stats.timeouts += reply.head.status == SERVE_TIMEOUT;
+  stats.crashes += reply.head.status == SERVE_CRASHED;
+  stats.hits += hit;
+  stats.misses += miss;
+  if (req.kind == SERVE_RUN)
+    stats.latency[stats.nlatency++ % LATENCY_WINDOW] = latency;
+  pthread_mutex_unlock (&stats_lock);
+
+  clean_serve_reply (&reply);
+  return keep;
+}
+
+static void *
+worker_main (void *arg)
+{
+  (void) arg;
+  child_t child = {.pid = 0 };
+  while (true)
+    {
+      pthread_mutex_lock (&queue_lock);
+      while (queue_len == 0)
+	pthread_cond_wait (&queue_wake, &queue_lock);
+      const int fd = queue[queue_head];
+      queue_head = (queue_head + 1) % QUEUE_MAX;
+      --queue_len;
+      pthread_mutex_unlock (&queue_lock);
+
+      __sync_fetch_and_add (&stats.busy, 1);
+      if (!handle_request (fd, &child)
+	  || write (idle_pipe[1], &fd, sizeof (fd)) != sizeof (fd))
+	close (fd);
+      __sync_fetch_and_sub (&stats.busy, 1);
+    }
+  return NULL;
+}
+
+int
+serve (const char *path, size_t nthreads, uint64_t timeout_ms)
+{
+  struct sockaddr_un addr = {.sun_family = AF_UNIX };
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      fprintf (stderr, "error: socket path too long %s\n", path);
+      return 2;
+    }
+  strcpy (addr.sun_path, path);
+
+  const int sock = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0)
+    {
+      perror ("socket");
+      return 2;
+    }
+  unlink (path);
+  /* Anyone who can connect can run code as us, keep it to the owner */
+  const mode_t mask = umask (0177);
+  const int bound = bind (sock, (struct sockaddr *) &addr, sizeof (addr));
+  umask (mask);
+  if (bound != 0 || listen (sock, 128) != 0)
+    {
+      fprintf (stderr, "error: failed to listen on %s\n", path);
+      close (sock);
+      return 2;
+    }
+
+  if (pipe (idle_pipe) != 0)
+    {
+      perror ("pipe");
+      close (sock);
+      return 2;
+    }
+
+  run_timeout_ns = timeout_ms * 1000000;
+  note_fd (sock);
+  note_fd (idle_pipe[0]);
+  note_fd (idle_pipe[1]);
+  /* A client hanging up mid reply should not kill the daemon */
+  signal (SIGPIPE, SIG_IGN);
+  cache = init_map (CACHE_MAX);
+
+  if (nthreads == 0)
+    {
+      const long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      nthreads = cpus > 0 ? cpus : 1;
+    }
+  size_t i;
+  for (i = 0; i < nthreads; ++i)
+    {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, worker_main, NULL) != 0)
+	break;
+      pthread_detach (thread);
+    }
+  if (i == 0)
+    {
+      fprintf (stderr, "error: failed to start workers\n");
+      close (sock);
+      return 2;
+    }
+  stats.workers = i;
+
+  /*
+   * A worker serves one request at a time. Between requests the
+   * connection sits in the poll set below, so a slow client does not
+   * hold on to a worker and the queue only ever holds ready requests.
+   */
+  size_t npfd = 2;
+  size_t cap = 64;
+  struct pollfd *pfd = malloc (cap * sizeof (struct pollfd));
+  pfd[0] = (struct pollfd)
+  {
+  .fd = sock,.events = POLLIN};
+  pfd[1] = (struct pollfd)
+  {
+  .fd = idle_pipe[0],.events = POLLIN};
+  while (true)
+    {
+      if (poll (pfd, npfd, -1) < 0)
+	{
+	  if (errno != EINTR)
+	    perror ("poll");
+	  continue;
+	}
+      size_t j;
+      for (j = npfd; j-- > 2;)
+	if (pfd[j].revents != 0)
+	  {
+	    const int fd = pfd[j].fd;
+	    pfd[j] = pfd[--npfd];
+	    pthread_mutex_lock (&queue_lock);
+	    if (queue_len == QUEUE_MAX)
+	      {
+		/* Overloaded, shed the connection instead of blocking */
+		pthread_mutex_unlock (&queue_lock);
+		close (fd);
+		continue;
+	      }
+	    queue[(queue_head + queue_len++) % QUEUE_MAX] = fd;
+	    pthread_cond_signal (&queue_wake);
+	    pthread_mutex_unlock (&queue_lock);
+	  }
+
+      int fd = -1;
+      if (pfd[1].revents != 0
+	  && read (idle_pipe[0], &fd, sizeof (fd)) != sizeof (fd))
+	fd = -1;
+      if (fd < 0 && pfd[0].revents != 0)
+	{
+	  pthread_mutex_lock (&fork_lock);
+	  fd = accept (sock, NULL, NULL);
+	  note_fd (fd);
+	  pthread_mutex_unlock (&fork_lock);
+	  if (fd < 0 && errno != EINTR && errno != ECONNABORTED)
+	    perror ("accept");
+	}
+      if (fd >= 0)
+	{
+	  if (npfd == cap)
+	    pfd = realloc (pfd, (cap *= 2) * sizeof (struct pollfd));
+	  pfd[npfd++] = (struct pollfd)
+	  {
+	  .fd = fd,.events = POLLIN};
+	}
+    }
+  return 0;
+}
+
+int
+serve_connect (const char *path)
+{
+  struct sockaddr_un addr = {.sun_family = AF_UNIX };
+  if (strlen (path) >= sizeof (addr.sun_path))
+    return -1;
+  strcpy (addr.sun_path, path);
+  const int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
+
+bool
+serve_run (int fd, uint64_t hash, const void *code, size_t code_len,
+	   const void *input, size_t input_len, serve_reply_t * reply)
+{
+  serve_req_t req = {
+    .kind = SERVE_RUN,.hash = hash,.code_len = code == NULL ? 0 : code_len,
+    .input_len = input_len
+  };
+  if (!write_full (fd, &req, sizeof (req), 0)
+      || !write_full (fd, code, req.code_len, 0)
+      || !write_full (fd, input, input_len, 0))
+    return false;
+  return read_reply (fd, reply, 0);
+}
+
+bool
+serve_stats (int fd, serve_reply_t * reply)
+{
+  serve_req_t req = {.kind = SERVE_STATS,.hash = 0,.code_len =
+      0,.input_len = 0
+  };
+  if (!write_full (fd, &req, sizeof (req), 0))
+    return false;
+  return read_reply (fd, reply, 0);
+}
+
+void
+clean_serve_reply (serve_reply_t * reply)
+{
+  free (reply->out);
+  reply->out = NULL;
+  free (reply->err);
+  reply->err = NULL;
+}
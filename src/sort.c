@@ -0,0 +1,203 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sort.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Below this an insertion sort beats the histogram passes */
+#define SMALL_SORT 48
+#define KEY_BYTES 8
+
+static inline uint64_t
+__encode (uint64_t key, sort_kind_t kind, bool desc)
+{
+  switch (kind)
+    {
+    case SORT_SIGNED:
+      key ^= UINT64_C (1) << 63;
+      break;
+    case SORT_FLOAT:
+      /* Negative doubles flip every bit, the rest only the sign bit */
+      key ^= (uint64_t) ((int64_t) key >> 63) | UINT64_C (1) << 63;
+      break;
+    default:
+      break;
+    }
+  return desc ? ~key : key;
+}
+
+static inline uint64_t
+__decode (uint64_t key, sort_kind_t kind, bool desc)
+{
+  if (desc)
+    key = ~key;
+  switch (kind)
+    {
+    case SORT_SIGNED:
+      key ^= UINT64_C (1) << 63;
+      break;
+    case SORT_FLOAT:
+      key ^= (key >> 63) ? UINT64_C (1) << 63 : ~UINT64_C (0);
+      break;
+    default:
+      break;
+    }
+  return key;
+}
+
+static void
+__insertion (uint64_t * keys, uint64_t * vals, uint64_t n)
+{
+  uint64_t i;
+  for (i = 1; i < n; ++i)
+    {
+      const uint64_t k = keys[i];
+      const uint64_t v = vals == NULL ? 0 : vals[i];
+      uint64_t j = i;
+      for (; j > 0 && keys[j - 1] > k; --j)
+	{
+	  keys[j] = keys[j - 1];
+	  if (vals != NULL)
+	    vals[j] = vals[j - 1];
+	}
+      keys[j] = k;
+      if (vals != NULL)
+	vals[j] = v;
+    }
+}
+
+/*
+ * Sorts already encoded keys. The histograms of all 8 bytes are taken
+ * in one read, then each pass that actually splits the keys scatters
+ * them between the array and the scratch buffer.
+ */
+static bool
+__radix (uint64_t * keys, uint64_t * vals, uint64_t n)
+{
+  uint64_t *buf = malloc (n * sizeof (uint64_t) * (vals == NULL ? 1 : 2));
+  if (buf == NULL)
+    return false;
+
+  uint64_t (*hist)[256] = calloc (KEY_BYTES, sizeof (*hist));
+  if (hist == NULL)
+    {
+      free (buf);
+      return false;
+    }
+
+  uint64_t i;
+  int b;
+  for (i = 0; i < n; ++i)
+    for (b = 0; b < KEY_BYTES; ++b)
+      ++hist[b][(keys[i] >> (b * 8)) & 0xFF];
+
+  uint64_t *src_k = keys;
+  uint64_t *src_v = vals;
+  uint64_t *dst_k = buf;
+  uint64_t *dst_v = vals == NULL ? NULL : buf + n;
+  for (b = 0; b < KEY_BYTES; ++b)
+    {
+      const int shift = b * 8;
+      if (hist[b][(keys[0] >> shift) & 0xFF] == n)
+	continue;
+
+      /* Turn the counts into the starting index of each bucket */
+      uint64_t sum = 0;
+      int d;
+      for (d = 0; d < 256; ++d)
+	{
+	  const uint64_t c = hist[b][d];
+	  hist[b][d] = sum;
+	  sum += c;
+	}
+
+      for (i = 0; i < n; ++i)
+	{
+	  const uint64_t at = hist[b][(src_k[i] >> shift) & 0xFF]++;
+	  dst_k[at] = src_k[i];
+	  if (dst_v != NULL)
+	    dst_v[at] = src_v[i];
+	}
+
+      uint64_t *t = src_k;
+      src_k = dst_k;
+      dst_k = t;
+      t = src_v;
+      src_v = dst_v;
+      dst_v = t;
+    }
+
+  if (src_k != keys)
+    {
+      memcpy (keys, src_k, n * sizeof (uint64_t));
+      if (vals != NULL)
+	memcpy (vals, src_v, n * sizeof (uint64_t));
+    }
+  free (hist);
+  free (buf);
+  return true;
+}
+
+bool
+sort_words (uint64_t * keys, uint64_t * vals, uint64_t n,
+	    sort_kind_t kind, bool desc)
+{
+  if (n < 2)
+    return true;
+
+  uint64_t i;
+  for (i = 0; i < n; ++i)
+    keys[i] = __encode (keys[i], kind, desc);
+
+  bool ok = true;
+  if (n < SMALL_SORT)
+    __insertion (keys, vals, n);
+  else
+    ok = __radix (keys, vals, n);
+
+  for (i = 0; i < n; ++i)
+    keys[i] = __decode (keys[i], kind, desc);
+  return ok;
+}
+
+uint64_t
+sort_lower_bound (const uint64_t * keys, uint64_t n, uint64_t key,
+		  sort_kind_t kind, bool desc)
+{
+  const uint64_t k = __encode (key, kind, desc);
+  uint64_t lo = 0;
+
+  /* Halves the range without a data dependent branch */
+  while (n > 1)
+    {
+      const uint64_t half = n / 2;
+      lo = __encode (keys[lo + half - 1], kind, desc) < k ? lo + half : lo;
+      n -= half;
+    }
+  if (n == 1 && __encode (keys[lo], kind, desc) < k)
+    ++lo;
+  return lo;
+}
@@ -0,0 +1,218 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "strbuf.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char DIGIT_PAIRS[201] =
+  "00010203040506070809101112131415161718192021222324"
+  "25262728293031323334353637383940414243444546474849"
+  "50515253545556575859606162636465666768697071727374"
+  "75767778798081828384858687888990919293949596979899";
+
+/* Makes room for n more bytes past len */
+static bool
+__reserve (strbuf_t * sb, uint64_t n)
+{
+  if (sb->len + n <= sb->cap)
+    return true;
+  uint64_t cap = sb->cap < 64 ? 64 : sb->cap;
+  while (cap < sb->len + n)
+    cap *= 2;
+  char *data = realloc (sb->data, cap);
+  if (data == NULL)
+    return false;
+  sb->data = data;
+  sb->cap = cap;
+  return true;
+}
+
+static bool
+__append (strbuf_t * sb, const char *s, uint64_t n)
+{
+  if (!__reserve (sb, n))
+    return false;
+  memcpy (sb->data + sb->len, s, n);
+  sb->len += n;
+  return true;
+}
+
+strbuf_t *
+strbuf_new (void)
+{
+  return calloc (1, sizeof (strbuf_t));
+}
+
+void
+strbuf_free (strbuf_t * sb)
+{
+  if (sb == NULL)
+    return;
+  free (sb->data);
+  free (sb);
+}
+
+bool
+strbuf_putc (strbuf_t * sb, char c)
+{
+  if (!__reserve (sb, 1))
+    return false;
+  sb->data[sb->len++] = c;
+  return true;
+}
+
+bool
+strbuf_puts (strbuf_t * sb, const char *s)
+{
+  return __append (sb, s, strlen (s));
+}
+
+bool
+strbuf_put_u64 (strbuf_t * sb, uint64_t v)
+{
+  /* Written backwards two digits at a time */
+  char tmp[20];
+  char *p = tmp + sizeof (tmp);
+  while (v >= 100)
+    {
+      const unsigned d = (v % 100) * 2;
+      v /= 100;
+      *--p = DIGIT_PAIRS[d + 1];
+      *--p = DIGIT_PAIRS[d];
+    }
+  if (v >= 10)
+    {
+      *--p = DIGIT_PAIRS[v * 2 + 1];
+      *--p = DIGIT_PAIRS[v * 2];
+    }
+  else
+    *--p = '0' + v;
+  return __append (sb, p, tmp + sizeof (tmp) - p);
+}
+
+bool
+strbuf_put_i64 (strbuf_t * sb, int64_t v)
+{
+  if (v >= 0)
+    return strbuf_put_u64 (sb, v);
+  if (!__reserve (sb, 21))
+    return false;
+  sb->data[sb->len++] = '-';
+  return strbuf_put_u64 (sb, -(uint64_t) v);
+}
+
+bool
+strbuf_put_hex (strbuf_t * sb, uint64_t v)
+{
+  static const char HEX[] = "0123456789abcdef";
+  char tmp[16];
+  char *p = tmp + sizeof (tmp);
+  do
+    {
+      *--p = HEX[v & 0xF];
+      v >>= 4;
+    }
+  while (v != 0);
+  return __append (sb, p, tmp + sizeof (tmp) - p);
+}
+
+/*
+ * Values with at most 15 significant digits that are not too small are
+ * an integer over a power of ten. Those are written directly in the
+ * same plain notation %g would pick.
+ */
+static bool
+__put_f64_fixed (strbuf_t * sb, double v)
+{
+  static const double P10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15
+  };
+  const double a = v < 0 ? -v : v;
+  if (!(a >= 1e-4 && a < 1e15))
+    return false;
+
+  int k;
+  for (k = 0; k < 16; ++k)
+    {
+      const double x = a * P10[k];
+      if (x >= 1e15)
+	return false;
+      if (x != (double) (uint64_t) x || x / P10[k] != a)
+	continue;
+
+      char tmp[24];
+      char *p = tmp + sizeof (tmp);
+      uint64_t d = x;
+      int i;
+      for (; k > 0 && d % 10 == 0; --k)
+	d /= 10;
+      for (i = 0; i < k; ++i, d /= 10)
+	*--p = '0' + d % 10;
+      if (k > 0)
+	*--p = '.';
+      do
+	{
+	  *--p = '0' + d % 10;
+	  d /= 10;
+	}
+      while (d != 0);
+      if (v < 0)
+	*--p = '-';
+      return __append (sb, p, tmp + sizeof (tmp) - p);
+    }
+  return false;
+}
+
+bool
+strbuf_put_f64 (strbuf_t * sb, double v)
+{
+  if (__put_f64_fixed (sb, v))
+    return true;
+
+  /*
+   * %g drops trailing zeros, so the first precision that reads back
+   * exactly is also the shortest. 17 digits always does.
+   */
+  char tmp[32];
+  int n = 0;
+  int prec;
+  for (prec = 15; prec <= 17; ++prec)
+    {
+      n = snprintf (tmp, sizeof (tmp), "%.*g", prec, v);
+      if (v != v || strtod (tmp, NULL) == v)
+	break;
+    }
+  return __append (sb, tmp, n);
+}
+
+uint64_t
+strbuf_flush (strbuf_t * sb, FILE * f)
+{
+  const uint64_t n = fwrite (sb->data, 1, sb->len, f);
+  sb->len = 0;
+  return n;
+}
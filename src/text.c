@@ -0,0 +1,129 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* !_GNU_SOURCE */
+
+#include "text.h"
+#include "simd.h"
+
+#include <string.h>
+
+const void *
+text_memrchr (const void *s, int c, size_t n)
+{
+#ifdef __GLIBC__
+  return memrchr (s, c, n);
+#else
+  const unsigned char *p = s;
+  while (n-- > 0)
+    if (p[n] == (unsigned char) c)
+      return p + n;
+  return NULL;
+#endif
+}
+
+const void *
+text_memmem (const void *hay, size_t hlen, const void *needle, size_t nlen)
+{
+#ifdef __GLIBC__
+  return memmem (hay, hlen, needle, nlen);
+#else
+  if (nlen == 0)
+    return hay;
+  const unsigned char *h = hay;
+  const unsigned char *end = h + hlen;
+  while (hlen >= nlen)
+    {
+      const unsigned char *p = memchr (h, *(const unsigned char *) needle,
+				       hlen - nlen + 1);
+      if (p == NULL)
+	return NULL;
+      if (memcmp (p, needle, nlen) == 0)
+	return p;
+      h = p + 1;
+      hlen = end - h;
+    }
+  return NULL;
+#endif
+}
+
+/* Bytes checked at once for being plain ASCII */
+#define ASCII_BLOCK 64
+
+SIMD_DISPATCH uint64_t
+text_utf8_valid (const uint8_t * s, uint64_t len)
+{
+  uint64_t i = 0;
+  while (i < len)
+    {
+      /* Most text is ASCII, skip it a vector at a time */
+      if (len - i >= ASCII_BLOCK)
+	{
+	  uint8_t acc = 0;
+	  size_t k;
+	  for (k = 0; k < ASCII_BLOCK; ++k)
+	    acc |= s[i + k];
+	  if ((acc & 0x80) == 0)
+	    {
+	      i += ASCII_BLOCK;
+	      continue;
+	    }
+	}
+
+      const uint8_t c = s[i];
+      if (c < 0x80)
+	{
+	  ++i;
+	  continue;
+	}
+
+      size_t n;
+      uint32_t cp;
+      uint32_t min;
+      if ((c & 0xE0) == 0xC0)
+	n = 1, cp = c & 0x1F, min = 0x80;
+      else if ((c & 0xF0) == 0xE0)
+	n = 2, cp = c & 0x0F, min = 0x800;
+      else if ((c & 0xF8) == 0xF0)
+	n = 3, cp = c & 0x07, min = 0x10000;
+      else
+	return i;
+      if (len - i <= n)
+	return i;		/* Truncated sequence */
+
+      size_t k;
+      for (k = 1; k <= n; ++k)
+	{
+	  if ((s[i + k] & 0xC0) != 0x80)
+	    return i;
+	  cp = cp << 6 | (s[i + k] & 0x3F);
+	}
+      if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+	return i;
+      i += n + 1;
+    }
+  return len;
+}
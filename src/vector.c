@@ -0,0 +1,414 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "vector.h"
+#include "simd.h"
+
+#include <math.h>
+#include <string.h>
+
+#define LANES(f) (sizeof (d.f) / sizeof (d.f[0]))
+
+/* Computes every lane of d, i is the lane index inside EXPR */
+#define LANEWISE(f, EXPR)			\
+  for (i = 0; i < LANES (f); ++i)		\
+    d.f[i] = (EXPR)
+
+/*
+ * Expands M once per lane type. M receives the view used for
+ * arithmetic, the unsigned integer view of the same width and X.
+ */
+#define INT_CASES(M, X)				\
+  case VEC_B: M (b, ub, X); break;		\
+  case VEC_W: M (w, uw, X); break;		\
+  case VEC_D: M (d, ud, X); break;		\
+  case VEC_Q: M (q, uq, X); break
+
+#define FLOAT_CASES(M, X)			\
+  case VEC_PS: M (ps, ud, X); break;		\
+  case VEC_PD: M (pd, uq, X); break
+
+/* Integer lanes wrap around, so do the math on the unsigned view */
+#define WRAP(s, u, OP) LANEWISE (u, a.u[i] OP b.u[i])
+#define ARITH(s, u, OP) LANEWISE (s, a.s[i] OP b.s[i])
+#define PICK(s, u, OP) LANEWISE (s, a.s[i] OP b.s[i] ? a.s[i] : b.s[i])
+#define WRAP_FMA(s, u, X) LANEWISE (u, d.u[i] + a.u[i] * b.u[i])
+/* Float lanes round once, same as the scalar FMA */
+#define FMA_ps fmaf
+#define FMA_pd fma
+#define ARITH_FMA(s, u, X) LANEWISE (s, FMA_##s (a.s[i], b.s[i], d.s[i]))
+#define MASK_OF(s, u, OP) LANEWISE (u, -(a.s[i] OP b.s[i]))
+#define SHUFFLE(s, u, X) LANEWISE (u, a.u[b.u[i] % LANES (u)])
+#define SPLAT(s, u, VAL) LANEWISE (s, VAL)
+#define UNARY(s, u, F) LANEWISE (s, F (a.s[i]))
+#define INT_ABS(s, u, X) LANEWISE (u, a.s[i] < 0 ? -a.u[i] : a.u[i])
+
+#define INT_SUM(s, u, X)					\
+  do								\
+    {								\
+      uint64_t acc = 0;						\
+      for (i = 0; i < LANES (s); ++i)				\
+	acc += (uint64_t) (int64_t) a.s[i];			\
+      vm->iregs[instr.fvar.rd] = acc;				\
+    }								\
+  while (0)
+
+#define FLOAT_SUM(s, u, X)					\
+  do								\
+    {								\
+      double acc = 0;						\
+      for (i = 0; i < LANES (s); ++i)				\
+	acc += a.s[i];						\
+      vm->fregs[instr.fvar.rd] = acc;				\
+    }								\
+  while (0)
+
+#define REDUCE(s, u, OP)					\
+  do								\
+    {								\
+      d.s[0] = a.s[0];						\
+      for (i = 1; i < LANES (s); ++i)				\
+	if (a.s[i] OP d.s[0])					\
+	  d.s[0] = a.s[i];					\
+    }								\
+  while (0)
+
+#define SIGN_BITS(s, u, X)					\
+  do								\
+    {								\
+      uint64_t m = 0;						\
+      for (i = 0; i < LANES (u); ++i)				\
+	m |= (uint64_t) (a.u[i] >> (sizeof (a.u[0]) * 8 - 1)) << i;	\
+      vm->iregs[instr.fvar.rd] = m;				\
+    }								\
+  while (0)
+
+#define INT_GET(s, u, X)					\
+  vm->iregs[instr.fvar.rd] =					\
+    (int64_t) a.s[vm->iregs[instr.fvar.rt] % LANES (s)]
+#define FLOAT_GET(s, u, X)					\
+  vm->fregs[instr.fvar.rd] = a.s[vm->iregs[instr.fvar.rt] % LANES (s)]
+#define LANE_SET(s, u, VAL)					\
+  d.s[vm->iregs[instr.fvar.rt] % LANES (s)] = (VAL)
+
+bool
+vec_is_float (unsigned int type)
+{
+  return type == VEC_PS || type == VEC_PD;
+}
+
+/*
+ * Cloned per instruction set (see simd.h), so the fixed size lane
+ * loops below become single SSE2 or AVX2 instructions.
+ */
+SIMD_DISPATCH bool
+exec_vector (rlvm_t * vm, opcode_t instr)
+{
+  const unsigned int type = instr.fvar.sa & 7;
+  const unsigned int pred = instr.fvar.sa >> 3;
+  const vreg_t a = vm->vregs[instr.fvar.rs];
+  const vreg_t b = vm->vregs[instr.fvar.rt];
+  vreg_t d = vm->vregs[instr.fvar.rd];
+  size_t i;
+
+  switch (instr.fvar.fn)
+    {
+    case VEC_LD:
+      memcpy (&d, (const void *) vm->iregs[instr.fvar.rs], sizeof (d));
+      break;
+    case VEC_ST:
+      memcpy ((void *) vm->iregs[instr.fvar.rs], &b, sizeof (b));
+      return true;
+    case VEC_MOV:
+      d = a;
+      break;
+    case VEC_AND:
+      LANEWISE (uq, a.uq[i] & b.uq[i]);
+      break;
+    case VEC_OR:
+      LANEWISE (uq, a.uq[i] | b.uq[i]);
+      break;
+    case VEC_XOR:
+      LANEWISE (uq, a.uq[i] ^ b.uq[i]);
+      break;
+    case VEC_BLEND:
+      LANEWISE (uq, (d.uq[i] & a.uq[i]) | (~d.uq[i] & b.uq[i]));
+      break;
+    case VEC_ADD:
+      switch (type)
+	{
+	  INT_CASES (WRAP, +);
+	  FLOAT_CASES (ARITH, +);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_SUB:
+      switch (type)
+	{
+	  INT_CASES (WRAP, -);
+	  FLOAT_CASES (ARITH, -);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_MUL:
+      switch (type)
+	{
+	  INT_CASES (WRAP, *);
+	  FLOAT_CASES (ARITH, *);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_DIV:
+      switch (type)
+	{
+	  FLOAT_CASES (ARITH, /);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_MIN:
+      switch (type)
+	{
+	  INT_CASES (PICK, <);
+	  FLOAT_CASES (PICK, <);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_MAX:
+      switch (type)
+	{
+	  INT_CASES (PICK, >);
+	  FLOAT_CASES (PICK, >);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_FMA:
+      switch (type)
+	{
+	  INT_CASES (WRAP_FMA, 0);
+	  FLOAT_CASES (ARITH_FMA, 0);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_CMP:
+      switch (pred)
+	{
+	case VEC_EQ:
+	  switch (type)
+	    {
+	      INT_CASES (MASK_OF, ==);
+	      FLOAT_CASES (MASK_OF, ==);
+	    default:
+	      return false;
+	    }
+	  break;
+	case VEC_NE:
+	  switch (type)
+	    {
+	      INT_CASES (MASK_OF, !=);
+	      FLOAT_CASES (MASK_OF, !=);
+	    default:
+	      return false;
+	    }
+	  break;
+	case VEC_LT:
+	  switch (type)
+	    {
+	      INT_CASES (MASK_OF, <);
+	      FLOAT_CASES (MASK_OF, <);
+	    default:
+	      return false;
+	    }
+	  break;
+	case VEC_GT:
+	  switch (type)
+	    {
+	      INT_CASES (MASK_OF, >);
+	      FLOAT_CASES (MASK_OF, >);
+	    default:
+	      return false;
+	    }
+	  break;
+	}
+      break;
+    case VEC_SHUF:
+      switch (type)
+	{
+	  INT_CASES (SHUFFLE, 0);
+	  FLOAT_CASES (SHUFFLE, 0);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_BCST:
+      switch (type)
+	{
+	  INT_CASES (SPLAT, vm->iregs[instr.fvar.rs]);
+	  FLOAT_CASES (SPLAT, vm->fregs[instr.fvar.rs]);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_SUM:
+      switch (type)
+	{
+	  INT_CASES (INT_SUM, 0);
+	  FLOAT_CASES (FLOAT_SUM, 0);
+	default:
+	  return false;
+	}
+      return true;
+    case VEC_RMIN:
+    case VEC_RMAX:
+      {
+	const bool is_min = instr.fvar.fn == VEC_RMIN;
+	switch (type)
+	  {
+	  case VEC_B:
+	    if (is_min)
+	      REDUCE (b, ub, <);
+	    else
+	      REDUCE (b, ub, >);
+	    vm->iregs[instr.fvar.rd] = (int64_t) d.b[0];
+	    break;
+	  case VEC_W:
+	    if (is_min)
+	      REDUCE (w, uw, <);
+	    else
+	      REDUCE (w, uw, >);
+	    vm->iregs[instr.fvar.rd] = (int64_t) d.w[0];
+	    break;
+	  case VEC_D:
+	    if (is_min)
+	      REDUCE (d, ud, <);
+	    else
+	      REDUCE (d, ud, >);
+	    vm->iregs[instr.fvar.rd] = (int64_t) d.d[0];
+	    break;
+	  case VEC_Q:
+	    if (is_min)
+	      REDUCE (q, uq, <);
+	    else
+	      REDUCE (q, uq, >);
+	    vm->iregs[instr.fvar.rd] = d.q[0];
+	    break;
+	  case VEC_PS:
+	    if (is_min)
+	      REDUCE (ps, ud, <);
+	    else
+	      REDUCE (ps, ud, >);
+	    vm->fregs[instr.fvar.rd] = d.ps[0];
+	    break;
+	  case VEC_PD:
+	    if (is_min)
+	      REDUCE (pd, uq, <);
+	    else
+	      REDUCE (pd, uq, >);
+	    vm->fregs[instr.fvar.rd] = d.pd[0];
+	    break;
+	  default:
+	    return false;
+	  }
+	return true;
+      }
+    case VEC_MASK:
+      switch (type)
+	{
+	  INT_CASES (SIGN_BITS, 0);
+	  FLOAT_CASES (SIGN_BITS, 0);
+	default:
+	  return false;
+	}
+      return true;
+    case VEC_GET:
+      switch (type)
+	{
+	  INT_CASES (INT_GET, 0);
+	  FLOAT_CASES (FLOAT_GET, 0);
+	default:
+	  return false;
+	}
+      return true;
+    case VEC_SET:
+      switch (type)
+	{
+	  INT_CASES (LANE_SET, vm->iregs[instr.fvar.rs]);
+	  FLOAT_CASES (LANE_SET, vm->fregs[instr.fvar.rs]);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_ABS:
+      switch (type)
+	{
+	  INT_CASES (INT_ABS, 0);
+	  FLOAT_CASES (UNARY, fabs);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_SQRT:
+      switch (type)
+	{
+	  FLOAT_CASES (UNARY, sqrt);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_FLOOR:
+      switch (type)
+	{
+	  FLOAT_CASES (UNARY, floor);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_CEIL:
+      switch (type)
+	{
+	  FLOAT_CASES (UNARY, ceil);
+	default:
+	  return false;
+	}
+      break;
+    case VEC_ROUND:
+      switch (type)
+	{
+	  FLOAT_CASES (UNARY, round);
+	default:
+	  return false;
+	}
+      break;
+    default:
+      return false;
+    }
+  vm->vregs[instr.fvar.rd] = d;
+  return true;
+}
@@ -0,0 +1,171 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Client of rlvm --serve. Runs a program on the daemon and replays
+ * its captured output, or prints the daemon statistics.
+ */
+
+#include "serve.h"
+#include "hash.h"
+#include "getopt.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+int
+main (int argc, char **argv)
+{
+  bool stats = false;
+  int c;
+  while ((c = getopt (argc, argv, "Sh")) != -1)
+    switch (c)
+      {
+      case 'S':
+	stats = true;
+	break;
+      case 'h':
+      print_help_msg:
+	printf ("Usage: rlvmc [options] socket [program.bin [input]]\n"
+		"Options:\n"
+		"  -S    Prints the statistics of the daemon\n"
+		"  -h    Displays help\n"
+		"\n"
+		"The program reads input (or stdin if input is -) and its\n"
+		"output is replayed on stdout and stderr. The exit code is\n"
+		"the state of the program, same as rlvm -r.\n");
+	return 1;
+      default:
+	goto print_help_msg;
+      }
+  if (argc - optind < (stats ? 1 : 2))
+    goto print_help_msg;
+
+  const int fd = serve_connect (argv[optind]);
+  if (fd < 0)
+    {
+      fprintf (stderr, "error: failed to connect to %s\n", argv[optind]);
+      return 2;
+    }
+
+  serve_reply_t reply;
+  if (stats)
+    {
+      if (!serve_stats (fd, &reply))
+	{
+	  fprintf (stderr, "error: lost connection to daemon\n");
+	  return 2;
+	}
+      fputs (reply.out, stdout);
+      clean_serve_reply (&reply);
+      close (fd);
+      return 0;
+    }
+
+  FILE *f = fopen (argv[optind + 1], "rb");
+  if (f == NULL)
+    {
+      fprintf (stderr, "error: failed to read file %s\n", argv[optind + 1]);
+      return 2;
+    }
+  size_t code_len;
+  char *code = serve_slurp (f, &code_len);
+  fclose (f);
+  if (code == NULL)
+    {
+      fprintf (stderr, "error: out of memory reading %s\n",
+	       argv[optind + 1]);
+      return 2;
+    }
+
+  size_t input_len = 0;
+  char *input = NULL;
+  if (argc - optind > 2)
+    {
+      const char *path = argv[optind + 2];
+      f = strcmp (path, "-") == 0 ? stdin : fopen (path, "rb");
+      if (f == NULL)
+	{
+	  fprintf (stderr, "error: failed to read file %s\n", path);
+	  return 2;
+	}
+      input = serve_slurp (f, &input_len);
+      if (f != stdin)
+	fclose (f);
+      if (input == NULL)
+	{
+	  fprintf (stderr, "error: out of memory reading %s\n", path);
+	  return 2;
+	}
+    }
+
+  /* Try the cache first, only ship the bytecode when it is missing */
+  const uint64_t hash = hash_xxh64 (code, code_len, 0);
+  bool ok = serve_run (fd, hash, NULL, 0, input, input_len, &reply);
+  if (ok && reply.head.status == SERVE_MISS)
+    {
+      clean_serve_reply (&reply);
+      ok = serve_run (fd, hash, code, code_len, input, input_len, &reply);
+    }
+  free (code);
+  free (input);
+  close (fd);
+  if (!ok)
+    {
+      fprintf (stderr, "error: lost connection to daemon\n");
+      return 2;
+    }
+  switch (reply.head.status)
+    {
+    case SERVE_OK:
+      break;
+    case SERVE_TIMEOUT:
+      fprintf (stderr, "error: program ran past the time limit of the "
+	       "daemon\n");
+      clean_serve_reply (&reply);
+      return 3;
+    case SERVE_CRASHED:
+      fprintf (stderr, "error: program crashed (signal %" PRIu64 ")\n",
+	       reply.head.uid);
+      clean_serve_reply (&reply);
+      return 3;
+    default:
+      fprintf (stderr, "error: daemon rejected the program (status %"
+	       PRIu64 ")\n", reply.head.status);
+      clean_serve_reply (&reply);
+      return 3;
+    }
+  fwrite (reply.out, 1, reply.head.out_len, stdout);
+  fwrite (reply.err, 1, reply.head.err_len, stderr);
+  const int ret = reply.head.state;
+  clean_serve_reply (&reply);
+  return ret;
+}
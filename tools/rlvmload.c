@@ -0,0 +1,194 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2016 Paul Teng
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Load generator for rlvm --serve. Keeps a number of connections
+ * busy running the same program and reports client side latency
+ * next to the statistics of the daemon.
+ */
+
+#include "serve.h"
+#include "hash.h"
+#include "getopt.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif /* !__cplusplus */
+
+typedef struct load_t
+{
+  const char *sock;
+  const char *code;
+  size_t code_len;
+  const char *input;
+  size_t input_len;
+  uint64_t hash;
+  size_t total;
+  size_t next;			/* Next request to issue (atomic) */
+  size_t failed;		/* Transport errors and rejections (atomic) */
+  size_t unclean;		/* Programs not ending CLEAN (atomic) */
+  uint64_t *latency;		/* Nanoseconds, one per request */
+} load_t;
+
+static void *
+client_main (void *arg)
+{
+  load_t *load = arg;
+  const int fd = serve_connect (load->sock);
+  size_t i;
+  while ((i = __sync_fetch_and_add (&load->next, 1)) < load->total)
+    {
+      if (fd < 0)
+	{
+	  __sync_fetch_and_add (&load->failed, 1);
+	  continue;
+	}
+      serve_reply_t reply;
+      const uint64_t start = serve_now_ns ();
+      bool ok = serve_run (fd, load->hash, NULL, 0, load->input,
+			   load->input_len, &reply);
+      if (ok && reply.head.status == SERVE_MISS)
+	{
+	  clean_serve_reply (&reply);
+	  ok = serve_run (fd, load->hash, load->code, load->code_len,
+			  load->input, load->input_len, &reply);
+	}
+      load->latency[i] = serve_now_ns () - start;
+      if (!ok || reply.head.status != SERVE_OK)
+	__sync_fetch_and_add (&load->failed, 1);
+      else if (reply.head.state != CLEAN)
+	__sync_fetch_and_add (&load->unclean, 1);
+      if (ok)
+	clean_serve_reply (&reply);
+    }
+  if (fd >= 0)
+    close (fd);
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  size_t total = 1000;
+  size_t conns = 4;
+  int c;
+  while ((c = getopt (argc, argv, "n:c:h")) != -1)
+    switch (c)
+      {
+      case 'n':
+	total = strtoul (optarg, NULL, 10);
+	break;
+      case 'c':
+	conns = strtoul (optarg, NULL, 10);
+	break;
+      case 'h':
+      print_help_msg:
+	printf ("Usage: rlvmload [options] socket program.bin [input]\n"
+		"Options:\n"
+		"  -n N  Number of requests (default 1000)\n"
+		"  -c N  Number of concurrent connections (default 4)\n"
+		"  -h    Displays help\n");
+	return 1;
+      default:
+	goto print_help_msg;
+      }
+  if (argc - optind < 2 || total == 0 || conns == 0)
+    goto print_help_msg;
+
+  load_t load = {.sock = argv[optind],.input = NULL,.input_len =
+      0,.total = total,.next = 0,.failed = 0,.unclean = 0
+  };
+  FILE *f = fopen (argv[optind + 1], "rb");
+  if (f == NULL)
+    {
+      fprintf (stderr, "error: failed to read file %s\n", argv[optind + 1]);
+      return 2;
+    }
+  load.code = serve_slurp (f, &load.code_len);
+  fclose (f);
+  if (load.code == NULL)
+    {
+      fprintf (stderr, "error: out of memory reading %s\n",
+	       argv[optind + 1]);
+      return 2;
+    }
+  if (argc - optind > 2)
+    {
+      if ((f = fopen (argv[optind + 2], "rb")) == NULL)
+	{
+	  fprintf (stderr, "error: failed to read file %s\n",
+		   argv[optind + 2]);
+	  return 2;
+	}
+      load.input = serve_slurp (f, &load.input_len);
+      fclose (f);
+      if (load.input == NULL)
+	{
+	  fprintf (stderr, "error: out of memory reading %s\n",
+		   argv[optind + 2]);
+	  return 2;
+	}
+    }
+  load.hash = hash_xxh64 (load.code, load.code_len, 0);
+  load.latency = calloc (total, sizeof (uint64_t));
+
+  pthread_t threads[conns];
+  size_t i;
+  const uint64_t start = serve_now_ns ();
+  for (i = 0; i < conns; ++i)
+    pthread_create (&threads[i], NULL, client_main, &load);
+  for (i = 0; i < conns; ++i)
+    pthread_join (threads[i], NULL);
+  const double wall = (serve_now_ns () - start) / 1e9;
+
+  qsort (load.latency, total, sizeof (uint64_t), serve_cmp_u64);
+#define PCT(p) (load.latency[(total - 1) * (p) / 100] / 1e3)
+  printf ("requests: %zu over %zu connections in %.3f s (%.0f req/s)\n"
+	  "failed: %zu, not clean: %zu\n"
+	  "latency us: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+	  total, conns, wall, total / wall, load.failed, load.unclean,
+	  PCT (50), PCT (90), PCT (99), PCT (100));
+#undef PCT
+
+  const int fd = serve_connect (load.sock);
+  serve_reply_t reply;
+  if (fd >= 0 && serve_stats (fd, &reply))
+    {
+      printf ("daemon: %s", reply.out);
+      clean_serve_reply (&reply);
+    }
+  if (fd >= 0)
+    close (fd);
+  free ((char *) load.code);
+  free ((char *) load.input);
+  free (load.latency);
+  return load.failed == 0 ? 0 : 4;
+}